@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Times benchmarks and collects their results. A benchmark is a function doing a batch of operations
+ * and returning how many it did. Batches are repeated until min_seconds have passed, this is done
+ * a few times and the fastest repetition is reported (the least disturbed by the rest of the system)
+ */
+class BenchmarkRunner {
+public:
+    struct config_t {
+        double min_seconds = 0.2;
+        unsigned repetitions = 3;
+        // Only benchmarks with names containing it are run
+        std::string filter;
+    };
+
+    struct result_t {
+        std::string name;
+        uint64_t operations;
+        double seconds;
+        double ns_per_operation;
+        double operations_per_second;
+        // Additional metrics, e.g. emulated frames per second
+        std::map<std::string, double> counters;
+    };
+
+public:
+    BenchmarkRunner(const config_t &config);
+    ~BenchmarkRunner();
+    bool is_selected(const std::string &name);
+    /**
+     * Returns the result, so counters can be added to it, or nullptr if the benchmark isn't selected
+     */
+    result_t *run(const std::string &name, const std::function<uint64_t()> &batch);
+    /**
+     * For benchmarks that do their own timing
+     */
+    void add_result(const result_t &result);
+    inline const config_t &get_config() {return config;};
+    inline const std::vector<result_t> &get_results() {return results;};
+    void print_table(std::ostream &output);
+    void write_JSON(std::ostream &output);
+
+private:
+    config_t config;
+    std::vector<result_t> results;
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "benchmark_runner.h"
+
+/**
+ * Instructions of each opcode class executed straight through CPU::cpu_exec_op (no fetching, no timing)
+ */
+void run_CPU_benchmarks(BenchmarkRunner &runner);
+/**
+ * Bus::read and Bus::write of every address region, with a MBC1 cartridge inserted
+ */
+void run_bus_benchmarks(BenchmarkRunner &runner);
+/**
+ * PPU::render_current_screen_line of a line with the background only and with 10 objects on it
+ */
+void run_PPU_benchmarks(BenchmarkRunner &runner);
+/**
+ * The timer is only touched when its registers are accessed or the overflow event is due,
+ * so these measure exactly that and the cost of advancing the master clock
+ */
+void run_timer_benchmarks(BenchmarkRunner &runner);
+/**
+ * Whole frames of a built-in ROM and of the given ROM files (missing ones are skipped)
+ */
+void run_frame_benchmarks(BenchmarkRunner &runner, const std::vector<std::string> &ROM_paths);
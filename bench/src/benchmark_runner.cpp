@@ -0,0 +1,112 @@
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include "benchmark_runner.h"
+
+BenchmarkRunner::BenchmarkRunner(const config_t &config): config(config) {
+    if (this->config.repetitions == 0) {
+        this->config.repetitions = 1;
+    }
+}
+
+BenchmarkRunner::~BenchmarkRunner() {
+
+}
+
+bool BenchmarkRunner::is_selected(const std::string &name) {
+    return name.find(config.filter) != std::string::npos;
+}
+
+BenchmarkRunner::result_t *BenchmarkRunner::run(const std::string &name, const std::function<uint64_t()> &batch) {
+    if (!is_selected(name)) {
+        return nullptr;
+    }
+    // Warm up caches and branch predictors
+    batch();
+    result_t best = {name, 0, 0, 0, 0, {}};
+    for (unsigned repetition = 0; repetition < config.repetitions; ++repetition) {
+        uint64_t operations = 0;
+        double seconds = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (seconds < config.min_seconds) {
+            operations += batch();
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        double operations_per_second = operations / seconds;
+        if (operations_per_second > best.operations_per_second) {
+            best.operations = operations;
+            best.seconds = seconds;
+            best.operations_per_second = operations_per_second;
+            best.ns_per_operation = seconds * 1e9 / operations;
+        }
+    }
+    results.push_back(best);
+    return &results.back();
+}
+
+void BenchmarkRunner::add_result(const result_t &result) {
+    results.push_back(result);
+}
+
+void BenchmarkRunner::print_table(std::ostream &output) {
+    char line[256];
+    snprintf(line, sizeof(line), "%-40s %14s %12s\n", "benchmark", "ops/s", "ns/op");
+    output << line;
+    for (const result_t &result: results) {
+        snprintf(line, sizeof(line), "%-40s %14.0f %12.2f", result.name.c_str(), result.operations_per_second, result.ns_per_operation);
+        output << line;
+        for (const auto &counter: result.counters) {
+            snprintf(line, sizeof(line), "  %s=%.2f", counter.first.c_str(), counter.second);
+            output << line;
+        }
+        output << std::endl;
+    }
+}
+
+/**
+ * Names are generated by the benchmarks themselves (plain ASCII), except the ROM file names,
+ * so only quotes and backslashes need escaping
+ */
+static std::string escape_JSON(const std::string &text) {
+    std::string escaped;
+    for (char c: text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+void BenchmarkRunner::write_JSON(std::ostream &output) {
+    char timestamp[32];
+    time_t now = time(nullptr);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    #ifdef __OPTIMIZE__
+        const bool is_optimized = true;
+    #else
+        const bool is_optimized = false;
+    #endif
+    output.precision(17);
+    output << "{\n  \"context\": {\n"
+           << "    \"date\": \"" << timestamp << "\",\n"
+           << "    \"build_type\": \"" << escape_JSON(BUILD_TYPE) << "\",\n"
+           << "    \"optimized\": " << (is_optimized ? "true" : "false") << ",\n"
+           << "    \"min_seconds\": " << config.min_seconds << ",\n"
+           << "    \"repetitions\": " << config.repetitions << "\n"
+           << "  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const result_t &result = results[i];
+        output << (i == 0 ? "\n" : ",\n")
+               << "    {\"name\": \"" << escape_JSON(result.name) << "\", "
+               << "\"operations\": " << result.operations << ", "
+               << "\"seconds\": " << result.seconds << ", "
+               << "\"ns_per_operation\": " << result.ns_per_operation << ", "
+               << "\"operations_per_second\": " << result.operations_per_second;
+        for (const auto &counter: result.counters) {
+            output << ", \"" << escape_JSON(counter.first) << "\": " << counter.second;
+        }
+        output << "}";
+    }
+    output << "\n  ]\n}" << std::endl;
+}
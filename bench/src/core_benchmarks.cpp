@@ -0,0 +1,337 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include "core_benchmarks.h"
+#include "game_boy.h"
+#include "null_logger.h"
+
+// Repeated operations per call of a batch, big enough for the timing overhead not to matter
+static const unsigned BATCH_SIZE = 4096;
+static const unsigned FRAMES_IN_BATCH = 10;
+
+// Results are summed into it, so the compiler can't drop the measured calls
+static volatile uint64_t sink;
+
+/**
+ * CPU with its opcode handler exposed. Registers point to work RAM, so memory operands
+ * and the stack never touch the cartridge or IO
+ */
+class BenchCPU: public CPU {
+public:
+    BenchCPU(Bus &bus, Logger &logger): CPU(bus, logger) {};
+    inline int exec_op(instruction_t instruction) {return cpu_exec_op(instruction);};
+    void reset_registers() {
+        regA = 0x12;
+        flags_reg.value = 0x00;
+        _regBC.value = 0xC100;
+        _regDE.value = 0xC200;
+        _regHL.value = 0xC300;
+        _regSP.value = 0xDFF0;
+        _regPC.value = 0x0150;
+    };
+};
+
+struct opcode_class_t {
+    const char *name;
+    std::vector<instruction_t> instructions;
+};
+
+static instruction_t op(uint8_t operation, uint8_t param1 = 0, uint8_t param2 = 0) {
+    instruction_t instruction;
+    instruction.fields.operation = operation;
+    instruction.fields.param1 = param1;
+    instruction.fields.param2 = param2;
+    return instruction;
+}
+
+/**
+ * Every class keeps HL, BC, DE and SP pointing to work RAM or doesn't access memory through them.
+ * Calls are followed by a return and pushes by a pop, so the stack stays balanced
+ */
+static std::vector<opcode_class_t> make_opcode_classes() {
+    const unsigned REG_HL_INDIRECT = 6;
+    std::vector<opcode_class_t> classes;
+
+    classes.push_back({"nop", {op(0x00)}});
+
+    opcode_class_t LD_reg_reg = {"ld_r_r", {}};
+    for (unsigned opcode = 0x40; opcode <= 0x7F; ++opcode) {
+        if (((opcode >> 3) & 0x7) != REG_HL_INDIRECT && (opcode & 0x7) != REG_HL_INDIRECT) {
+            LD_reg_reg.instructions.push_back(op(opcode));
+        }
+    }
+    classes.push_back(LD_reg_reg);
+
+    classes.push_back({"ld_mem", {
+        op(0x0A), op(0x1A), op(0x02), op(0x12), op(0x7E), op(0x77), op(0x46), op(0x70), op(0x36, 0x5A),
+        op(0x22), op(0x3A), op(0x2A), op(0x32), op(0xF0, 0x80), op(0xE0, 0x80), op(0xFA, 0x00, 0xC4), op(0xEA, 0x00, 0xC4)
+    }});
+
+    opcode_class_t ALU_8bit = {"alu8", {}};
+    for (unsigned opcode = 0x80; opcode <= 0xBF; ++opcode) {
+        ALU_8bit.instructions.push_back(op(opcode));
+    }
+    for (uint8_t opcode: {0xC6, 0xCE, 0xD6, 0xDE, 0xE6, 0xEE, 0xF6, 0xFE}) {
+        ALU_8bit.instructions.push_back(op(opcode, 0x5A));
+    }
+    for (uint8_t opcode: {0x04, 0x05, 0x0C, 0x0D, 0x14, 0x15, 0x1C, 0x1D, 0x3C, 0x3D, 0x34, 0x35,
+                          0x27, 0x2F, 0x37, 0x3F, 0x07, 0x0F, 0x17, 0x1F}) {
+        ALU_8bit.instructions.push_back(op(opcode));
+    }
+    classes.push_back(ALU_8bit);
+
+    classes.push_back({"alu16", {
+        op(0x03), op(0x13), op(0x23), op(0x0B), op(0x1B), op(0x2B), op(0x33), op(0x3B),
+        op(0x09), op(0x19), op(0x29), op(0x39), op(0xE8, 0x00), op(0xF8, 0x05),
+        op(0x01, 0x00, 0xC1), op(0x11, 0x00, 0xC2), op(0x21, 0x00, 0xC3), op(0x08, 0x00, 0xC4)
+    }});
+
+    opcode_class_t extended = {"cb", {}};
+    for (unsigned opcode = 0x00; opcode <= 0xFF; ++opcode) {
+        unsigned reg_id = opcode & 0x7;
+        bool is_BIT = (opcode >= 0x40 && opcode <= 0x7F);
+        // Only BIT can be used on H and L, the rest would move HL out of work RAM
+        if ((reg_id == 4 || reg_id == 5) && !is_BIT) {
+            continue;
+        }
+        extended.instructions.push_back(op(0xCB, opcode));
+    }
+    classes.push_back(extended);
+
+    classes.push_back({"jumps", {
+        op(0xC3, 0x50, 0x01), op(0x18, 0x00), op(0x20, 0x00), op(0x28, 0x00), op(0x30, 0x00), op(0x38, 0x00),
+        op(0xC2, 0x50, 0x01), op(0xCA, 0x50, 0x01), op(0xD2, 0x50, 0x01), op(0xDA, 0x50, 0x01), op(0xE9),
+        op(0xCD, 0x50, 0x01), op(0xC9), op(0xC4, 0x50, 0x01), op(0xC0), op(0xCC, 0x50, 0x01), op(0xC8),
+        op(0xD4, 0x50, 0x01), op(0xD0), op(0xDC, 0x50, 0x01), op(0xD8), op(0xFF), op(0xC9)
+    }});
+
+    classes.push_back({"stack", {
+        op(0xC5), op(0xC1), op(0xD5), op(0xD1), op(0xE5), op(0xE1), op(0xF5), op(0xF1)
+    }});
+    return classes;
+}
+
+void run_CPU_benchmarks(BenchmarkRunner &runner) {
+    Bus bus;
+    NullLogger logger;
+    BenchCPU cpu(bus, logger);
+    for (const opcode_class_t &opcode_class: make_opcode_classes()) {
+        const std::vector<instruction_t> &instructions = opcode_class.instructions;
+        unsigned repeats = BATCH_SIZE / instructions.size() + 1;
+        uint64_t cycles = 0;
+        uint64_t executed = 0;
+        BenchmarkRunner::result_t *result = runner.run(std::string("cpu.") + opcode_class.name, [&]() {
+            cpu.reset_registers();
+            for (unsigned repeat = 0; repeat < repeats; ++repeat) {
+                for (const instruction_t &instruction: instructions) {
+                    cycles += cpu.exec_op(instruction);
+                }
+            }
+            executed += repeats * instructions.size();
+            return repeats * instructions.size();
+        });
+        if (result != nullptr) {
+            result->counters["cycles_per_instruction"] = static_cast<double>(cycles) / executed;
+        }
+    }
+}
+
+/**
+ * 32kB MBC1 ROM with 8kB of RAM. The program walks through work RAM incrementing every byte
+ * (with the LCD on, as left by the boot ROM)
+ */
+static std::vector<uint8_t> make_synthetic_ROM() {
+    std::vector<uint8_t> ROM(0x8000, 0x00);
+    const uint8_t program[] = {
+        0x21, 0x00, 0xC0, // 0x100: LD HL,0xC000
+        0x2A,             // 0x103: LD A,(HL+)
+        0x3C,             // INC A
+        0x77,             // LD (HL),A
+        0xCB, 0x6C,       // BIT 5,H (HL reached 0xE000)
+        0x28, 0xF9,       // JR Z,0x103
+        0x18, 0xF4        // JR 0x100
+    };
+    memcpy(&ROM[0x100], program, sizeof(program));
+    ROM[0x147] = 0x03; // MBC1 + RAM + battery
+    ROM[0x148] = 0x00; // 32kB
+    ROM[0x149] = 0x02; // 8kB RAM
+    return ROM;
+}
+
+void run_bus_benchmarks(BenchmarkRunner &runner) {
+    struct region_t {
+        const char *name;
+        uint16_t start;
+        uint16_t size;
+        // Writes to some regions have side effects, so only a part of them is written
+        uint16_t write_start;
+        uint16_t write_size;
+        uint8_t write_value;
+    };
+    const region_t regions[] = {
+        {"rom", 0x0000, 0x8000, 0x2000, 0x2000, 0x01}, // ROM bank number register
+        {"vram", 0x8000, 0x2000, 0x8000, 0x2000, 0x5A},
+        {"cart_ram", 0xA000, 0x2000, 0xA000, 0x2000, 0x5A},
+        {"wram", 0xC000, 0x2000, 0xC000, 0x2000, 0x5A},
+        {"echo", 0xE000, 0x1E00, 0xE000, 0x1E00, 0x5A},
+        {"oam", 0xFE00, 0x00A0, 0xFE00, 0x00A0, 0x5A},
+        {"io", 0xFF00, 0x0080, 0xFF42, 0x0002, 0x00}, // SCY and SCX
+        {"hram", 0xFF80, 0x007F, 0xFF80, 0x007F, 0x5A}
+    };
+    std::unique_ptr<GameBoy> game_boy(new GameBoy());
+    std::vector<uint8_t> ROM = make_synthetic_ROM();
+    game_boy->load_cartridge_from_memory(ROM.data(), ROM.size());
+    Bus &bus = game_boy->bus;
+    bus.write(0x0000, 0x0A); // Enable cartridge RAM
+
+    std::vector<uint16_t> addresses(BATCH_SIZE);
+    for (const region_t &region: regions) {
+        for (unsigned i = 0; i < BATCH_SIZE; ++i) {
+            addresses[i] = region.start + i % region.size;
+        }
+        runner.run(std::string("bus.read.") + region.name, [&]() {
+            uint64_t sum = 0;
+            for (uint16_t address: addresses) {
+                sum += bus.read(address);
+            }
+            sink = sink + sum;
+            return BATCH_SIZE;
+        });
+    }
+    for (const region_t &region: regions) {
+        for (unsigned i = 0; i < BATCH_SIZE; ++i) {
+            addresses[i] = region.write_start + i % region.write_size;
+        }
+        runner.run(std::string("bus.write.") + region.name, [&]() {
+            for (uint16_t address: addresses) {
+                bus.write(address, region.write_value);
+            }
+            return BATCH_SIZE;
+        });
+    }
+}
+
+void run_PPU_benchmarks(BenchmarkRunner &runner) {
+    const uint8_t LINE = 40;
+    const unsigned OBJ_COUNT = 10;
+    std::unique_ptr<GameBoy> game_boy(new GameBoy());
+    std::vector<uint8_t> ROM = make_synthetic_ROM();
+    game_boy->load_cartridge_from_memory(ROM.data(), ROM.size());
+    Bus &bus = game_boy->bus;
+    // Every tile and every background tile map entry differs
+    for (uint16_t address = 0x8000; address < 0x9800; ++address) {
+        bus.write(address, static_cast<uint8_t>(address * 37));
+    }
+    for (uint16_t address = 0x9800; address < 0x9C00; ++address) {
+        bus.write(address, static_cast<uint8_t>(address));
+    }
+    for (unsigned i = 0; i < OBJ_COUNT; ++i) {
+        uint16_t address = 0xFE00 + 4 * i;
+        bus.write(address, LINE + 16 - i % 8); // Y
+        bus.write(address + 1, 8 + 16 * i); // X
+        bus.write(address + 2, i + 1); // Tile
+        bus.write(address + 3, (i % 2) ? 0x20 : 0x00); // X flip every other one
+    }
+    bus.write(0xFF47, 0xE4); // BGP
+    bus.write(0xFF48, 0xE4); // OBP0
+    bus.write(0xFF40, 0x93); // LCD and objects on
+    // Run until the OAM search of the line is done, the rendering then repeats that line
+    while (bus.read(0xFF44) != LINE) {
+        game_boy->run_cycles(4);
+    }
+    game_boy->run_cycles(100);
+    if (bus.read(0xFF44) != LINE) {
+        throw std::runtime_error("PPU benchmark setup didn't stop at the expected line");
+    }
+    PPU &ppu = game_boy->ppu;
+    auto render_lines = [&]() {
+        for (unsigned i = 0; i < BATCH_SIZE; ++i) {
+            ppu.render_current_screen_line();
+        }
+        sink = sink + ppu.get_screen_pixels()[LINE * PPU::SCREEN_WIDTH];
+        return BATCH_SIZE;
+    };
+    runner.run("ppu.render_line.bg_obj", render_lines);
+    bus.write(0xFF40, 0x91); // Objects off
+    runner.run("ppu.render_line.bg", render_lines);
+}
+
+void run_timer_benchmarks(BenchmarkRunner &runner) {
+    // The bare bus has no PPU, so the timer is the only scheduled component
+    Bus bus;
+    Scheduler &scheduler = bus.scheduler;
+    Timer &timer = bus.io.timer;
+    timer.write(0xFF06, 0x00); // TMA
+    timer.write(0xFF07, 0x04); // Enabled, TIMA incremented every 1024 cycles
+
+    runner.run("timer.advance", [&]() {
+        for (unsigned i = 0; i < BATCH_SIZE; ++i) {
+            scheduler.advance(4);
+        }
+        return BATCH_SIZE;
+    });
+
+    timer.write(0xFF07, 0x05); // Every 16 cycles
+    runner.run("timer.read", [&]() {
+        uint64_t sum = 0;
+        for (unsigned i = 0; i < BATCH_SIZE; ++i) {
+            scheduler.advance(4);
+            sum += timer.read(0xFF04) + timer.read(0xFF05);
+        }
+        sink = sink + sum;
+        return 2 * BATCH_SIZE;
+    });
+
+    // TIMA overflows every 16 cycles
+    timer.write(0xFF06, 0xFF);
+    timer.write(0xFF05, 0xFF);
+    runner.run("timer.overflow", [&]() {
+        for (unsigned i = 0; i < BATCH_SIZE; ++i) {
+            scheduler.advance(16);
+        }
+        return BATCH_SIZE;
+    });
+}
+
+static void run_frame_benchmark(BenchmarkRunner &runner, const std::string &name, const std::vector<uint8_t> &ROM) {
+    if (!runner.is_selected(name)) {
+        return;
+    }
+    std::unique_ptr<GameBoy> game_boy(new GameBoy());
+    game_boy->load_cartridge_from_memory(ROM.data(), ROM.size());
+    uint64_t start_cycles = game_boy->get_cycles();
+    uint64_t start_instr_count = game_boy->cpu.get_executed_instr_count();
+    uint64_t frames = 0;
+    BenchmarkRunner::result_t *result = runner.run(name, [&]() {
+        game_boy->run_frames(FRAMES_IN_BATCH);
+        frames += FRAMES_IN_BATCH;
+        return FRAMES_IN_BATCH;
+    });
+    // Averaged over all frames, including the warm up batch
+    double cycles_per_frame = static_cast<double>(game_boy->get_cycles() - start_cycles) / frames;
+    double instrs_per_frame = static_cast<double>(game_boy->cpu.get_executed_instr_count() - start_instr_count) / frames;
+    result->counters["mips"] = result->operations_per_second * instrs_per_frame / 1e6;
+    result->counters["realtime_factor"] = result->operations_per_second * cycles_per_frame / GameBoy::CLOCK_SPEED_HZ;
+}
+
+void run_frame_benchmarks(BenchmarkRunner &runner, const std::vector<std::string> &ROM_paths) {
+    run_frame_benchmark(runner, "frame.synthetic", make_synthetic_ROM());
+    for (const std::string &path: ROM_paths) {
+        std::string name = path.substr(path.find_last_of('/') + 1);
+        name = "frame." + name.substr(0, name.rfind(".gb"));
+        std::ifstream file(path, std::ios::binary);
+        if (!file.good()) {
+            std::cerr << "Skipping " << name << ": cannot open " << path << std::endl;
+            continue;
+        }
+        std::vector<uint8_t> ROM((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        try {
+            run_frame_benchmark(runner, name, ROM);
+        } catch (std::exception &e) {
+            std::cerr << "Skipping " << name << ": " << e.what() << std::endl;
+        }
+    }
+}
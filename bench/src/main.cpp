@@ -0,0 +1,95 @@
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "benchmark_runner.h"
+#include "core_benchmarks.h"
+
+struct options_t {
+    BenchmarkRunner::config_t config;
+    std::string JSON_path;
+    std::vector<std::string> ROM_paths;
+};
+
+void print_usage(const char *program_name) {
+    std::cerr << "Usage: " << program_name << " [options]" << std::endl
+              << "  --json <file>         Write the results as JSON (- for the standard output)" << std::endl
+              << "  --filter <text>       Run only benchmarks with names containing the text" << std::endl
+              << "  --min-time <seconds>  Minimal duration of each repetition (default 0.2)" << std::endl
+              << "  --repetitions <n>     Repetitions of each benchmark, the fastest is reported (default 3)" << std::endl
+              << "  --rom <file>          Measure whole frames of the ROM (can be repeated, default: bundled test ROMs)" << std::endl;
+}
+
+bool parse_options(int argc, char **argv, options_t &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (option == "--json" && has_value) {
+            options.JSON_path = argv[++i];
+        } else if (option == "--filter" && has_value) {
+            options.config.filter = argv[++i];
+        } else if (option == "--min-time" && has_value) {
+            options.config.min_seconds = std::stod(argv[++i]);
+        } else if (option == "--repetitions" && has_value) {
+            options.config.repetitions = std::stoul(argv[++i]);
+        } else if (option == "--rom" && has_value) {
+            options.ROM_paths.push_back(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    if (options.ROM_paths.empty()) {
+        const std::string ROMs_dir = TEST_ROMS_DIR;
+        options.ROM_paths = {
+            ROMs_dir + "/cpu_instrs/cpu_instrs.gb",
+            ROMs_dir + "/instr_timing/instr_timing.gb",
+            ROMs_dir + "/mem_timing/mem_timing.gb"
+        };
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    options_t options;
+    try {
+        if (!parse_options(argc, argv, options)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    } catch (std::exception &e) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    #ifndef __OPTIMIZE__
+        std::cerr << "Warning: benchmarking a build without optimizations (use -DCMAKE_BUILD_TYPE=Release)" << std::endl;
+    #endif
+
+    BenchmarkRunner runner(options.config);
+    try {
+        run_CPU_benchmarks(runner);
+        run_bus_benchmarks(runner);
+        run_PPU_benchmarks(runner);
+        run_timer_benchmarks(runner);
+        run_frame_benchmarks(runner, options.ROM_paths);
+    } catch (std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (options.JSON_path == "-") {
+        runner.print_table(std::cerr);
+        runner.write_JSON(std::cout);
+    } else {
+        runner.print_table(std::cout);
+        if (!options.JSON_path.empty()) {
+            std::ofstream file(options.JSON_path);
+            if (!file.good()) {
+                std::cerr << "Cannot open file: " << options.JSON_path << std::endl;
+                return 1;
+            }
+            runner.write_JSON(file);
+        }
+    }
+    return 0;
+}
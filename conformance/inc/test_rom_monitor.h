@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include "game_boy.h"
+
+/**
+ * Watches a running test ROM for its verdict. Blargg's ROMs print "Passed" or "Failed" through the serial port,
+ * the newer ones also report through cartridge RAM: signature DE B0 61 at 0xA001, status at 0xA000
+ * (0x80 while running, 0 - passed, anything else - failed) and zero terminated text from 0xA004.
+ * Serial bytes arrive on the thread running the machine, which should also call check
+ */
+class TestROMMonitor: public SerialListenerInterface {
+public:
+    enum verdict_t {
+        RUNNING = 0,
+        PASSED = 1,
+        FAILED = 2
+    };
+
+public:
+    TestROMMonitor();
+    ~TestROMMonitor();
+    void serial_byte_sent(uint8_t value);
+    /**
+     * Looks for the verdict in the serial output and in cartridge RAM. Once found, it doesn't change
+     */
+    verdict_t check(GameBoy &game_boy);
+    inline verdict_t get_verdict() {return verdict;};
+    /**
+     * Text printed by the ROM, from cartridge RAM if the verdict came from there
+     */
+    inline const std::string &get_output() {return output;};
+
+private:
+    static const uint16_t STATUS_ADDRESS = 0xA000;
+    static const uint16_t SIGNATURE_ADDRESS = 0xA001;
+    static const uint16_t TEXT_ADDRESS = 0xA004;
+    static const uint8_t STATUS_RUNNING = 0x80;
+    verdict_t verdict;
+    std::string output;
+
+private:
+    verdict_t check_memory(GameBoy &game_boy);
+};
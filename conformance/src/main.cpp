@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "game_boy.h"
+#include "test_rom_monitor.h"
+#include "batch/batch_runner.h"
+
+namespace fs = std::filesystem;
+
+struct options_t {
+    std::vector<std::string> paths;
+    unsigned threads = 0;
+    // Emulated time after which a ROM without a verdict counts as timed out
+    double max_seconds = 120;
+    std::string filter;
+    std::string JSON_path;
+};
+
+struct ROM_result_t {
+    std::string path;
+    std::string status;
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    double seconds = 0;
+    std::string output;
+};
+
+void print_usage(const char *program_name) {
+    std::cerr << "Usage: " << program_name << " [<rom or directory>...] [options]" << std::endl
+              << "  Runs all .gb files found (default: the gb-test-roms submodule) in parallel" << std::endl
+              << "  --threads <n>         Worker threads (default: all cores)" << std::endl
+              << "  --max-seconds <s>     Emulated seconds before a ROM times out (default 120)" << std::endl
+              << "  --filter <text>       Run only ROMs with paths containing the text" << std::endl
+              << "  --json <file>         Write the results as JSON" << std::endl;
+}
+
+bool parse_options(int argc, char **argv, options_t &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (option == "--threads" && has_value) {
+            options.threads = std::stoul(argv[++i]);
+        } else if (option == "--max-seconds" && has_value) {
+            options.max_seconds = std::stod(argv[++i]);
+        } else if (option == "--filter" && has_value) {
+            options.filter = argv[++i];
+        } else if (option == "--json" && has_value) {
+            options.JSON_path = argv[++i];
+        } else if (option.rfind("--", 0) == 0) {
+            return false;
+        } else {
+            options.paths.push_back(option);
+        }
+    }
+    if (options.paths.empty()) {
+        options.paths.push_back(TEST_ROMS_DIR);
+    }
+    return options.max_seconds > 0;
+}
+
+std::vector<std::string> find_ROMs(const options_t &options) {
+    std::vector<std::string> ROM_paths;
+    for (const std::string &path: options.paths) {
+        if (fs::is_directory(path)) {
+            for (const fs::directory_entry &entry: fs::recursive_directory_iterator(path)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".gb") {
+                    ROM_paths.push_back(entry.path().string());
+                }
+            }
+        } else if (fs::is_regular_file(path)) {
+            ROM_paths.push_back(path);
+        } else {
+            std::cerr << "Not found: " << path << std::endl;
+        }
+    }
+    std::sort(ROM_paths.begin(), ROM_paths.end());
+    ROM_paths.erase(std::remove_if(ROM_paths.begin(), ROM_paths.end(), [&options](const std::string &path) {
+        return path.find(options.filter) == std::string::npos;
+    }), ROM_paths.end());
+    return ROM_paths;
+}
+
+/**
+ * ROMs that refuse to run on the original Game Boy (CGB flag 0xC0 in the header)
+ */
+bool is_CGB_only(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    char CGB_flag = 0;
+    file.seekg(0x143);
+    file.read(&CGB_flag, 1);
+    return file.good() && static_cast<uint8_t>(CGB_flag) == 0xC0;
+}
+
+std::string escape_JSON(const std::string &text) {
+    std::string escaped;
+    for (char c: text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else if (static_cast<unsigned char>(c) < 0x20 || static_cast<unsigned char>(c) >= 0x7F) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void write_JSON(const std::string &file_path, const std::vector<ROM_result_t> &results, unsigned threads, double wall_seconds) {
+    std::ofstream file(file_path);
+    if (!file.good()) {
+        throw std::runtime_error("Cannot open file: " + file_path);
+    }
+    file.precision(17);
+    file << "{\n  \"threads\": " << threads << ",\n  \"wall_seconds\": " << wall_seconds << ",\n  \"roms\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ROM_result_t &result = results[i];
+        file << (i == 0 ? "\n" : ",\n")
+             << "    {\"path\": \"" << escape_JSON(result.path) << "\", "
+             << "\"status\": \"" << result.status << "\", "
+             << "\"cycles\": " << result.cycles << ", "
+             << "\"instructions\": " << result.instructions << ", "
+             << "\"seconds\": " << result.seconds << ", "
+             << "\"output\": \"" << escape_JSON(result.output) << "\"}";
+    }
+    file << "\n  ]\n}" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    options_t options;
+    try {
+        if (!parse_options(argc, argv, options)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    } catch (std::exception &e) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    std::vector<std::string> ROM_paths = find_ROMs(options);
+    if (ROM_paths.empty()) {
+        std::cerr << "No ROMs to run" << std::endl;
+        return 1;
+    }
+
+    BatchRunner runner(options.threads);
+    // Verdicts are checked between slices, every ~0.5 s of emulated time
+    runner.set_slice(BatchRunner::slice_unit_t::SLICE_CYCLES, 30 * GameBoy::FRAME_CYCLES);
+    std::vector<ROM_result_t> results(ROM_paths.size());
+    std::vector<std::unique_ptr<TestROMMonitor>> monitors;
+    // Instance ids of the ROMs that are run
+    std::vector<size_t> ROM_indices;
+    for (size_t i = 0; i < ROM_paths.size(); ++i) {
+        results[i].path = ROM_paths[i];
+        if (is_CGB_only(ROM_paths[i])) {
+            results[i].status = "skipped";
+            results[i].output = "Game Boy Color only";
+            continue;
+        }
+        monitors.push_back(std::make_unique<TestROMMonitor>());
+        TestROMMonitor *monitor = monitors.back().get();
+        BatchRunner::instance_config_t config;
+        config.ROM_path = ROM_paths[i];
+        config.cycle_limit = static_cast<uint64_t>(options.max_seconds * GameBoy::CLOCK_SPEED_HZ);
+        config.render_mode = render_mode_t::RENDER_TIMING_ONLY;
+        config.is_done = [monitor](GameBoy &game_boy) {
+            return monitor->check(game_boy) != TestROMMonitor::verdict_t::RUNNING;
+        };
+        size_t id = runner.add_instance(config);
+        runner.get_instance(id).bus.io.attach_serial_listener(monitor);
+        ROM_indices.push_back(i);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    runner.run([&](const BatchRunner::result_t &result, GameBoy &) {
+        // Every instance is finished exactly once and writes only its own entry
+        ROM_result_t &ROM_result = results[ROM_indices[result.instance_id]];
+        TestROMMonitor &monitor = *monitors[result.instance_id];
+        ROM_result.cycles = result.cycles;
+        ROM_result.instructions = result.instructions;
+        ROM_result.seconds = result.seconds;
+        ROM_result.output = monitor.get_output();
+        if (!result.error.empty()) {
+            ROM_result.status = "error";
+            ROM_result.output = result.error;
+        } else if (monitor.get_verdict() == TestROMMonitor::verdict_t::PASSED) {
+            ROM_result.status = "passed";
+        } else if (monitor.get_verdict() == TestROMMonitor::verdict_t::FAILED) {
+            ROM_result.status = "failed";
+        } else {
+            ROM_result.status = "timeout";
+        }
+    });
+    double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::map<std::string, unsigned> status_counts;
+    for (const ROM_result_t &result: results) {
+        ++status_counts[result.status];
+        std::string path = result.path;
+        if (path.rfind(TEST_ROMS_DIR, 0) == 0) {
+            path = path.substr(strlen(TEST_ROMS_DIR) + 1);
+        }
+        printf("%-8s %-48s %12llu cycles %8.2f s emulated %8.3f s\n", result.status.c_str(), path.c_str(),
+            (unsigned long long)result.cycles, static_cast<double>(result.cycles) / GameBoy::CLOCK_SPEED_HZ, result.seconds);
+        if (result.status != "passed" && result.status != "skipped" && !result.output.empty()) {
+            // Output of the ROM, indented under its line
+            std::string output = result.output.substr(0, result.output.find_last_not_of("\n ") + 1);
+            for (size_t i = output.find('\n'); i != std::string::npos; i = output.find('\n', i + 1)) {
+                output.insert(i + 1, "         ");
+            }
+            printf("         %s\n", output.c_str());
+        }
+    }
+    printf("%u passed, %u failed, %u timed out, %u errors, %u skipped in %.2f s on %u threads\n", status_counts["passed"],
+        status_counts["failed"], status_counts["timeout"], status_counts["error"], status_counts["skipped"],
+        wall_seconds, runner.get_thread_count());
+
+    if (!options.JSON_path.empty()) {
+        try {
+            write_JSON(options.JSON_path, results, runner.get_thread_count(), wall_seconds);
+        } catch (std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    return (status_counts["passed"] + status_counts["skipped"] == results.size()) ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+#include "test_rom_monitor.h"
+
+TestROMMonitor::TestROMMonitor() {
+    verdict = verdict_t::RUNNING;
+}
+
+TestROMMonitor::~TestROMMonitor() {
+
+}
+
+void TestROMMonitor::serial_byte_sent(uint8_t value) {
+    if (verdict == verdict_t::RUNNING) {
+        output += static_cast<char>(value);
+    }
+}
+
+TestROMMonitor::verdict_t TestROMMonitor::check(GameBoy &game_boy) {
+    if (verdict != verdict_t::RUNNING) {
+        return verdict;
+    }
+    verdict = check_memory(game_boy);
+    if (verdict == verdict_t::RUNNING) {
+        if (output.find("Passed") != std::string::npos) {
+            verdict = verdict_t::PASSED;
+        } else if (output.find("Failed") != std::string::npos) {
+            verdict = verdict_t::FAILED;
+        }
+    }
+    return verdict;
+}
+
+TestROMMonitor::verdict_t TestROMMonitor::check_memory(GameBoy &game_boy) {
+    Bus &bus = game_boy.bus;
+    if (bus.read(SIGNATURE_ADDRESS) != 0xDE || bus.read(SIGNATURE_ADDRESS + 1) != 0xB0 || bus.read(SIGNATURE_ADDRESS + 2) != 0x61) {
+        return verdict_t::RUNNING;
+    }
+    uint8_t status = bus.read(STATUS_ADDRESS);
+    if (status == STATUS_RUNNING) {
+        return verdict_t::RUNNING;
+    }
+    output.clear();
+    for (uint16_t address = TEXT_ADDRESS; address < 0xC000; ++address) {
+        char c = static_cast<char>(bus.read(address));
+        if (c == 0) {
+            break;
+        }
+        output += c;
+    }
+    return (status == 0) ? verdict_t::PASSED : verdict_t::FAILED;
+}
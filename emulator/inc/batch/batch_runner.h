@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "game_boy.h"
+#include "batch/work_stealing_pool.h"
+
+/**
+ * Runs many independent GameBoy instances on all cores. Each instance is executed in short slices
+ * (a number of frames or cycles), after which it's queued again, so all of them advance at a similar pace
+ */
+class BatchRunner {
+public:
+    enum slice_unit_t {
+        SLICE_FRAMES = 0,
+        SLICE_CYCLES = 1
+    };
+
+    struct instance_config_t {
+        // Empty path - no cartridge
+        std::string ROM_path;
+        // Loaded instead of ROM_path when not empty
+        std::vector<uint8_t> ROM_image;
+        // Instance finishes after reaching any of the limits (0 - no limit). Limits are checked between slices
+        uint64_t frame_limit = 0;
+        uint64_t cycle_limit = 0;
+        render_mode_t render_mode = render_mode_t::RENDER_ALL_FRAMES;
+        // Used with RENDER_EVERY_NTH_FRAME
+        unsigned render_frame_interval = 1;
+        // Called on a worker thread before every slice, e.g. to apply scripted input
+        std::function<void(GameBoy &game_boy)> before_slice;
+        // Called on a worker thread after every slice, the instance finishes before its limits once it returns true
+        std::function<bool(GameBoy &game_boy)> is_done;
+    };
+
+    struct result_t {
+        size_t instance_id;
+        uint64_t frames;
+        uint64_t cycles;
+        uint64_t instructions;
+        // Time spent running the slices of the instance (without waiting in the queue)
+        double seconds;
+        // Empty if the instance ran without problems
+        std::string error;
+    };
+
+    /**
+     * Called on a worker thread once an instance is finished. GameBoy can be inspected (e.g. frame, RAM) inside
+     */
+    typedef std::function<void(const result_t &result, GameBoy &game_boy)> result_callback_t;
+
+public:
+    /**
+     * Thread count 0 means one worker per hardware thread
+     */
+    BatchRunner(unsigned thread_count = 0);
+    ~BatchRunner();
+    /**
+     * Creates an instance and loads its cartridge. Returns its id
+     */
+    size_t add_instance(const instance_config_t &config);
+    void set_slice(slice_unit_t unit, uint64_t size);
+    /**
+     * Runs all instances to their limits. Blocks until all of them are finished
+     */
+    void run(result_callback_t on_finished);
+    size_t get_instance_count();
+    GameBoy &get_instance(size_t instance_id);
+    unsigned get_thread_count();
+
+private:
+    struct instance_t {
+        instance_config_t config;
+        std::unique_ptr<GameBoy> game_boy;
+        result_t result;
+        uint64_t start_frame;
+        uint64_t start_cycle;
+        uint64_t start_instr_count;
+        // Frames run in frame slices. Differs from PPU frame count when LCD is off
+        uint64_t run_frame_count;
+        // Set once config.is_done returned true
+        bool is_done;
+    };
+
+    WorkStealingPool pool;
+    std::vector<std::unique_ptr<instance_t>> instances;
+    slice_unit_t slice_unit;
+    uint64_t slice_size;
+    result_callback_t on_finished;
+
+private:
+    void run_slice(instance_t &instance);
+    bool is_finished(instance_t &instance);
+    uint64_t get_frames_run(instance_t &instance);
+    void finish(instance_t &instance);
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Thread pool where every worker has its own task queue. Worker takes the newest task from the back of its own queue
+ * and when it runs out of them, it steals the oldest one from the front of the others' queues, so no core stays idle
+ * while there is still work somewhere. Tasks submitted from a worker go to that worker's queue
+ */
+class WorkStealingPool {
+public:
+    typedef std::function<void()> task_t;
+
+    /**
+     * Thread count 0 means one worker per hardware thread
+     */
+    WorkStealingPool(unsigned thread_count = 0);
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    ~WorkStealingPool();
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    void submit(task_t task);
+    /**
+     * Like submit, but the task is queued at the other end, so the worker runs it after all the tasks
+     * already in its queue (while thieves take it first). Used to take turns between long-running jobs
+     */
+    void submit_behind(task_t task);
+    /**
+     * Blocks until all submitted tasks (including ones submitted by tasks) are finished
+     */
+    void wait_idle();
+    unsigned get_thread_count();
+
+private:
+    struct worker_queue_t {
+        std::mutex mutex;
+        std::deque<task_t> tasks;
+    };
+
+    std::vector<std::unique_ptr<worker_queue_t>> queues;
+    std::vector<std::thread> threads;
+    // Tasks waiting in queues
+    std::atomic<size_t> queued_task_count;
+    // Tasks waiting in queues or being executed
+    std::atomic<size_t> pending_task_count;
+    std::atomic<unsigned> next_queue;
+    std::mutex state_mutex;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+    bool should_stop;
+
+private:
+    void push(task_t task, bool is_behind);
+    void worker_loop(unsigned worker_no);
+    bool try_pop(unsigned worker_no, task_t &task);
+    bool try_steal(unsigned worker_no, task_t &task);
+};
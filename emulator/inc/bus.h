@@ -1,13 +1,26 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include "cartridge/cartridge.h"
 #include "io/io.h"
 #include "memory/video_ram.h"
+#include "memory/work_ram.h"
+#include "memory/object_attribute_memory.h"
 #include "read_write_interface.h"
+#include "scheduler.h"
 
 class Bus: public ReadWriteInterface {
-    friend class GUI; // TODO: Remove?
+    friend class EmulationThread; // TODO: Remove?
+public:
+    /**
+     * Memory that isn't handled by any component, 0xFE00 - 0xFFFF (HRAM and the unusable area).
+     * Components and the cartridge have their own states
+     */
+    struct state_t {
+        uint8_t high_memory[0x200];
+    };
+
 public:
     Bus();
     Bus(const Bus&) = delete;
@@ -17,16 +30,40 @@ public:
     uint8_t read(uint16_t address);
     // void insert_cartridge(Cartridge* cartridge);
     void load_cartridge_from_file(std::string file_path);
+    /**
+     * Inserts a cartridge with a copy of the given ROM image (replacing the current one)
+     */
+    void load_cartridge_from_memory(const uint8_t *ROM_image, size_t image_size);
+    /**
+     * Inserts a fork of the other bus' cartridge (see Cartridge::fork). Without a cartridge
+     * the memory it would map (written by the tests and tools) is copied instead
+     */
+    void insert_forked_cartridge(Bus &other);
     // void remove_cartridge();
     bool get_is_cart_inserted();
+    /**
+     * Returns nullptr if there is no cartridge
+     */
+    Cartridge *get_cartridge();
+    /**
+     * Hash of the loaded ROM image (0 without a cartridge), identifies the game in save states
+     */
+    uint64_t get_ROM_hash();
+    void save_state(state_t &state);
+    void load_state(const state_t &state);
     // void tmp_dump();
     // void tmp_load();
+    Scheduler scheduler;
     IO io;
     VideoRAM vram;
+    WorkRAM wram;
+    ObjectAttributeMemory oam;
 
 protected:
     Cartridge *cartridge;
     bool is_cart_inserted;
+    uint64_t ROM_hash;
     uint8_t tmp_mem[0xFFFF+1];
     ReadWriteInterface *get_mem_access_handler(uint16_t address);
+    void exec_OAM_DMA(uint8_t source_high_byte);
 };
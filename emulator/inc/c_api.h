@@ -0,0 +1,96 @@
+#pragma once
+/*
+ * C interface of the emulator, meant for driving it from other languages.
+ * Frame and memory accessors return pointers straight into the emulator, nothing is copied.
+ * An instance may only be used by one thread at a time
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GB_API __attribute__((visibility("default")))
+
+#define GB_OK 0
+#define GB_ERROR -1
+
+#define GB_FRAMEBUFFER_WIDTH 256
+#define GB_FRAMEBUFFER_HEIGHT 256
+
+/* Bits of the button mask passed to gb_set_input, set bit means the button is pressed */
+#define GB_BUTTON_RIGHT (1 << 0)
+#define GB_BUTTON_LEFT (1 << 1)
+#define GB_BUTTON_UP (1 << 2)
+#define GB_BUTTON_DOWN (1 << 3)
+#define GB_BUTTON_A (1 << 4)
+#define GB_BUTTON_B (1 << 5)
+#define GB_BUTTON_START (1 << 6)
+#define GB_BUTTON_SELECT (1 << 7)
+
+typedef enum {
+    GB_MEMORY_WRAM = 0, /* 0xC000 - 0xDFFF */
+    GB_MEMORY_VRAM = 1, /* 0x8000 - 0x9FFF, read only, use gb_vram_write to change it */
+    GB_MEMORY_OAM = 2 /* 0xFE00 - 0xFE9F */
+} gb_memory_region_t;
+
+typedef enum {
+    GB_OBSERVATION_GRAYSCALE = 0, /* 160x144 gray levels */
+    GB_OBSERVATION_GRAYSCALE_RESIZED = 1, /* width x height gray levels */
+    GB_OBSERVATION_PACKED_2BIT = 2 /* 160x144 shades, 4 pixels per byte */
+} gb_observation_format_t;
+
+typedef struct gb_instance gb_t;
+
+/**
+ * Returns a new instance without a cartridge or NULL if it couldn't be created
+ */
+GB_API gb_t *gb_create(void);
+GB_API void gb_destroy(gb_t *gb);
+/**
+ * Inserts a cartridge with a copy of the ROM image and restarts the machine
+ */
+GB_API int gb_load_rom_mem(gb_t *gb, const uint8_t *ROM_image, size_t image_size);
+/**
+ * Runs until the given number of frames is finished (see GameBoy::run_frames)
+ */
+GB_API int gb_step_frames(gb_t *gb, unsigned frame_count);
+/**
+ * Sets the state of all buttons at once (GB_BUTTON_* mask)
+ */
+GB_API void gb_set_input(gb_t *gb, uint8_t pressed_buttons);
+/**
+ * Returns the most recent complete frame: GB_FRAMEBUFFER_WIDTH x GB_FRAMEBUFFER_HEIGHT shades
+ * (0 - white to 3 - black), one byte per pixel. The frame stays valid and unchanged until
+ * the next call to gb_framebuffer_ptr or gb_destroy
+ */
+GB_API const uint8_t *gb_framebuffer_ptr(gb_t *gb);
+/**
+ * Returns a pointer to the given memory region and its size. It's valid for the whole life of the instance
+ */
+GB_API uint8_t *gb_memory_ptr(gb_t *gb, gb_memory_region_t region, size_t *size);
+/**
+ * Copies size bytes to VRAM at the given offset from 0x8000. Unlike writes through gb_memory_ptr,
+ * this also updates the decoded tile cache the PPU draws from
+ */
+GB_API int gb_vram_write(gb_t *gb, size_t offset, const uint8_t *data, size_t size);
+/**
+ * Makes the instance keep the last stack_size observations of rendered frames (see ObservationStage).
+ * Replaces the previous configuration and its observations
+ */
+GB_API int gb_configure_observation(gb_t *gb, gb_observation_format_t format, unsigned width, unsigned height,
+    unsigned stack_size);
+/**
+ * Returns an observation by its age (0 - the newest one) and its size or NULL if observations aren't configured.
+ * The pointer is valid until the observation is replaced by the next frames
+ */
+GB_API const uint8_t *gb_observation_ptr(gb_t *gb, unsigned age, size_t *size);
+/**
+ * Returns the message of the last error reported by the instance (empty if there wasn't any)
+ */
+GB_API const char *gb_last_error(gb_t *gb);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <fstream>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include "read_write_interface.h"
@@ -8,9 +9,23 @@
 class Cartridge: public virtual ReadWriteInterface {
 public:
     virtual ~Cartridge() {};
-    virtual void load_from_file(std::ifstream &cart_file, unsigned file_size) = 0;
+    /**
+     * Copies the whole ROM image (starting at 0x0000)
+     */
+    virtual void load_from_memory(const uint8_t *ROM_image, unsigned image_size) = 0;
     virtual void write(uint16_t address, uint8_t value) = 0;
     virtual uint8_t read(uint16_t address) = 0;
     virtual uint8_t *get_raw_ROM_data() = 0;
     virtual unsigned get_raw_ROM_size() = 0;
+    /**
+     * Banking registers and RAM as one flat block (ROM isn't included)
+     */
+    virtual size_t get_state_size() = 0;
+    virtual void save_state(uint8_t *state) = 0;
+    virtual void load_state(const uint8_t *state) = 0;
+    /**
+     * Creates a copy of the cartridge for a forked machine. ROM is shared, RAM pages are shared
+     * until one of the cartridges writes to them
+     */
+    virtual Cartridge *fork() = 0;
 };
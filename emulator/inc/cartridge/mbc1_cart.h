@@ -1,18 +1,26 @@
 #pragma once
 #include <cstdint>
 #include <fstream>
+#include <memory>
 #include "cartridge/cartridge.h"
 #include "cartridge/cartridge_header.h"
+#include "memory/copy_on_write_memory.h"
 
 class MBC1Cart: public virtual Cartridge {
 public:
     MBC1Cart(cardridge_header_t &header);
+    MBC1Cart(const MBC1Cart &other) = default;
     ~MBC1Cart();
-    void load_from_file(std::ifstream &cart_file, unsigned file_size);
+    MBC1Cart& operator=(const MBC1Cart&) = delete;
+    void load_from_memory(const uint8_t *ROM_image, unsigned image_size);
     void write(uint16_t address, uint8_t value);
     uint8_t read(uint16_t address);
     uint8_t *get_raw_ROM_data();
     unsigned get_raw_ROM_size();
+    size_t get_state_size();
+    void save_state(uint8_t *state);
+    void load_state(const uint8_t *state);
+    Cartridge *fork();
 
 private:
     enum banking_mode_t {
@@ -20,15 +28,26 @@ private:
         RAM_BANKING_MODE = 1
     };
 
+    // Followed by the RAM in save states
+    struct banking_state_t {
+        bool RAM_enabled;
+        uint8_t selected_banking_mode;
+        uint32_t selected_ROM_bank_lower_bits;
+        uint32_t selected_RAM_bank_or_upper_ROM_bits;
+    };
+
 private:
     static const unsigned SINGLE_ROM_BANK_SIZE = 0x4000;
     static const unsigned SINGLE_RAM_BANK_SIZE = 0x2000;
-    uint8_t *ROM_data;
-    uint8_t *RAM_data;
+    std::shared_ptr<uint8_t[]> ROM_data;
+    CopyOnWriteMemory RAM_data;
     bool RAM_enabled;
     unsigned selected_ROM_bank_lower_bits;
     unsigned number_of_ROM_banks;
     unsigned number_of_RAM_banks;
     unsigned selected_RAM_bank_or_upper_ROM_bits;
     banking_mode_t selected_banking_mode;
+
+private:
+    static unsigned get_number_of_RAM_banks(cardridge_header_t &header);
 };
@@ -1,20 +1,30 @@
 #pragma once
 #include <cstdint>
 #include <fstream>
+#include <memory>
 #include "cartridge/cartridge.h"
 #include "cartridge/cartridge_header.h"
+#include "memory/copy_on_write_memory.h"
 
 class ROMOnlyCart: public virtual Cartridge {
 public:
     ROMOnlyCart();
+    ROMOnlyCart(const ROMOnlyCart &other) = default;
     ~ROMOnlyCart();
-    void load_from_file(std::ifstream &cart_file, unsigned file_size);
+    ROMOnlyCart& operator=(const ROMOnlyCart&) = delete;
+    void load_from_memory(const uint8_t *ROM_image, unsigned image_size);
     void write(uint16_t address, uint8_t value);
     uint8_t read(uint16_t address);
     uint8_t *get_raw_ROM_data();
     unsigned get_raw_ROM_size();
+    size_t get_state_size();
+    void save_state(uint8_t *state);
+    void load_state(const uint8_t *state);
+    Cartridge *fork();
 
 private:
     static const unsigned MEMORY_SIZE = 0x8000;
-    uint8_t data[MEMORY_SIZE];
+    static const unsigned RAM_SIZE = 0x2000;
+    std::shared_ptr<uint8_t[]> data;
+    CopyOnWriteMemory RAM;
 };
@@ -3,8 +3,23 @@
 #include "cpu/common.h"
 #include "bus.h"
 #include "logger.h"
+#if PROFILE_OPCODES == 1
+#include "cpu/opcode_profile.h"
+#endif
 
 class CPU {
+    friend class LockstepCPU;
+public:
+    // Registers and execution state, as kept in save states
+    struct state_t {
+        uint8_t A;
+        uint8_t F;
+        uint16_t BC, DE, HL, PC, SP;
+        bool is_halted;
+        bool is_stopped;
+        uint64_t executed_instr_count;
+    };
+
 public:
     CPU(Bus &bus, Logger &logger);
     ~CPU();
@@ -23,7 +38,17 @@ public:
     flags_reg_t get_flags_reg() {return flags_reg;}
     void restart();
     int exec_next_instr();
+    void run_until(uint64_t target_cycle);
     long get_clock_speed_Hz();
+    /**
+     * Returns the number of instructions executed by run_until since power on
+     */
+    uint64_t get_executed_instr_count() {return executed_instr_count;};
+    void save_state(state_t &state);
+    void load_state(const state_t &state);
+#if PROFILE_OPCODES == 1
+    OpcodeProfile &get_opcode_profile() {return opcode_profile;};
+#endif
 
 protected:
     struct __attribute__((packed)) extended_op_t {
@@ -39,8 +64,12 @@ protected:
     Bus &bus;
     Logger &logger;
     bool is_halted, is_stopped;
+    uint64_t executed_instr_count;
     const long CLOCK_SPEED_HZ = 4194304;
     const uint16_t INTERRUPT_PC_LOOKUP[5] = {0x40, 0x48, 0x50, 0x58, 0x60};
+#if PROFILE_OPCODES == 1
+    OpcodeProfile opcode_profile;
+#endif
 
 protected:
     uint8_t add8bit_with_flags(uint8_t val1, uint8_t val2, uint8_t carry);
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "game_boy.h"
+#include "cpu/lockstep_cpu.h"
+
+/**
+ * A way of executing instructions of one machine (the scalar interpreter, LockstepCPU, ...).
+ * All engines have to give exactly the same results, DifferentialChecker verifies it
+ */
+class CPUEngine {
+public:
+    virtual ~CPUEngine() {};
+    virtual std::string get_name() = 0;
+    virtual GameBoy &get_game_boy() = 0;
+    /**
+     * Runs the machine until its master clock reaches the given cycle, like CPU::run_until
+     * (so with the target one cycle ahead exactly one instruction is executed)
+     */
+    virtual void run_until(uint64_t target_cycle) = 0;
+};
+
+class ScalarCPUEngine: public CPUEngine {
+public:
+    ScalarCPUEngine(GameBoy &game_boy);
+    ~ScalarCPUEngine();
+    std::string get_name();
+    GameBoy &get_game_boy();
+    void run_until(uint64_t target_cycle);
+
+private:
+    GameBoy &game_boy;
+};
+
+/**
+ * LockstepCPU with a single lane
+ */
+class LockstepCPUEngine: public CPUEngine {
+public:
+    LockstepCPUEngine(GameBoy &game_boy);
+    ~LockstepCPUEngine();
+    std::string get_name();
+    GameBoy &get_game_boy();
+    void run_until(uint64_t target_cycle);
+
+private:
+    GameBoy &game_boy;
+    LockstepCPU lockstep_cpu;
+};
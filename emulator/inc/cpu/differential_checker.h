@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include "cpu/cpu_engine.h"
+
+/**
+ * Runs two engines side by side on two machines in the same state (same ROM, same input applied by the caller)
+ * and compares registers, flags, interrupt state and master clock after every step. A step is one instruction
+ * of the reference engine or, with block_cycles set, a block of that many cycles. The first divergence is kept
+ * with a disassembled window of the instructions that led to it
+ */
+class DifferentialChecker {
+public:
+    struct config_t {
+        // 0 - compare after every instruction
+        uint64_t block_cycles = 0;
+        // Instructions (or blocks) kept for the divergence report
+        unsigned context_size = 16;
+    };
+
+    struct machine_state_t {
+        uint64_t cycles;
+        CPU::state_t cpu;
+        Interrupts::state_t interrupts;
+    };
+
+    struct divergence_t {
+        // Steps that matched before the divergence
+        uint64_t step_no;
+        machine_state_t reference_state;
+        machine_state_t checked_state;
+        // Names of the values that differ, e.g. "A" or "cycles"
+        std::vector<std::string> differences;
+        // Disassembly of the steps leading to the divergence, the last one is the step that diverged
+        std::vector<std::string> context;
+    };
+
+public:
+    DifferentialChecker(CPUEngine &reference, CPUEngine &checked, const config_t &config);
+    ~DifferentialChecker();
+    /**
+     * Steps both engines until the reference reaches the target cycle. Returns false (and stops right after the step)
+     * as soon as they diverge. Machines have to be in the same state when this is called
+     */
+    bool run_until(uint64_t target_cycle);
+    inline bool has_diverged() {return is_diverged;};
+    inline uint64_t get_step_count() {return step_count;};
+    /**
+     * Valid only after a divergence
+     */
+    inline const divergence_t &get_divergence() {return divergence;};
+    /**
+     * Human readable description of the divergence
+     */
+    std::string get_report();
+    static void save_machine_state(GameBoy &game_boy, machine_state_t &state);
+
+private:
+    CPUEngine &reference;
+    CPUEngine &checked;
+    config_t config;
+    bool is_diverged;
+    uint64_t step_count;
+    std::deque<std::string> context;
+    divergence_t divergence;
+
+private:
+    std::string disassemble_at(GameBoy &game_boy, uint16_t address);
+    static std::vector<std::string> compare(const machine_state_t &reference_state, const machine_state_t &checked_state);
+    static std::string format_state(const machine_state_t &state);
+};
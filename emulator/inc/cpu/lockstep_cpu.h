@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "game_boy.h"
+
+/**
+ * Experimental. Runs up to MAX_LANES machines that execute the same program (e.g. copies of one ROM that
+ * differ only in input) and shares instruction decoding and dispatch between them.
+ * Registers of all lanes are kept as structure of arrays. Lanes about to execute the same bytes at the same PC
+ * form a group and every supported opcode is executed for the whole group at once with loops the compiler
+ * can vectorize. A lane that diverges simply ends up in another group until it meets the others again.
+ * Unsupported opcodes, halted lanes and lanes about to take an interrupt are stepped by their own scalar CPU.
+ * Instructions executed in lockstep are not passed to the lane's logger
+ */
+class LockstepCPU {
+public:
+    static const unsigned MAX_LANES = 16;
+
+    LockstepCPU(const std::vector<GameBoy *> &lanes);
+    ~LockstepCPU();
+    /**
+     * Runs every lane until its master clock reaches the given cycle (like CPU::run_until)
+     */
+    void run_until(uint64_t target_cycle);
+    unsigned get_lane_count();
+    /**
+     * Number of instructions executed for all lanes at once (counted once per lane) and by scalar CPUs
+     */
+    inline uint64_t get_lockstep_instr_count() {return lockstep_instr_count;};
+    inline uint64_t get_scalar_instr_count() {return scalar_instr_count;};
+
+private:
+    // Register indices as they are encoded in the opcodes. 6 means (HL) there, so it's unused here
+    enum reg8_no_t {
+        REG_B = 0,
+        REG_C = 1,
+        REG_D = 2,
+        REG_E = 3,
+        REG_H = 4,
+        REG_L = 5,
+        REG_A = 7
+    };
+
+    std::vector<GameBoy *> lanes;
+    unsigned lane_count;
+    alignas(64) uint8_t regs8[8][MAX_LANES];
+    alignas(64) uint8_t flags[MAX_LANES];
+    alignas(64) uint16_t regSP[MAX_LANES];
+    alignas(64) uint16_t regPC[MAX_LANES];
+    // 0xFF for lanes taking part in the current instruction, 0 for the others
+    alignas(64) uint8_t group_mask[MAX_LANES];
+    uint64_t lockstep_instr_count;
+    uint64_t scalar_instr_count;
+
+private:
+    void load_lane(unsigned lane_no);
+    void store_lane(unsigned lane_no);
+    bool can_run_lockstep(unsigned lane_no);
+    instruction_t fetch(unsigned lane_no, uint16_t address);
+    void exec_scalar(unsigned lane_no, uint64_t target_cycle);
+    /**
+     * Executes the instruction for all lanes in group_mask. Returns the number of clock cycles
+     * or 0 if the opcode is not supported (nothing is changed then)
+     */
+    int exec_lockstep(instruction_t instruction);
+    inline uint16_t get_reg16(unsigned pair_no, unsigned lane_no);
+    inline void set_reg16(unsigned pair_no, unsigned lane_no, uint16_t value);
+    void exec_ALU(unsigned op, const uint8_t *operand);
+    void exec_INC_DEC_8bit(unsigned reg_no, bool is_decrement);
+    void exec_INC_DEC_16bit(unsigned pair_no, bool is_decrement);
+    void exec_jump(unsigned condition, bool is_conditional, bool is_relative, instruction_t instruction);
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include "cpu/common.h"
+#include "cpu/regs.h"
+
+/**
+ * Execution counters of every opcode and CB prefixed opcode: how many times it was executed, cycles spent
+ * and, for conditional jumps, calls and returns, how many times the condition was met.
+ * CPU keeps one only when built with PROFILE_OPCODES (cmake -DPROFILE_OPCODES=ON), otherwise nothing is recorded
+ */
+class OpcodeProfile {
+public:
+    struct counter_t {
+        uint64_t count;
+        uint64_t cycles;
+        uint64_t taken;
+        uint64_t not_taken;
+    };
+
+public:
+    OpcodeProfile();
+    ~OpcodeProfile();
+    void reset();
+    /**
+     * Called after the instruction was executed. Conditional branches don't change the flags,
+     * so their condition is checked against the flags left after the execution
+     */
+    inline void record(instruction_t const &instruction, int cycles, flags_reg_t flags) {
+        uint8_t opcode = instruction.fields.operation;
+        counter_t &counter = (opcode == 0xCB) ? CB_counters[instruction.fields.param1] : counters[opcode];
+        ++counter.count;
+        counter.cycles += cycles;
+        if (is_conditional(opcode)) {
+            if (is_condition_met(opcode, flags)) {
+                ++counter.taken;
+            } else {
+                ++counter.not_taken;
+            }
+        }
+    }
+    inline const counter_t &get_counter(uint8_t opcode) {return counters[opcode];};
+    inline const counter_t &get_CB_counter(uint8_t opcode) {return CB_counters[opcode];};
+    /**
+     * Only executed opcodes are written. CSV has the header line
+     * prefix,opcode,count,cycles,taken,not_taken
+     */
+    void write_CSV(std::ostream &stream);
+    void write_JSON(std::ostream &stream);
+    /**
+     * Format is chosen by the extension, .json or anything else for CSV
+     */
+    void save_to_file(const std::string &file_path);
+    /**
+     * JR cc, JP cc, CALL cc and RET cc
+     */
+    static inline bool is_conditional(uint8_t opcode) {
+        return ((opcode & 0xE7) == 0x20) || ((opcode & 0xE1) == 0xC0 && (opcode & 0x06) != 0x06);
+    }
+
+private:
+    counter_t counters[256];
+    counter_t CB_counters[256];
+
+private:
+    /**
+     * Bits 3-4 of the opcode select NZ, Z, NC or C
+     */
+    static inline bool is_condition_met(uint8_t opcode, flags_reg_t flags) {
+        switch ((opcode >> 3) & 0x03) {
+            case 0: return !flags.flags.Z;
+            case 1: return flags.flags.Z;
+            case 2: return !flags.flags.C;
+            default: return flags.flags.C;
+        }
+    }
+};
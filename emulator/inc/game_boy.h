@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bus.h"
+#include "cpu/cpu.h"
+#include "ppu/ppu.h"
+#include "logger.h"
+#include "null_logger.h"
+
+class SaveStateWriter;
+class SaveStateReader;
+
+/**
+ * The whole machine in one self-contained object, without any frontend or global state.
+ * It's big (the whole address space lives inside), so it should be allocated on the heap
+ */
+class GameBoy {
+public:
+    // One frame takes 154 lines, 456 clock cycles each
+    static const uint64_t FRAME_CYCLES = 154 * 456;
+    static const uint64_t CLOCK_SPEED_HZ = 4194304;
+
+    /**
+     * Creates a machine that doesn't log anything
+     */
+    GameBoy();
+    GameBoy(Logger &logger);
+    GameBoy(const GameBoy&) = delete;
+    ~GameBoy();
+    GameBoy& operator=(const GameBoy&) = delete;
+    void load_cartridge_from_file(std::string file_path);
+    void load_cartridge_from_memory(const uint8_t *ROM_image, size_t image_size);
+    void restart();
+    /**
+     * Runs until the given number of frames is finished (VBlank entered). When the LCD is turned off,
+     * FRAME_CYCLES without VBlank count as a frame, so this always returns
+     */
+    void run_frames(unsigned frame_count);
+    void run_cycles(uint64_t cycle_count);
+    void set_button(Joypad::btn_type_t button, Joypad::btn_state_t state);
+    /**
+     * Sets the state of all buttons at once (bit n is Joypad::btn_type_t n, set bit means pressed).
+     * Only the buttons that changed since the last call are passed on, so holding a button
+     * doesn't repeat the joypad interrupt
+     */
+    void set_pressed_buttons(uint8_t button_mask);
+    inline uint64_t get_cycles() {return bus.scheduler.get_cycles();};
+    inline uint64_t get_frame_count() {return ppu.get_frame_count();};
+    /**
+     * Size of a save state of this machine (depends on the cartridge)
+     */
+    size_t get_state_size();
+    /**
+     * Saves the whole machine (see save_state.h). The buffer is resized if needed,
+     * so reusing it makes taking a state allocation free
+     */
+    void save_state(std::vector<uint8_t> &buffer);
+    /**
+     * Restores the machine from a save state made with the same ROM and version.
+     * Throws if it doesn't match (header and size are checked before anything is changed)
+     */
+    void load_state(const uint8_t *state, size_t size);
+    inline void load_state(const std::vector<uint8_t> &buffer) {load_state(buffer.data(), buffer.size());};
+    /**
+     * Creates a copy of the machine that continues from the same state. ROM and the unchanged pages
+     * of cartridge RAM are shared (see CopyOnWriteMemory), the rest is copied as save state blocks.
+     * Must not be called while this machine is running. The fork keeps the logger and render mode,
+     * but has no finished frame until its next VBlank
+     */
+    std::unique_ptr<GameBoy> fork();
+
+private:
+    struct state_t {
+        uint8_t pressed_buttons;
+    };
+
+private:
+    NullLogger null_logger;
+    // nullptr if null_logger is used
+    Logger *logger;
+    uint8_t pressed_buttons;
+
+private:
+    void save_state(state_t &state);
+    void load_state(const state_t &state);
+    /**
+     * All blocks except the cartridge, which is saved separately and shared by forks
+     */
+    size_t get_machine_state_size();
+    void write_machine_blocks(SaveStateWriter &writer);
+    void read_machine_blocks(SaveStateReader &reader);
+    void read_blocks(SaveStateReader &reader);
+    friend class SaveStateWriter;
+    friend class SaveStateReader;
+
+public:
+    Bus bus;
+    CPU cpu;
+    PPU ppu;
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * ROMs with the expected frame hashes at checkpoints. The file has one ROM per line:
+ * <rom> [input=<input script>] <frame>[=<hash>]...
+ * Paths are relative to the suite file, frame n (from 1) means the frame shown after n frames were emulated,
+ * hash is the hex FNV-1a hash of its pixels. Checkpoints without a hash are new and have to be recorded.
+ * Empty lines and lines starting with # are kept as they are when the suite is saved
+ */
+class GoldenSuite {
+public:
+    struct checkpoint_t {
+        uint64_t frame;
+        bool has_hash;
+        uint64_t hash;
+    };
+
+    struct entry_t {
+        // As written in the file
+        std::string ROM_name;
+        std::string input_script_name;
+        // Resolved against the suite directory
+        std::string ROM_path;
+        std::string input_script_path;
+        // Sorted by frame
+        std::vector<checkpoint_t> checkpoints;
+    };
+
+public:
+    GoldenSuite();
+    ~GoldenSuite();
+    void load_from_file(std::string file_path);
+    void save_to_file(std::string file_path);
+    inline std::vector<entry_t> &get_entries() {return entries;};
+
+private:
+    std::vector<entry_t> entries;
+    // Comments and empty lines, with the number of entries before them
+    std::vector<std::pair<size_t, std::string>> comments;
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "game_boy.h"
+
+/**
+ * Button changes scheduled at given frames. The file has one change per line:
+ * <frame> <button> <press|release>, where button is one of: right, left, up, down, a, b, start, select.
+ * Empty lines and lines starting with # are ignored
+ */
+class InputScript {
+public:
+    InputScript();
+    ~InputScript();
+    void load_from_file(std::string file_path);
+    /**
+     * Applies all changes scheduled for frames up to the given one (that were not applied yet)
+     */
+    void apply(GameBoy &game_boy, uint64_t frame);
+    bool is_finished();
+
+private:
+    struct input_event_t {
+        uint64_t frame;
+        Joypad::btn_type_t button;
+        Joypad::btn_state_t state;
+    };
+
+    std::vector<input_event_t> events;
+    size_t next_event;
+
+private:
+    static Joypad::btn_type_t parse_button(const std::string &name);
+};
@@ -24,6 +24,14 @@ enum intr_type_t {
 
 class Interrupts {
 friend class IO;
+public:
+    struct state_t {
+        uint8_t interrupt_flag;
+        uint8_t interrupt_enable;
+        bool IME_flag;
+        bool is_IME_flag_enabling_scheduled;
+    };
+
 public:
     Interrupts();
     ~Interrupts();
@@ -41,6 +49,8 @@ public:
     bool get_is_IME_flag_enabling_scheduled();
     void signal(intr_type_t type);
     void mark_used(intr_type_t type);
+    void save_state(state_t &state);
+    void load_state(const state_t &state);
 
 private:
     intr_reg_t interrupt_flag;
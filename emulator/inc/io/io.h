@@ -4,17 +4,47 @@
 #include "io/timer.h"
 #include "io/joypad.h"
 
+class PPU;
+
+class SerialListenerInterface {
+public:
+    virtual void serial_byte_sent(uint8_t value) = 0;
+};
+
 class IO: public ReadWriteInterface {
 friend class PPU; // TODO: Remove friends
-friend class GUI;
+friend class EmulationThread;
+public:
+    // Only the registers, components (interrupts, timer, joypad) have their own states
+    struct state_t {
+        uint8_t data[0x80];
+    };
+
 public:
     IO();
     ~IO();
     void write(uint16_t address, uint8_t value);
     uint8_t read(uint16_t address);
+    /**
+     * PPU is brought up to date before any of the LCD registers is accessed
+     * and is notified after they are written
+     */
+    void attach_PPU(PPU *ppu);
+    /**
+     * There is no link cable, so without a listener serial transfers never finish. With one, every byte
+     * sent with the internal clock is passed to it and the transfer finishes at once (test ROMs print through it).
+     * Pass nullptr to detach it
+     */
+    void attach_serial_listener(SerialListenerInterface *listener);
+    void save_state(state_t &state);
+    void load_state(const state_t &state);
     Interrupts interrupts;
     Timer timer;
     Joypad joypad;
 private:
+    static const uint16_t LCD_REGISTERS_START = 0xFF40;
+    static const uint16_t LCD_REGISTERS_END = 0xFF4B;
     uint8_t data[0x80];
+    PPU *ppu;
+    SerialListenerInterface *serial_listener;
 };
@@ -22,10 +22,21 @@ public:
         NOT_PRESSED = 1
     };
 
+    struct state_t {
+        uint8_t data_reg;
+        uint8_t btn_states[8];
+    };
+
     void btn_change_state(btn_type_t button, btn_state_t new_state);
+    /**
+     * Bit n is set if button n (btn_type_t) is pressed
+     */
+    uint8_t get_pressed_buttons();
     uint8_t get_data_reg_val();
     void set_data_reg_val(uint8_t value);
     void attach_interrupts_handler(Interrupts *interrupts);
+    void save_state(state_t &state);
+    void load_state(const state_t &state);
 
 private:
     enum btn_select_t {
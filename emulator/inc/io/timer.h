@@ -1,16 +1,34 @@
 #pragma once
 #include <cstdint>
 #include "read_write_interface.h"
+#include "scheduler.h"
 #include "io/interrupts.h"
 
-class Timer: public ReadWriteInterface {
+/**
+ * DIV and TIMA aren't incremented step by step. Their values are calculated from the master clock when accessed
+ * and TIMA overflow is a scheduled event
+ */
+class Timer: public ReadWriteInterface, public EventHandlerInterface {
+public:
+    // TIMA overflow event is kept by the scheduler
+    struct state_t {
+        uint8_t DIV;
+        uint8_t TIMA;
+        uint8_t TMA;
+        uint8_t TAC;
+        bool is_DIV_stopped;
+        uint64_t DIV_reset_cycle;
+        uint64_t TIMA_sync_cycle;
+    };
+
 public:
     Timer();
     ~Timer();
     void attach_interrupts_handler(Interrupts *interrupts);
+    void attach_scheduler(Scheduler *scheduler);
     void write(uint16_t address, uint8_t value);
     uint8_t read(uint16_t address);
-    void tick(unsigned cpu_cycles);
+    void handle_event(event_type_t type);
     void stop_DIV();
     void run_DIV_after_stop();
     uint8_t get_DIV();
@@ -18,6 +36,8 @@ public:
     uint8_t get_TMA();
     bool get_TAC_is_enabled();
     unsigned get_TAC_clock_divider();
+    void save_state(state_t &state);
+    void load_state(const state_t &state);
 
 private:
 enum TAC_clk_speed_t {
@@ -46,9 +66,15 @@ struct __attribute__((packed)) timer_t {
 } timer_data;
 
 Interrupts *interrupts;
+Scheduler *scheduler;
 
 bool is_DIV_stopped;
-unsigned DIV_CPU_clock_counter;
-unsigned TIMA_CPU_clock_counter;
+// Cycle at which the internal 16 bit counter (DIV being its upper byte) was last reset
+uint64_t DIV_reset_cycle;
+// Cycle up to which TIMA increments are already included in timer_data.TIMA
+uint64_t TIMA_sync_cycle;
+inline uint64_t get_cycles();
 inline void reset_DIV_counter();
+inline void sync_TIMA();
+inline void schedule_TIMA_overflow();
 };
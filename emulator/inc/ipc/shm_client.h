@@ -0,0 +1,116 @@
+#pragma once
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ipc/shm_protocol.h"
+
+/**
+ * Connects to a running ShmInstanceServer. Header only, clients don't need to link the emulator.
+ * Commands are asynchronous: submit returns a ticket and wait blocks until the command is done.
+ * An instance may be used by more clients, but its state is only consistent for the client that
+ * issued the last command
+ */
+class ShmInstanceClient {
+public:
+    ShmInstanceClient(const std::string &name) {
+        int file = shm_open(name.c_str(), O_RDWR, 0);
+        if (file < 0) {
+            throw std::runtime_error("Cannot open shared memory " + name + ": " + strerror(errno));
+        }
+        struct stat file_stat;
+        fstat(file, &file_stat);
+        segment_size = file_stat.st_size;
+        void *segment = (segment_size >= sizeof(shm_header_t))
+            ? mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) : MAP_FAILED;
+        close(file);
+        if (segment == MAP_FAILED) {
+            throw std::runtime_error("Cannot map shared memory " + name);
+        }
+        header = static_cast<shm_header_t *>(segment);
+        if (header->magic != SHM_MAGIC || header->version != SHM_PROTOCOL_VERSION
+            || header->instance_size != sizeof(shm_instance_t) || segment_size < shm_segment_size(header->instance_count)
+            || !header->is_ready.load(std::memory_order_acquire)) {
+            munmap(header, segment_size);
+            throw std::runtime_error("Shared memory " + name + " isn't a compatible instance server");
+        }
+    };
+
+    ShmInstanceClient(const ShmInstanceClient&) = delete;
+    ShmInstanceClient& operator=(const ShmInstanceClient&) = delete;
+
+    ~ShmInstanceClient() {
+        munmap(header, segment_size);
+    };
+
+    /**
+     * Queues a command (waits if the ring is full) and returns its ticket
+     */
+    uint32_t submit(shm_command_type_t type, uint16_t instance_no, uint32_t argument = 0) {
+        shm_command_t command;
+        command.type = type;
+        command.instance_no = instance_no;
+        command.argument = argument;
+        uint32_t ticket;
+        while (!shm_ring_push(header, command, ticket)) {
+            sched_yield();
+        }
+        return ticket;
+    };
+
+    inline bool is_completed(uint32_t ticket) {
+        return static_cast<int32_t>(header->completed_count.load(std::memory_order_acquire) - (ticket + 1)) >= 0;
+    };
+
+    /**
+     * Blocks until the command with a given ticket (and all queued before it) is done.
+     * Returns false if the server was shut down before that
+     */
+    bool wait(uint32_t ticket) {
+        while (!is_completed(ticket)) {
+            if (header->is_shut_down.load(std::memory_order_acquire)) {
+                return false;
+            }
+            header->sleeping_client_count.fetch_add(1, std::memory_order_seq_cst);
+            uint32_t completed = header->completed_count.load(std::memory_order_seq_cst);
+            if (static_cast<int32_t>(completed - (ticket + 1)) < 0) {
+                shm_futex_wait(&header->completed_count, completed, 100);
+            }
+            header->sleeping_client_count.fetch_sub(1, std::memory_order_seq_cst);
+        }
+        return true;
+    };
+
+    /**
+     * Submits a command, waits for it and returns its status
+     */
+    int32_t call(shm_command_type_t type, uint16_t instance_no, uint32_t argument = 0) {
+        if (!wait(submit(type, instance_no, argument))) {
+            return SHM_ERROR;
+        }
+        return (instance_no < header->instance_count) ? get_instance(instance_no).last_status : SHM_BAD_INSTANCE;
+    };
+
+    inline void set_input(uint16_t instance_no, uint8_t pressed_buttons) {
+        get_instance(instance_no).input.store(pressed_buttons, std::memory_order_relaxed);
+    };
+
+    inline shm_instance_t &get_instance(uint16_t instance_no) {
+        return *shm_get_instance(header, instance_no);
+    };
+
+    inline uint32_t get_instance_count() {
+        return header->instance_count;
+    };
+
+private:
+    shm_header_t *header;
+    size_t segment_size;
+};
+
+#endif
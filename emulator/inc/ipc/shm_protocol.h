@@ -0,0 +1,165 @@
+#pragma once
+#ifdef __linux__
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+ * Layout of the shared memory segment of ShmInstanceServer. Header only, so client processes
+ * don't have to link the emulator. The segment is:
+ * shm_header_t | shm_instance_t x instance_count
+ * Commands go through a bounded lock-free ring (any number of clients, one server). Both sides
+ * sleep on futexes in the segment when there is nothing to do, so the data path needs no sockets
+ */
+
+static const uint32_t SHM_MAGIC = 0x4D534247; // "GBSM"
+static const uint32_t SHM_PROTOCOL_VERSION = 2;
+static const uint32_t SHM_RING_CAPACITY = 256; // Power of 2
+static const uint32_t SHM_FRAMEBUFFER_WIDTH = 256;
+static const uint32_t SHM_FRAMEBUFFER_HEIGHT = 256;
+static const uint32_t SHM_WRAM_SIZE = 0x2000;
+// Fits the machine state with the largest supported cartridge RAM
+static const uint32_t SHM_STATE_SLOT_SIZE = 0x20000;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared memory needs address-free atomics");
+
+enum shm_command_type_t: uint16_t {
+    SHM_CMD_STEP_FRAMES = 0, // argument: number of frames
+    SHM_CMD_RESET = 1,
+    SHM_CMD_SHUTDOWN = 2, // Stops the server, instance is ignored
+    SHM_CMD_SAVE_STATE = 3, // Saves the machine into the state slot of the instance
+    SHM_CMD_LOAD_STATE = 4 // Loads the state slot (e.g. copied from another instance with the same ROM)
+};
+
+enum shm_status_t: int32_t {
+    SHM_OK = 0,
+    SHM_ERROR = -1,
+    SHM_UNKNOWN_COMMAND = -2,
+    SHM_BAD_INSTANCE = -3
+};
+
+struct shm_command_t {
+    uint16_t type;
+    uint16_t instance_no;
+    uint32_t argument;
+};
+
+struct shm_command_slot_t {
+    // Tells whose turn it is: equal to position - free for the producer, position + 1 - ready for the server
+    std::atomic<uint32_t> sequence;
+    shm_command_t command;
+};
+
+struct shm_header_t {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t instance_count;
+    uint32_t instance_size;
+    // Set by the server once everything is initialized
+    std::atomic<uint32_t> is_ready;
+    std::atomic<uint32_t> is_shut_down;
+    // Futex words. Producers bump command_counter after every push, the server bumps completed_count
+    // (number of commands finished, in ring order) after every command
+    alignas(64) std::atomic<uint32_t> command_counter;
+    std::atomic<uint32_t> is_server_sleeping;
+    alignas(64) std::atomic<uint32_t> completed_count;
+    std::atomic<uint32_t> sleeping_client_count;
+    alignas(64) std::atomic<uint32_t> enqueue_position;
+    alignas(64) uint32_t dequeue_position; // Server only
+    shm_command_slot_t ring[SHM_RING_CAPACITY];
+};
+
+/**
+ * State of one instance. Everything except input is written only by the server while it executes
+ * a command for this instance, so it's consistent once that command is completed
+ */
+struct shm_instance_t {
+    // Button mask (bit n is Joypad::btn_type_t n, set - pressed), applied before every frame
+    std::atomic<uint32_t> input;
+    int32_t last_status;
+    uint64_t frame_count;
+    uint64_t cycles;
+    uint64_t executed_instr_count;
+    // Number of the frame in framebuffer
+    uint64_t frame_no;
+    // Shades (0 - white to 3 - black), one byte per pixel
+    uint8_t framebuffer[SHM_FRAMEBUFFER_WIDTH * SHM_FRAMEBUFFER_HEIGHT];
+    uint8_t WRAM[SHM_WRAM_SIZE];
+    // Save state (see save_state.h) written by SHM_CMD_SAVE_STATE and read by SHM_CMD_LOAD_STATE.
+    // Clients may write it before queueing a load
+    uint32_t state_size;
+    alignas(8) uint8_t state[SHM_STATE_SLOT_SIZE];
+};
+
+inline size_t shm_segment_size(uint32_t instance_count) {
+    return sizeof(shm_header_t) + instance_count * sizeof(shm_instance_t);
+}
+
+inline shm_instance_t *shm_get_instance(shm_header_t *header, uint32_t instance_no) {
+    return reinterpret_cast<shm_instance_t *>(reinterpret_cast<uint8_t *>(header) + sizeof(shm_header_t)) + instance_no;
+}
+
+/**
+ * Futexes shared between processes, so the non-private variants are used
+ */
+inline void shm_futex_wait(std::atomic<uint32_t> *word, uint32_t expected_value, long timeout_ms) {
+    timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000;
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected_value, &timeout, nullptr, 0);
+}
+
+inline void shm_futex_wake_all(std::atomic<uint32_t> *word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+/**
+ * Producer side (any number of threads and processes). Returns false if the ring is full,
+ * otherwise the position of the command in the ring, which is also its ticket
+ */
+inline bool shm_ring_push(shm_header_t *header, const shm_command_t &command, uint32_t &ticket) {
+    uint32_t position = header->enqueue_position.load(std::memory_order_relaxed);
+    while (true) {
+        shm_command_slot_t &slot = header->ring[position & (SHM_RING_CAPACITY - 1)];
+        int32_t difference = static_cast<int32_t>(slot.sequence.load(std::memory_order_acquire) - position);
+        if (difference == 0) {
+            if (header->enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot.command = command;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                ticket = position;
+                break;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = header->enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+    header->command_counter.fetch_add(1, std::memory_order_seq_cst);
+    if (header->is_server_sleeping.load(std::memory_order_seq_cst)) {
+        shm_futex_wake_all(&header->command_counter);
+    }
+    return true;
+}
+
+/**
+ * Server side. Returns false if there is no command ready
+ */
+inline bool shm_ring_pop(shm_header_t *header, shm_command_t &command) {
+    uint32_t position = header->dequeue_position;
+    shm_command_slot_t &slot = header->ring[position & (SHM_RING_CAPACITY - 1)];
+    if (static_cast<int32_t>(slot.sequence.load(std::memory_order_acquire) - (position + 1)) < 0) {
+        return false;
+    }
+    command = slot.command;
+    slot.sequence.store(position + SHM_RING_CAPACITY, std::memory_order_release);
+    header->dequeue_position = position + 1;
+    return true;
+}
+
+#endif
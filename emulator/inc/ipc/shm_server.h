@@ -0,0 +1,55 @@
+#pragma once
+#ifdef __linux__
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "game_boy.h"
+#include "ipc/shm_protocol.h"
+
+/**
+ * Runs emulator instances for other processes. State, frames and inputs of the instances live in
+ * a POSIX shared memory segment (see shm_protocol.h), clients connect with ShmInstanceClient.
+ * Commands are executed one by one in the order they were queued
+ */
+class ShmInstanceServer {
+public:
+    /**
+     * Creates the segment (name like "/gameboy") and the instances. Empty ROM path means no cartridge
+     */
+    ShmInstanceServer(const std::string &name, unsigned instance_count, const std::string &ROM_path);
+    ShmInstanceServer(const ShmInstanceServer&) = delete;
+    ~ShmInstanceServer();
+    ShmInstanceServer& operator=(const ShmInstanceServer&) = delete;
+    /**
+     * Executes commands until SHM_CMD_SHUTDOWN arrives or stop is called
+     */
+    void serve();
+    /**
+     * Executes all commands that are already queued. Returns false once SHM_CMD_SHUTDOWN was executed
+     */
+    bool process_pending_commands();
+    /**
+     * Makes serve return. Safe to call from another thread or a signal handler
+     */
+    void stop();
+    GameBoy &get_instance(unsigned instance_no);
+
+private:
+    std::string name;
+    shm_header_t *header;
+    size_t segment_size;
+    std::vector<std::unique_ptr<GameBoy>> instances;
+    std::atomic<bool> should_stop;
+    // Reused for every SHM_CMD_SAVE_STATE
+    std::vector<uint8_t> state_buffer;
+
+private:
+    void exec_command(const shm_command_t &command);
+    void step_frames(unsigned instance_no, unsigned frame_count);
+    void save_state(unsigned instance_no);
+    void load_state(unsigned instance_no);
+    void publish_instance_state(unsigned instance_no);
+};
+
+#endif
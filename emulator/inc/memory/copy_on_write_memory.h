@@ -0,0 +1,56 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Memory split into 4kB pages. A copy shares all pages with the original and a page is only
+ * duplicated once one of them writes to it, so forking a machine doesn't copy memory that
+ * neither of them changes. Shared pages are never written, so instances sharing them may run
+ * on different threads. Copying marks the pages of the original as shared too, so it must not
+ * be done while the original is used by another thread
+ */
+class CopyOnWriteMemory {
+public:
+    static const unsigned PAGE_SIZE = 0x1000;
+
+public:
+    /**
+     * Zeroed memory of the given size (multiple of PAGE_SIZE)
+     */
+    CopyOnWriteMemory(size_t size);
+    CopyOnWriteMemory(const CopyOnWriteMemory &other);
+    ~CopyOnWriteMemory();
+    CopyOnWriteMemory& operator=(const CopyOnWriteMemory&) = delete;
+    inline uint8_t read(size_t address) {
+        return (*pages[address / PAGE_SIZE])[address % PAGE_SIZE];
+    };
+    inline void write(size_t address, uint8_t value) {
+        size_t page_no = address / PAGE_SIZE;
+        if (!is_page_private[page_no]) {
+            make_page_private(page_no);
+        }
+        (*pages[page_no])[address % PAGE_SIZE] = value;
+    };
+    void copy_to(uint8_t *destination);
+    /**
+     * Overwrites the whole memory. Shared pages with different contents are replaced, not written
+     */
+    void copy_from(const uint8_t *source);
+    inline size_t get_size() {return pages.size() * PAGE_SIZE;};
+    /**
+     * Number of pages that were shared with some other copy and weren't written since
+     */
+    unsigned get_shared_page_count();
+
+private:
+    typedef std::array<uint8_t, PAGE_SIZE> page_t;
+    std::vector<std::shared_ptr<page_t>> pages;
+    // Cleared in both copies by copying, even if the other copy is gone later
+    mutable std::vector<uint8_t> is_page_private;
+
+private:
+    void make_page_private(size_t page_no);
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include "read_write_interface.h"
+
+class ObjectAttributeMemory: public virtual ReadWriteInterface {
+public:
+    static const unsigned OAM_SIZE = 0xA0;
+
+    struct state_t {
+        uint8_t data[OAM_SIZE];
+    };
+
+    ObjectAttributeMemory();
+    ~ObjectAttributeMemory();
+    void write(uint16_t address, uint8_t value);
+    uint8_t read(uint16_t address);
+    void save_state(state_t &state);
+    void load_state(const state_t &state);
+
+    /**
+     * Returns pointer to the data array to allow PPU and DMA access OAM directly
+     */
+    uint8_t *get_raw_data();
+
+private:
+    static const unsigned OAM_MEMORY_START_ADDR = 0xFE00;
+    uint8_t data[OAM_SIZE];
+};
@@ -4,19 +4,51 @@
 
 class VideoRAM: public virtual ReadWriteInterface {
 public:
+    // Tile data area (0x8000 - 0x97FF) holds 384 tiles, 16 bytes each
+    static const unsigned TILE_COUNT = 384;
+    static const unsigned TILE_SIZE = 16;
+    static const int VRAM_SIZE = 0x2000;
+
+    struct state_t {
+        // Decoded tiles aren't saved, they're decoded again from the data on load
+        uint8_t data[VRAM_SIZE];
+    };
+
     VideoRAM();
     ~VideoRAM();
     void write(uint16_t address, uint8_t value);
     uint8_t read(uint16_t address);
+    void save_state(state_t &state);
+    void load_state(const state_t &state);
 
     /**
      * Returns pointer to the data array to allow PPU access VRAM directly.
      * Just to make VRAM access more efficient
+     * Writing through this pointer bypasses the decoded tile cache
      */
     uint8_t *get_raw_data();
 
+    /**
+     * Returns pointer to 8 already decoded pixels (color ids 0-3, one per byte, left to right)
+     * of a given tile line. Tiles are decoded when VRAM is written, so drawing only has to copy them
+     */
+    inline const uint8_t *get_decoded_tile_line(unsigned tile_no, unsigned line_no) {
+        return decoded_tiles[tile_no][line_no];
+    }
+
+    /**
+     * Returns pointer to all 64 decoded pixels of a given tile (8 lines, 8 pixels each)
+     */
+    inline const uint8_t *get_decoded_tile(unsigned tile_no) {
+        return decoded_tiles[tile_no][0];
+    }
+
 private:
-    static const int VRAM_SIZE = 0x2000;
     static const unsigned VRAM_MEMORY_START_ADDR = 0x8000;
+    static const unsigned TILE_DATA_SIZE = TILE_COUNT * TILE_SIZE;
     uint8_t data[VRAM_SIZE];
+    uint8_t decoded_tiles[TILE_COUNT][8][8];
+
+private:
+    inline void decode_tile_line(unsigned tile_line_offset);
 };
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include "read_write_interface.h"
+
+/**
+ * Internal 8kB RAM (0xC000 - 0xDFFF). 0xE000 - 0xFDFF is its echo
+ */
+class WorkRAM: public virtual ReadWriteInterface {
+public:
+    static const unsigned WRAM_SIZE = 0x2000;
+
+    struct state_t {
+        uint8_t data[WRAM_SIZE];
+    };
+
+    WorkRAM();
+    ~WorkRAM();
+    void write(uint16_t address, uint8_t value);
+    uint8_t read(uint16_t address);
+    void save_state(state_t &state);
+    void load_state(const state_t &state);
+
+    /**
+     * Returns pointer to the data array, so the RAM can be inspected without copying it
+     */
+    uint8_t *get_raw_data();
+
+private:
+    uint8_t data[WRAM_SIZE];
+};
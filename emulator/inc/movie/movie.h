@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Recorded play session: the joypad state after every change, stamped with the emulated cycle it was
+ * applied at, and save states taken every few hundred frames. The first keyframe is where the movie starts.
+ * Emulation is deterministic, so loading a keyframe and applying the inputs that follow it reproduces the
+ * session exactly, at any speed
+ */
+class Movie {
+public:
+    struct input_event_t {
+        uint64_t cycle;
+        // Bit n is set if button n (Joypad::btn_type_t) is pressed
+        uint8_t pressed_buttons;
+    };
+
+    struct keyframe_t {
+        uint64_t cycle;
+        // Frame count of the machine when the state was taken
+        uint64_t frame_no;
+        // Events before it are already a part of the state
+        uint64_t next_event;
+        std::vector<uint8_t> state;
+    };
+
+public:
+    Movie();
+    ~Movie();
+    void clear();
+    /**
+     * File starts with a header (magic, version, ROM hash, counts) followed by the events and the keyframes
+     */
+    void save_to_file(const std::string &file_path);
+    void load_from_file(const std::string &file_path);
+    void add_event(uint64_t cycle, uint8_t pressed_buttons);
+    /**
+     * All events added so far are treated as included in the state
+     */
+    void add_keyframe(uint64_t cycle, uint64_t frame_no, const std::vector<uint8_t> &state);
+    /**
+     * Marks where the recording currently ends
+     */
+    void set_end(uint64_t cycle, uint64_t frame_no);
+    inline const std::vector<input_event_t> &get_events() {return events;};
+    inline const std::vector<keyframe_t> &get_keyframes() {return keyframes;};
+    inline uint64_t get_ROM_hash() {return ROM_hash;};
+    inline void set_ROM_hash(uint64_t ROM_hash) {this->ROM_hash = ROM_hash;};
+    inline uint64_t get_end_cycle() {return end_cycle;};
+    inline uint64_t get_end_frame_no() {return end_frame_no;};
+
+private:
+    static const uint32_t MOVIE_MAGIC = 0x564D4247; // "GBMV"
+    static const uint32_t MOVIE_VERSION = 1;
+
+    struct file_header_t {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t ROM_hash;
+        uint64_t end_cycle;
+        uint64_t end_frame_no;
+        uint64_t event_count;
+        uint64_t keyframe_count;
+    };
+
+    struct file_event_t {
+        uint64_t cycle;
+        uint64_t pressed_buttons;
+    };
+
+    struct file_keyframe_header_t {
+        uint64_t cycle;
+        uint64_t frame_no;
+        uint64_t next_event;
+        uint64_t state_size;
+    };
+
+private:
+    uint64_t ROM_hash;
+    uint64_t end_cycle;
+    uint64_t end_frame_no;
+    std::vector<input_event_t> events;
+    std::vector<keyframe_t> keyframes;
+};
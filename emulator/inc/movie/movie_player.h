@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "game_boy.h"
+#include "movie/movie.h"
+
+/**
+ * Replays a movie on a machine with the same ROM, as fast as the machine runs.
+ * Seeking loads the nearest keyframe before the target (or goes on from the current position
+ * if that's closer) and emulates the rest. The machine shouldn't be changed by anything else
+ */
+class MoviePlayer {
+public:
+    /**
+     * Throws if the movie was recorded with another ROM. The machine starts at the beginning of the movie
+     */
+    MoviePlayer(GameBoy &game_boy, Movie &movie);
+    ~MoviePlayer();
+    /**
+     * Brings the machine to the moment frame frame_no was finished (VBlank entered). Frames before
+     * the start of the movie go to the start
+     */
+    void seek_to_frame(uint64_t frame_no);
+    /**
+     * Brings the machine to the first instruction boundary at or after the cycle
+     */
+    void seek_to_cycle(uint64_t cycle);
+    /**
+     * Plays the given number of frames from the current position, like GameBoy::run_frames
+     */
+    void run_frames(unsigned frame_count);
+    /**
+     * Returns true once the position is past the end of the recording
+     */
+    bool is_finished();
+
+private:
+    GameBoy &game_boy;
+    Movie &movie;
+    size_t next_event;
+
+private:
+    void load_keyframe(size_t keyframe_no);
+    void apply_due_events();
+    /**
+     * Runs to the given cycle, stopping at every input event on the way
+     */
+    void run_until(uint64_t target_cycle);
+};
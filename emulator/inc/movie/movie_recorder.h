@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "game_boy.h"
+#include "movie/movie.h"
+
+/**
+ * Records a movie of a machine. The frontend keeps feeding input to the machine as usual and calls
+ * update() after every frame and after every input change
+ */
+class MovieRecorder {
+public:
+    static const unsigned DEFAULT_KEYFRAME_INTERVAL = 300;
+
+public:
+    /**
+     * Starts recording from the current state of the machine
+     */
+    MovieRecorder(GameBoy &game_boy, unsigned keyframe_interval = DEFAULT_KEYFRAME_INTERVAL);
+    ~MovieRecorder();
+    /**
+     * Logs the joypad state if it changed and takes a keyframe every keyframe_interval frames
+     */
+    void update();
+    inline Movie &get_movie() {return movie;};
+
+private:
+    GameBoy &game_boy;
+    Movie movie;
+    unsigned keyframe_interval;
+    uint8_t last_pressed_buttons;
+    uint64_t last_keyframe_frame_no;
+    std::vector<uint8_t> state;
+
+private:
+    void add_keyframe();
+};
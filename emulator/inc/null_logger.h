@@ -0,0 +1,11 @@
+#pragma once
+#include "logger.h"
+
+/**
+ * Discards everything. Used when nobody is going to read the log, e.g. in headless runs
+ */
+class NullLogger: public Logger {
+public:
+    void log(std::string) {};
+    void log_instruction(instruction_t const&) {};
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Turns every rendered frame into an observation for machine learning consumers (grayscale, resized
+ * or packed) and keeps the last K of them. PPU feeds it at VBlank while the frame is still in cache,
+ * so consumers don't need another pass over the full framebuffer.
+ * Runs on the emulation thread, observations should be read from the same thread between steps
+ */
+class ObservationStage {
+public:
+    // Visible part of the screen, observations are made from it
+    static const unsigned SOURCE_WIDTH = 160;
+    static const unsigned SOURCE_HEIGHT = 144;
+
+    enum format_t {
+        GRAYSCALE = 0, // 160x144, one byte per pixel (255 - white, 0 - black)
+        GRAYSCALE_RESIZED = 1, // width x height, one byte per pixel, nearest neighbour
+        PACKED_2BIT = 2 // 160x144 shades (0 - white, 3 - black), 4 pixels per byte, leftmost in the lowest bits
+    };
+
+    struct config_t {
+        format_t format = GRAYSCALE_RESIZED;
+        // Only used by GRAYSCALE_RESIZED
+        unsigned width = 84;
+        unsigned height = 84;
+        // Number of the most recent observations kept
+        unsigned stack_size = 4;
+    };
+
+public:
+    ObservationStage(const config_t &config);
+    ~ObservationStage();
+    /**
+     * Makes an observation from a frame of shades (see PPU::frame_t) and replaces the oldest one
+     */
+    void push_frame(const uint8_t *pixels, unsigned row_stride, uint64_t frame_no);
+    /**
+     * Returns an observation by its age: 0 is the newest one, stack_size - 1 the oldest.
+     * Slots that weren't filled yet are zeroed
+     */
+    const uint8_t *get_observation(unsigned age);
+    uint64_t get_frame_no(unsigned age);
+    /**
+     * Copies the whole stack (oldest first) to one array of stack_size * get_observation_size() bytes
+     */
+    void copy_stack(uint8_t *destination);
+    void clear();
+    inline size_t get_observation_size() {return row_size * height;};
+    inline unsigned get_width() {return width;};
+    inline unsigned get_height() {return height;};
+    inline unsigned get_row_size() {return row_size;};
+    inline unsigned get_stack_size() {return stack_size;};
+    inline uint64_t get_pushed_count() {return pushed_count;};
+
+private:
+    format_t format;
+    unsigned width, height, row_size;
+    unsigned stack_size;
+    std::vector<uint8_t> slots;
+    std::vector<uint64_t> slot_frame_nos;
+    // Slot holding the newest observation
+    unsigned newest_slot;
+    uint64_t pushed_count;
+    // Source pixel of every output column and row (GRAYSCALE_RESIZED)
+    std::vector<uint16_t> source_columns;
+    std::vector<uint16_t> source_rows;
+
+private:
+    inline unsigned get_slot_no(unsigned age);
+    void make_grayscale(const uint8_t *pixels, unsigned row_stride, uint8_t *observation);
+    void make_grayscale_resized(const uint8_t *pixels, unsigned row_stride, uint8_t *observation);
+    void make_packed_2bit(const uint8_t *pixels, unsigned row_stride, uint8_t *observation);
+};
@@ -2,33 +2,140 @@
 #include <cstdint>
 #include "ppu/ppu_types.h"
 #include "bus.h"
+#include "triple_buffer.h"
+#include "observation.h"
+
+class PPU: public EventHandlerInterface {
+public:
+    // TODO: Set to the real values once scrolling is implmented
+    const static unsigned SCREEN_WIDTH = 256; 
+    const static unsigned SCREEN_HEIGHT = 256;
+
+    struct frame_t {
+        // Shades (0 - white to 3 - black) with palettes already applied, one byte per pixel
+        uint8_t pixels[SCREEN_WIDTH * SCREEN_HEIGHT];
+        // Number of the emulated frame (see get_frame_count)
+        uint64_t frame_no;
+    };
+
+    /**
+     * LCD registers are kept by IO. Pixels aren't a part of the state, the frame being drawn
+     * when the state is loaded is finished over the old one
+     */
+    struct state_t {
+        uint64_t next_event_cycle;
+        uint64_t frame_count;
+        bool is_current_frame_rendered;
+        uint32_t line_OBJ_count;
+        OBJ_t line_OBJs[10];
+        uint8_t line_BG_color_ids[SCREEN_WIDTH];
+    };
 
-class PPU {
 public:
     PPU(Bus &bus);
     ~PPU();
     void attach_interrupts(Interrupts *interrupts);
     void restart();
-    void tick(unsigned cpu_clocks);
+    /**
+     * Brings the PPU up to the master clock, performing all mode transitions that were due in the meantime.
+     * Scheduler calls it once the next transition is due, LCD register accesses call it on their own
+     */
+    void sync();
+    void handle_event(event_type_t type);
+    /**
+     * Returns the master clock cycle of the next mode transition
+     */
+    inline uint64_t get_next_event_cycle() {return next_event_cycle;};
+    /**
+     * Called by IO after the CPU has written one of the LCD registers
+     */
+    void register_written(uint16_t address, uint8_t old_value);
+    /**
+     * Selects which frames have their pixels rendered. Timing of the PPU is the same in every mode,
+     * so game behaviour doesn't depend on it
+     */
+    void set_render_mode(render_mode_t mode, unsigned frame_interval = 1);
+    render_mode_t get_render_mode();
+    inline unsigned get_render_frame_interval() {return render_frame_interval;};
+    /**
+     * Returns the number of frames finished (VBlanks entered) since power on
+     */
+    inline uint64_t get_frame_count() {return frame_count;};
     void render_current_screen_line();
-    uint32_t *get_screen_pixels();
+    /**
+     * Returns pixels of the frame that is currently being rendered. Meant for debugging,
+     * lines below LY may still come from an older frame
+     */
+    uint8_t *get_screen_pixels();
+    /**
+     * Returns the most recent complete frame. Frames are published at VBlank, so this never tears
+     * and may be called from another thread than the one running the emulation (but only from one)
+     */
+    const frame_t &get_latest_frame();
+    /**
+     * Returns true if a frame was completed since the last call to get_latest_frame
+     */
+    bool has_new_frame();
+    /**
+     * Converts shades to RGBA pixels. Meant to be done once per frame and only by consumers that need RGBA
+     */
+    static void convert_to_RGBA(const uint8_t *pixels, uint32_t *rgba_pixels, unsigned pixel_count);
+    /**
+     * Every rendered frame is passed to the observation stage at VBlank. Pass nullptr to detach it
+     */
+    void attach_observation(ObservationStage *observation);
+    void save_state(state_t &state);
+    /**
+     * Expects the IO registers to be loaded already
+     */
+    void load_state(const state_t &state);
 
 private:
-    // TODO: Set to the real values once scrolling is implmented
-    const static unsigned SCREEN_WIDTH = 256; 
-    const static unsigned SCREEN_HEIGHT = 256;
     const static unsigned VRAM_SIZE = 0x2000;
+    // Mode durations in dots (1 dot = 1 CPU clock cycle). Together they take one full line
+    const static unsigned SEARCHING_OAM_DOTS = 80;
+    const static unsigned RENDERING_DOTS = 291;
+    const static unsigned HBLANK_DOTS = 85;
+    const static unsigned LINE_DOTS = SEARCHING_OAM_DOTS + RENDERING_DOTS + HBLANK_DOTS;
+    const static unsigned LAST_VISIBLE_LINE = 143;
+    const static unsigned LAST_LINE = 153;
+    const static unsigned VISIBLE_SCREEN_WIDTH = 160;
+    const static unsigned OAM_OBJ_COUNT = 40;
+    const static unsigned MAX_OBJS_PER_LINE = 10;
+    static_assert(sizeof(state_t::line_OBJs) == MAX_OBJS_PER_LINE * sizeof(OBJ_t), "Objects of a line don't fit in the state");
 
     Bus &bus;
     LCD_data_t *LCD_data;
-    unsigned dots_in_current_mode;
-    // Each pixel is represented as 32 bit number (RGBA). This should be easily converted to OpenGL texture
-    uint32_t screen_pixels[SCREEN_WIDTH * SCREEN_HEIGHT];
+    uint64_t next_event_cycle;
+    uint64_t frame_count;
+    render_mode_t render_mode;
+    unsigned render_frame_interval;
+    bool is_current_frame_rendered;
+    // Rebuilt only when the palette registers are written
+    palette_lut_t BG_palette_lut;
+    palette_lut_t OBJ_palette_luts[2];
+    // Each pixel is represented as a shade in a separate byte. Conversion to RGBA is left to the consumers
+    TripleBuffer<frame_t> frames;
+    // Pixels of the back buffer of frames
+    uint8_t *screen_pixels;
+    ObservationStage *observation;
+    // Objects found by the OAM search of the current line, already in drawing priority order
+    OBJ_t line_OBJs[MAX_OBJS_PER_LINE];
+    unsigned line_OBJ_count;
+    // Color ids of the background in the current line, needed for the BG over OBJ priority
+    uint8_t line_BG_color_ids[SCREEN_WIDTH];
 
 private:
+    inline void exec_mode_transition();
+    inline void start_frame();
     inline void enter_mode_searching_OAM();
     inline void enter_mode_rendering();
     inline void enter_mode_hblank();
     inline void enter_mode_vblank();
-    inline void increment_LY();
+    inline void set_LY(uint8_t value);
+    inline void search_OAM();
+    inline void render_line_OBJs(uint8_t *line_pixels);
+    inline void schedule_next_event();
+    inline void build_palette_lut(palette_data_t palette, palette_lut_t &lut);
+    inline void apply_palette(const uint8_t *color_ids, uint8_t *shades, const palette_lut_t &lut);
 };
@@ -50,6 +50,31 @@ union __attribute__((packed)) STAT_t {
     } bits;
 };
 
+union __attribute__((packed)) OBJ_attributes_t {
+    uint8_t value;
+    struct __attribute__((packed)) INNER {
+        unsigned _CGB_only: 4;
+        unsigned palette_no: 1; // 0 - OBP0, 1 - OBP1
+        bool x_flip: 1; // 0 - Normal, 1 - Horizontally mirrored
+        bool y_flip: 1; // 0 - Normal, 1 - Vertically mirrored
+        bool BG_over_OBJ: 1; // 0 - No, 1 - BG and Window colors 1-3 over the OBJ
+    } bits;
+};
+
+// Single OAM entry
+struct __attribute__((packed)) OBJ_t {
+    uint8_t y; // Y Position + 16
+    uint8_t x; // X Position + 8
+    uint8_t tile_no; // Always from 0x8000 tile data area
+    OBJ_attributes_t attributes;
+};
+
+enum render_mode_t {
+    RENDER_ALL_FRAMES = 0,
+    RENDER_EVERY_NTH_FRAME = 1,
+    RENDER_TIMING_ONLY = 2 // Modes, LY, STAT and interrupts work as usual but no pixels are produced
+};
+
 enum color_t {
     WHITE = 0,
     LIGHT_GRAY = 1,
@@ -59,7 +84,7 @@ enum color_t {
 
 union __attribute__((packed)) palette_data_t {
     uint8_t value;
-    struct INNER {
+    struct __attribute__((packed)) INNER {
         color_t index0: 2;
         color_t index1: 2;
         color_t index2: 2;
@@ -67,6 +92,13 @@ union __attribute__((packed)) palette_data_t {
     } colors;
 };
 
+/**
+ * Maps color ids (0-3) to shades
+ */
+struct palette_lut_t {
+    uint8_t shades[4];
+};
+
 struct __attribute__((packed)) LCD_data_t {
     LLCDC_t LCD_control; // 0xFF40
     STAT_t LCD_status; // 0xFF41
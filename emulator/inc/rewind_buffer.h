@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "game_boy.h"
+
+/**
+ * Keeps the save states of the most recent frames, so the machine can be stepped backwards.
+ * Every state is stored as an XOR delta against the previous one, with a full keyframe every
+ * keyframe_interval states, and compressed with zero run-length encoding (deltas of consecutive frames
+ * are almost all zeros). Compressed states live in one ring of memory_budget bytes, when it's full
+ * the oldest keyframe is dropped together with its deltas.
+ * Not thread safe, should be used by the thread running the machine
+ */
+class RewindBuffer {
+public:
+    struct config_t {
+        size_t memory_budget = 64 << 20;
+        // Restoring a state decodes up to this many deltas
+        unsigned keyframe_interval = 60;
+    };
+
+public:
+    RewindBuffer(const config_t &config);
+    ~RewindBuffer();
+    /**
+     * Saves the state of the machine as the newest entry, should be called once per frame
+     */
+    void capture(GameBoy &game_boy);
+    /**
+     * Restores the state captured the given number of captures ago (0 is the newest one) and
+     * forgets all newer states. Returns false and does nothing if the buffer doesn't go back that far
+     */
+    bool rewind(GameBoy &game_boy, unsigned frames);
+    /**
+     * Decodes the state captured the given number of captures ago, without changing the buffer
+     */
+    void get_state(unsigned age, std::vector<uint8_t> &state);
+    // Frame count of the machine when the state was captured
+    uint64_t get_frame_no(unsigned age);
+    void clear();
+    inline size_t get_length() {return entries.size();};
+    inline size_t get_keyframe_count() {return keyframe_count;};
+    // Bytes of compressed states currently in the ring
+    inline size_t get_used_memory() {return used_memory;};
+    inline size_t get_state_size() {return newest_state.size();};
+
+private:
+    struct entry_t {
+        size_t offset;
+        size_t size;
+        uint64_t frame_no;
+        bool is_keyframe;
+    };
+
+private:
+    size_t capacity;
+    unsigned keyframe_interval;
+    // Allocated at once, but pages are only touched when the ring reaches them
+    std::unique_ptr<uint8_t[]> ring;
+    size_t write_offset;
+    size_t used_memory;
+    std::deque<entry_t> entries;
+    size_t keyframe_count;
+    unsigned deltas_since_keyframe;
+    // Decoded newest entry, next delta is made against it
+    std::vector<uint8_t> newest_state;
+    std::vector<uint8_t> captured_state;
+    std::vector<uint8_t> delta;
+    std::vector<uint8_t> encoded;
+
+private:
+    inline size_t get_index(unsigned age) {return entries.size() - 1 - age;};
+    void drop_oldest_keyframe();
+    size_t allocate(size_t size);
+    bool store(const uint8_t *data, size_t size, uint64_t frame_no, bool is_keyframe);
+    void decode(size_t index, std::vector<uint8_t> &state);
+    static size_t encode(const uint8_t *data, size_t size, uint8_t *output);
+    static void apply(const uint8_t *encoded, size_t encoded_size, uint8_t *state, size_t size, bool is_keyframe);
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "game_boy.h"
+
+/**
+ * Hides the input lag of games by showing a frame from the future. Every displayed frame the machine
+ * runs one frame of the real timeline, saves its state, runs the given number of frames ahead with the
+ * same input (pixels only for the last one), and goes back to the saved state. The frame published by
+ * the PPU is then the one the game would show a few frames later, already reacting to the latest input
+ */
+class RunAhead {
+public:
+    RunAhead(GameBoy &game_boy, unsigned frames = 1);
+    ~RunAhead();
+    /**
+     * 0 turns run-ahead off, frames run normally then
+     */
+    inline void set_frames(unsigned frames) {this->frames = frames;};
+    inline unsigned get_frames() {return frames;};
+    /**
+     * Runs one frame of the real timeline, see PPU::get_latest_frame for the frame to display
+     */
+    void run_frame();
+
+private:
+    GameBoy &game_boy;
+    unsigned frames;
+    std::vector<uint8_t> state;
+};
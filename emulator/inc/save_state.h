@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+/**
+ * Save state is a header followed by flat blocks, one per component: a block header and the raw bytes
+ * of the component's state_t, so taking or loading a state is just a handful of memcpys.
+ * SAVE_STATE_VERSION has to be bumped whenever any of the state_t structs changes
+ */
+static const uint32_t SAVE_STATE_MAGIC = 0x53534247; // "GBSS"
+static const uint32_t SAVE_STATE_VERSION = 2;
+// Blocks start at multiples of it, so states can be used in place
+static const size_t SAVE_STATE_ALIGNMENT = 8;
+
+enum save_state_block_id_t: uint32_t {
+    BLOCK_GAME_BOY = 1,
+    BLOCK_CPU = 2,
+    BLOCK_SCHEDULER = 3,
+    BLOCK_BUS = 4,
+    BLOCK_IO = 5,
+    BLOCK_INTERRUPTS = 6,
+    BLOCK_TIMER = 7,
+    BLOCK_JOYPAD = 8,
+    BLOCK_VRAM = 9,
+    BLOCK_WRAM = 10,
+    BLOCK_OAM = 11,
+    BLOCK_PPU = 12,
+    BLOCK_CARTRIDGE = 13
+};
+
+struct save_state_header_t {
+    uint32_t magic;
+    uint32_t version;
+    // Save states can only be loaded with the same ROM
+    uint64_t ROM_hash;
+    uint64_t size;
+};
+
+struct save_state_block_header_t {
+    uint32_t id;
+    uint32_t size;
+};
+
+inline size_t save_state_block_size(size_t data_size) {
+    size_t size = sizeof(save_state_block_header_t) + data_size;
+    return (size + SAVE_STATE_ALIGNMENT - 1) / SAVE_STATE_ALIGNMENT * SAVE_STATE_ALIGNMENT;
+}
+
+class SaveStateWriter {
+public:
+    SaveStateWriter(uint8_t *buffer): cursor(buffer) {};
+
+    /**
+     * Writes the block header and returns where its data goes
+     */
+    inline uint8_t *begin_block(save_state_block_id_t id, size_t size) {
+        save_state_block_header_t block_header = {id, static_cast<uint32_t>(size)};
+        memcpy(cursor, &block_header, sizeof(block_header));
+        uint8_t *data = cursor + sizeof(block_header);
+        size_t block_size = save_state_block_size(size);
+        // Padding is zeroed, so the same machine state always gives the same bytes
+        memset(data + size, 0, block_size - sizeof(block_header) - size);
+        cursor += block_size;
+        return data;
+    };
+
+    /**
+     * Component state is written in place
+     */
+    template<typename C>
+    inline void write_block(save_state_block_id_t id, C &component) {
+        typedef typename C::state_t state_t;
+        static_assert(std::is_trivially_copyable<state_t>::value, "Save state blocks must be POD");
+        // Value initialization zeroes the struct padding too. A memset before a default initializing placement new
+        // isn't enough, the compiler is allowed to drop it as a store to a dead object
+        component.save_state(*new (begin_block(id, sizeof(state_t))) state_t());
+    }
+
+private:
+    uint8_t *cursor;
+};
+
+class SaveStateReader {
+public:
+    /**
+     * Reader that only checks the blocks and doesn't touch the components is a dry run. Used to validate
+     * the whole state first, so a broken one can't leave the machine half loaded
+     */
+    SaveStateReader(const uint8_t *state, size_t size, bool is_dry_run = false):
+        cursor(state), end(state + size), is_dry_run(is_dry_run) {};
+
+    /**
+     * Checks the block header and returns the block's data
+     */
+    inline const uint8_t *next_block(save_state_block_id_t id, size_t size) {
+        save_state_block_header_t block_header;
+        if (cursor + save_state_block_size(size) > end) {
+            throw std::runtime_error("Save state is truncated");
+        }
+        memcpy(&block_header, cursor, sizeof(block_header));
+        if (block_header.id != id || block_header.size != size) {
+            throw std::runtime_error("Save state block " + std::to_string(block_header.id) + " doesn't match this version");
+        }
+        const uint8_t *data = cursor + sizeof(block_header);
+        cursor += save_state_block_size(size);
+        return data;
+    };
+
+    template<typename C>
+    inline void read_block(save_state_block_id_t id, C &component) {
+        typedef typename C::state_t state_t;
+        const uint8_t *data = next_block(id, sizeof(state_t));
+        if (!is_dry_run) {
+            component.load_state(*reinterpret_cast<const state_t *>(data));
+        }
+    }
+
+    inline bool get_is_dry_run() {return is_dry_run;};
+
+private:
+    const uint8_t *cursor;
+    const uint8_t *end;
+    bool is_dry_run;
+};
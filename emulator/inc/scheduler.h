@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+
+enum event_type_t {
+    PPU_MODE_CHANGE = 0,
+    TIMER_OVERFLOW = 1,
+    EVENT_TYPES_COUNT
+};
+
+class EventHandlerInterface {
+public:
+    virtual void handle_event(event_type_t type) = 0;
+};
+
+/**
+ * Keeps the master clock (CPU clock cycles since power on) and the deadlines of all pending timed events.
+ * Components schedule their next event at an absolute cycle and are only called once it's due,
+ * so between the deadlines the CPU can run without any other bookkeeping
+ */
+class Scheduler {
+public:
+    static const uint64_t NO_EVENT = UINT64_MAX;
+
+    struct state_t {
+        uint64_t cycles;
+        uint64_t event_cycles[EVENT_TYPES_COUNT];
+    };
+
+    Scheduler();
+    ~Scheduler();
+    void attach_handler(event_type_t type, EventHandlerInterface *handler);
+    inline uint64_t get_cycles() {return cycles;};
+    inline uint64_t get_next_event_cycle() {return next_event_cycle;};
+    /**
+     * Advances the master clock and dispatches all events that became due
+     */
+    inline void advance(unsigned cpu_cycles) {
+        cycles += cpu_cycles;
+        if (cycles >= next_event_cycle) {
+            dispatch_due_events();
+        }
+    };
+    /**
+     * (Re)schedules an event of a given type at an absolute cycle. There is at most one pending event of each type
+     */
+    void schedule(event_type_t type, uint64_t cycle);
+    void cancel(event_type_t type);
+    uint64_t get_event_cycle(event_type_t type);
+    void dispatch_due_events();
+    /**
+     * Handlers aren't a part of the state, they stay attached
+     */
+    void save_state(state_t &state);
+    void load_state(const state_t &state);
+
+private:
+    uint64_t cycles;
+    uint64_t next_event_cycle;
+    event_type_t next_event_type;
+    uint64_t event_cycles[EVENT_TYPES_COUNT];
+    EventHandlerInterface *handlers[EVENT_TYPES_COUNT];
+
+private:
+    inline void find_next_event();
+};
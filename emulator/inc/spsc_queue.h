@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * Fixed size lock-free queue for exactly one producer thread and one consumer thread.
+ * Neither push nor pop ever blocks, they fail instead when the queue is full or empty
+ */
+template <typename T, size_t CAPACITY>
+class SPSCQueue {
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "Capacity has to be a power of 2");
+
+public:
+    SPSCQueue(): head(0), tail(0) {
+
+    }
+
+    ~SPSCQueue() {
+
+    }
+
+    /**
+     * Producer side. Returns false if the queue is full
+     */
+    bool push(const T &item) {
+        size_t current_tail = tail.load(std::memory_order_relaxed);
+        if (current_tail - head.load(std::memory_order_acquire) == CAPACITY) {
+            return false;
+        }
+        slots[current_tail & INDEX_MASK] = item;
+        tail.store(current_tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer side. Returns false if the queue is empty
+     */
+    bool pop(T &item) {
+        size_t current_head = head.load(std::memory_order_relaxed);
+        if (current_head == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(slots[current_head & INDEX_MASK]);
+        head.store(current_head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool is_empty() {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static const size_t INDEX_MASK = CAPACITY - 1;
+    // Indices only grow, slot is selected by the lowest bits. Kept on separate cache lines as each is written by another thread
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    T slots[CAPACITY];
+};
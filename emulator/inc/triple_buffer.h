@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Hands complete objects (e.g. frames) over from one producer thread to one consumer thread without locks or copies.
+ * Producer fills the back buffer and publishes it, consumer takes the most recently published one as its front buffer.
+ * The third (middle) buffer is exchanged atomically between them, so neither side ever waits for the other
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer(): buffers(), back(0), front(1), middle(2) {
+
+    }
+
+    ~TripleBuffer() {
+
+    }
+
+    /**
+     * Producer side. Returns the buffer that is currently being filled
+     */
+    inline T &get_back() {return buffers[back];};
+
+    /**
+     * Producer side. Makes the back buffer the latest complete one and continues with the next free buffer
+     */
+    inline void publish() {
+        back = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    };
+
+    /**
+     * Consumer side. Returns true if something was published since the last acquire
+     */
+    inline bool has_fresh() {
+        return (middle.load(std::memory_order_acquire) & FRESH_BIT) != 0;
+    };
+
+    /**
+     * Consumer side. Takes the latest published buffer (if there is a fresh one) and returns it.
+     * Returned buffer stays valid and unchanged until the next call
+     */
+    inline const T &acquire() {
+        if (has_fresh()) {
+            front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+        return buffers[front];
+    };
+
+private:
+    static const uint8_t INDEX_MASK = 0b011;
+    static const uint8_t FRESH_BIT = 0b100;
+    T buffers[3];
+    // Owned by the producer
+    uint8_t back;
+    // Owned by the consumer
+    uint8_t front;
+    // Index of the buffer in the middle, with FRESH_BIT set when it was published but not acquired yet
+    std::atomic<uint8_t> middle;
+};
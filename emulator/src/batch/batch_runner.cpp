@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include "batch/batch_runner.h"
+
+BatchRunner::BatchRunner(unsigned thread_count): pool(thread_count) {
+    slice_unit = slice_unit_t::SLICE_FRAMES;
+    slice_size = 1;
+}
+
+BatchRunner::~BatchRunner() {
+
+}
+
+size_t BatchRunner::add_instance(const instance_config_t &config) {
+    std::unique_ptr<instance_t> instance = std::make_unique<instance_t>();
+    instance->config = config;
+    instance->result.instance_id = instances.size();
+    instance->game_boy = std::make_unique<GameBoy>();
+    try {
+        if (!config.ROM_image.empty()) {
+            instance->game_boy->load_cartridge_from_memory(config.ROM_image.data(), config.ROM_image.size());
+        } else if (!config.ROM_path.empty()) {
+            instance->game_boy->load_cartridge_from_file(config.ROM_path);
+        }
+        instance->game_boy->ppu.set_render_mode(config.render_mode, config.render_frame_interval);
+    } catch (std::exception &e) {
+        // Reported through the result callback, the instance won't be run
+        instance->result.error = e.what();
+    }
+    instances.push_back(std::move(instance));
+    return instances.size() - 1;
+}
+
+void BatchRunner::set_slice(slice_unit_t unit, uint64_t size) {
+    slice_unit = unit;
+    slice_size = (size > 0) ? size : 1;
+}
+
+void BatchRunner::run(result_callback_t on_finished) {
+    this->on_finished = on_finished;
+    for (auto &instance_ptr: instances) {
+        instance_t *instance = instance_ptr.get();
+        instance->start_frame = instance->game_boy->get_frame_count();
+        instance->start_cycle = instance->game_boy->get_cycles();
+        instance->start_instr_count = instance->game_boy->cpu.get_executed_instr_count();
+        instance->run_frame_count = 0;
+        instance->result.seconds = 0;
+        instance->is_done = false;
+        if (instance->result.error.empty()) {
+            pool.submit([this, instance]() {run_slice(*instance);});
+        } else {
+            finish(*instance);
+        }
+    }
+    pool.wait_idle();
+}
+
+size_t BatchRunner::get_instance_count() {
+    return instances.size();
+}
+
+GameBoy &BatchRunner::get_instance(size_t instance_id) {
+    return *instances[instance_id]->game_boy;
+}
+
+unsigned BatchRunner::get_thread_count() {
+    return pool.get_thread_count();
+}
+
+void BatchRunner::run_slice(instance_t &instance) {
+    GameBoy &game_boy = *instance.game_boy;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        if (instance.config.before_slice) {
+            instance.config.before_slice(game_boy);
+        }
+        if (slice_unit == slice_unit_t::SLICE_FRAMES) {
+            uint64_t frames = slice_size;
+            if (instance.config.frame_limit > 0) {
+                frames = std::min(frames, instance.config.frame_limit - get_frames_run(instance));
+            }
+            game_boy.run_frames(frames);
+            instance.run_frame_count += frames;
+        } else {
+            uint64_t cycles = slice_size;
+            if (instance.config.cycle_limit > 0) {
+                cycles = std::min(cycles, instance.config.cycle_limit - (game_boy.get_cycles() - instance.start_cycle));
+            }
+            game_boy.run_cycles(cycles);
+        }
+        if (instance.config.is_done && instance.config.is_done(game_boy)) {
+            instance.is_done = true;
+        }
+    } catch (std::exception &e) {
+        instance.result.error = e.what();
+    }
+    instance.result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!instance.result.error.empty() || is_finished(instance)) {
+        finish(instance);
+    } else {
+        // Queued behind the instances that waited longer on this worker
+        pool.submit_behind([this, &instance]() {run_slice(instance);});
+    }
+}
+
+bool BatchRunner::is_finished(instance_t &instance) {
+    GameBoy &game_boy = *instance.game_boy;
+    if (instance.is_done) {
+        return true;
+    }
+    if (instance.config.frame_limit == 0 && instance.config.cycle_limit == 0) {
+        // Nothing would stop it, so it gets a single slice
+        return true;
+    }
+    if (instance.config.frame_limit > 0 && get_frames_run(instance) >= instance.config.frame_limit) {
+        return true;
+    }
+    if (instance.config.cycle_limit > 0 && game_boy.get_cycles() - instance.start_cycle >= instance.config.cycle_limit) {
+        return true;
+    }
+    return false;
+}
+
+uint64_t BatchRunner::get_frames_run(instance_t &instance) {
+    if (slice_unit == slice_unit_t::SLICE_FRAMES) {
+        return instance.run_frame_count;
+    }
+    return instance.game_boy->get_frame_count() - instance.start_frame;
+}
+
+void BatchRunner::finish(instance_t &instance) {
+    GameBoy &game_boy = *instance.game_boy;
+    instance.result.frames = game_boy.get_frame_count() - instance.start_frame;
+    instance.result.cycles = game_boy.get_cycles() - instance.start_cycle;
+    instance.result.instructions = game_boy.cpu.get_executed_instr_count() - instance.start_instr_count;
+    if (on_finished) {
+        on_finished(instance.result, game_boy);
+    }
+}
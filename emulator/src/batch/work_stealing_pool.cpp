@@ -0,0 +1,124 @@
+#include <algorithm>
+#include "batch/work_stealing_pool.h"
+
+namespace {
+    // Lets submit() find out if it's called by a worker and by which one
+    thread_local WorkStealingPool *current_pool = nullptr;
+    thread_local unsigned current_worker_no = 0;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    queued_task_count = 0;
+    pending_task_count = 0;
+    next_queue = 0;
+    should_stop = false;
+    for (unsigned i = 0; i < thread_count; ++i) {
+        queues.push_back(std::make_unique<worker_queue_t>());
+    }
+    for (unsigned i = 0; i < thread_count; ++i) {
+        threads.emplace_back(&WorkStealingPool::worker_loop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        should_stop = true;
+    }
+    work_available.notify_all();
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(task_t task) {
+    push(std::move(task), false);
+}
+
+void WorkStealingPool::submit_behind(task_t task) {
+    push(std::move(task), true);
+}
+
+void WorkStealingPool::push(task_t task, bool is_behind) {
+    unsigned queue_no;
+    if (current_pool == this) {
+        queue_no = current_worker_no;
+    } else {
+        queue_no = next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    }
+    ++pending_task_count;
+    {
+        // Counted before the task can be taken, so the count never drops below zero. Changed under the lock,
+        // so a worker that is just going to sleep can't miss it
+        std::lock_guard<std::mutex> lock(state_mutex);
+        ++queued_task_count;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[queue_no]->mutex);
+        if (is_behind) {
+            queues[queue_no]->tasks.push_front(std::move(task));
+        } else {
+            queues[queue_no]->tasks.push_back(std::move(task));
+        }
+    }
+    work_available.notify_one();
+}
+
+void WorkStealingPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(state_mutex);
+    all_done.wait(lock, [this]() {return pending_task_count == 0;});
+}
+
+unsigned WorkStealingPool::get_thread_count() {
+    return threads.size();
+}
+
+void WorkStealingPool::worker_loop(unsigned worker_no) {
+    current_pool = this;
+    current_worker_no = worker_no;
+    task_t task;
+    while (true) {
+        if (try_pop(worker_no, task) || try_steal(worker_no, task)) {
+            --queued_task_count;
+            task();
+            task = nullptr;
+            if (--pending_task_count == 0) {
+                std::lock_guard<std::mutex> lock(state_mutex);
+                all_done.notify_all();
+            }
+        } else {
+            std::unique_lock<std::mutex> lock(state_mutex);
+            work_available.wait(lock, [this]() {return should_stop || queued_task_count > 0;});
+            if (should_stop && queued_task_count == 0) {
+                return;
+            }
+        }
+    }
+}
+
+bool WorkStealingPool::try_pop(unsigned worker_no, task_t &task) {
+    worker_queue_t &queue = *queues[worker_no];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::try_steal(unsigned worker_no, task_t &task) {
+    for (unsigned i = 1; i < queues.size(); ++i) {
+        worker_queue_t &queue = *queues[(worker_no + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
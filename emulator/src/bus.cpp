@@ -1,16 +1,22 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <iterator>
+#include <vector>
 #include "bus.h"
 #include "cartridge/cartridge_header.h"
 #include "cartridge/rom_only_cart.h"
 #include "cartridge/mbc1_cart.h"
 #include "emulator_exception.h"
+#include "hash.h"
 
 // TODO: Allow accessing all types of memory "directly" using bus?
 
 Bus::Bus() {
+    cartridge = nullptr;
     is_cart_inserted = false;
+    ROM_hash = 0;
+    io.timer.attach_scheduler(&scheduler);
     // TODO: Remove
     memset(tmp_mem, 0, 0xFFFF+1);
 }
@@ -26,6 +32,10 @@ ReadWriteInterface *Bus::get_mem_access_handler(uint16_t address) {
         return &vram;
     } else if (address <= 0xBFFF) { // External RAM (on cartridge)
         return cartridge;
+    } else if (address <= 0xFDFF) { // Work RAM and its echo
+        return &wram;
+    } else if (address >= 0xFE00 && address <= 0xFE9F) { // OAM
+        return &oam;
     } else if ((address >= 0xFF00 && address <= 0xFF7F) || address == 0xFFFF) { // IO Registers
         return &io;
     } else {
@@ -41,6 +51,9 @@ void Bus::write(uint16_t address, uint8_t value) {
     } else {
         tmp_mem[address] = value;
     }
+    if (address == 0xFF46) { // OAM DMA
+        exec_OAM_DMA(value);
+    }
 }
 
 uint8_t Bus::read(uint16_t address) {
@@ -55,38 +68,70 @@ uint8_t Bus::read(uint16_t address) {
     return value;
 }
 
-void Bus::load_cartridge_from_file(std::string file_path) {
-    unsigned file_size;
-    cardridge_header_t header;
+/**
+ * Copies 160 bytes from 0xXX00 (XX is the value written to the DMA register) to OAM
+ * TODO: The transfer is done at once, while it should take 160 machine cycles
+ */
+void Bus::exec_OAM_DMA(uint8_t source_high_byte) {
+    uint16_t source_addr = source_high_byte << 8;
+    uint8_t *oam_data = oam.get_raw_data();
+    for (unsigned i = 0; i < ObjectAttributeMemory::OAM_SIZE; ++i) {
+        oam_data[i] = read(source_addr + i);
+    }
+}
 
+void Bus::load_cartridge_from_file(std::string file_path) {
     std::ifstream file(file_path, std::ios::binary);
     if (!file.good()) {
         throw std::runtime_error("Cannot open file: " + file_path);
     }
-    file_size = static_cast<int>(file.tellg());
-    file.seekg(0, std::ios::end);
-    file_size = static_cast<int>(file.tellg()) - file_size;
-
-    // TODO: Check if file is big enough to contain a header
-    // Read cartridge header
-    file.seekg(CARTRIDGE_HEADER_START, std::ios::beg);
-    file.read(reinterpret_cast<char *>(&header), CARTRIDGE_HEADER_SIZE);
+    std::vector<uint8_t> ROM_image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    load_cartridge_from_memory(ROM_image.data(), ROM_image.size());
+}
+
+void Bus::load_cartridge_from_memory(const uint8_t *ROM_image, size_t image_size) {
+    cardridge_header_t header;
+    if (image_size < CARTRIDGE_HEADER_START + CARTRIDGE_HEADER_SIZE) {
+        throw EmulatorException("ROM is too small to contain a header (%d bytes)", static_cast<int>(image_size));
+    }
+    memcpy(&header, ROM_image + CARTRIDGE_HEADER_START, CARTRIDGE_HEADER_SIZE);
+    Cartridge *new_cartridge;
     switch(header.type) {
         case ROM_ONLY:
-            cartridge = new ROMOnlyCart();
+            new_cartridge = new ROMOnlyCart();
             break;
         case MBC1:
         case MBC1_RAM:
         case MBC1_RAM_BATTERY:
-            cartridge = new MBC1Cart(header);
+            new_cartridge = new MBC1Cart(header);
             break;
         default:
             throw EmulatorException("Cartridge type %s not supported yet", get_cartridge_type_name(header.type).c_str());
             break;
     }
-    cartridge->load_from_file(file, file_size);
-    file.close();
+    try {
+        new_cartridge->load_from_memory(ROM_image, image_size);
+    } catch (...) {
+        delete new_cartridge;
+        throw;
+    }
+    // The old cartridge is only replaced once the new one is ready
+    delete cartridge;
+    cartridge = new_cartridge;
     is_cart_inserted = true;
+    ROM_hash = hash_fnv1a_64(ROM_image, image_size);
+}
+
+void Bus::insert_forked_cartridge(Bus &other) {
+    Cartridge *new_cartridge = (other.cartridge != nullptr) ? other.cartridge->fork() : nullptr;
+    delete cartridge;
+    cartridge = new_cartridge;
+    is_cart_inserted = other.is_cart_inserted;
+    ROM_hash = other.ROM_hash;
+    if (cartridge == nullptr) {
+        memcpy(tmp_mem, other.tmp_mem, sizeof(tmp_mem));
+    }
 }
 
 // void Bus::insert_cartridge(Cartridge* cartridge) {
@@ -103,6 +148,22 @@ bool Bus::get_is_cart_inserted() {
     return is_cart_inserted;
 }
 
+Cartridge *Bus::get_cartridge() {
+    return cartridge;
+}
+
+uint64_t Bus::get_ROM_hash() {
+    return ROM_hash;
+}
+
+void Bus::save_state(state_t &state) {
+    memcpy(state.high_memory, tmp_mem + 0xFE00, sizeof(state.high_memory));
+}
+
+void Bus::load_state(const state_t &state) {
+    memcpy(tmp_mem + 0xFE00, state.high_memory, sizeof(state.high_memory));
+}
+
 // void Bus::tmp_dump() {
 //     std::fstream file;
 //     file.open("mem.bin", std::ios::out|std::ios::binary);
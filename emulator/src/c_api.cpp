@@ -0,0 +1,125 @@
+#include <exception>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include "c_api.h"
+#include "game_boy.h"
+#include "observation.h"
+
+static_assert(PPU::SCREEN_WIDTH == GB_FRAMEBUFFER_WIDTH && PPU::SCREEN_HEIGHT == GB_FRAMEBUFFER_HEIGHT,
+    "C API frame size doesn't match the PPU");
+static_assert(GB_BUTTON_RIGHT == (1 << Joypad::RIGHT) && GB_BUTTON_SELECT == (1 << Joypad::SELECT),
+    "C API button bits don't match the joypad");
+
+struct gb_instance {
+    GameBoy game_boy;
+    std::string last_error;
+    std::unique_ptr<ObservationStage> observation;
+};
+
+/**
+ * Exceptions must not cross the C boundary, so they're turned into an error code and a message
+ */
+template<typename F>
+static int call_reporting_errors(gb_t *gb, F function) {
+    try {
+        function();
+        gb->last_error.clear();
+        return GB_OK;
+    } catch (std::exception &e) {
+        gb->last_error = e.what();
+        return GB_ERROR;
+    }
+}
+
+gb_t *gb_create(void) {
+    return new (std::nothrow) gb_instance();
+}
+
+void gb_destroy(gb_t *gb) {
+    delete gb;
+}
+
+int gb_load_rom_mem(gb_t *gb, const uint8_t *ROM_image, size_t image_size) {
+    return call_reporting_errors(gb, [&]() {
+        gb->game_boy.load_cartridge_from_memory(ROM_image, image_size);
+    });
+}
+
+int gb_step_frames(gb_t *gb, unsigned frame_count) {
+    return call_reporting_errors(gb, [&]() {
+        gb->game_boy.run_frames(frame_count);
+    });
+}
+
+void gb_set_input(gb_t *gb, uint8_t pressed_buttons) {
+    gb->game_boy.set_pressed_buttons(pressed_buttons);
+}
+
+const uint8_t *gb_framebuffer_ptr(gb_t *gb) {
+    return gb->game_boy.ppu.get_latest_frame().pixels;
+}
+
+uint8_t *gb_memory_ptr(gb_t *gb, gb_memory_region_t region, size_t *size) {
+    Bus &bus = gb->game_boy.bus;
+    uint8_t *data = nullptr;
+    size_t region_size = 0;
+    switch (region) {
+        case GB_MEMORY_WRAM:
+            data = bus.wram.get_raw_data();
+            region_size = WorkRAM::WRAM_SIZE;
+            break;
+        case GB_MEMORY_VRAM:
+            data = bus.vram.get_raw_data();
+            region_size = VideoRAM::VRAM_SIZE;
+            break;
+        case GB_MEMORY_OAM:
+            data = bus.oam.get_raw_data();
+            region_size = ObjectAttributeMemory::OAM_SIZE;
+            break;
+    }
+    if (size != nullptr) {
+        *size = region_size;
+    }
+    return data;
+}
+
+int gb_vram_write(gb_t *gb, size_t offset, const uint8_t *data, size_t size) {
+    return call_reporting_errors(gb, [&]() {
+        if (offset > VideoRAM::VRAM_SIZE || size > VideoRAM::VRAM_SIZE - offset) {
+            throw std::runtime_error("VRAM write out of range");
+        }
+        for (size_t i = 0; i < size; ++i) {
+            gb->game_boy.bus.vram.write(static_cast<uint16_t>(0x8000 + offset + i), data[i]);
+        }
+    });
+}
+
+int gb_configure_observation(gb_t *gb, gb_observation_format_t format, unsigned width, unsigned height,
+    unsigned stack_size) {
+    return call_reporting_errors(gb, [&]() {
+        ObservationStage::config_t config;
+        config.format = static_cast<ObservationStage::format_t>(format);
+        config.width = width;
+        config.height = height;
+        config.stack_size = stack_size;
+        std::unique_ptr<ObservationStage> observation = std::make_unique<ObservationStage>(config);
+        gb->game_boy.ppu.attach_observation(observation.get());
+        gb->observation = std::move(observation);
+    });
+}
+
+const uint8_t *gb_observation_ptr(gb_t *gb, unsigned age, size_t *size) {
+    if (gb->observation == nullptr || age >= gb->observation->get_stack_size()) {
+        return nullptr;
+    }
+    if (size != nullptr) {
+        *size = gb->observation->get_observation_size();
+    }
+    return gb->observation->get_observation(age);
+}
+
+const char *gb_last_error(gb_t *gb) {
+    return gb->last_error.c_str();
+}
@@ -1,47 +1,44 @@
+#include <cstring>
 #include "cartridge/mbc1_cart.h"
 #include "emulator_exception.h"
 
 // TODO: Add support for multi-game compilation carts
-MBC1Cart::MBC1Cart(cardridge_header_t &header) {
+MBC1Cart::MBC1Cart(cardridge_header_t &header):
+    RAM_data(get_number_of_RAM_banks(header) * SINGLE_RAM_BANK_SIZE) {
     RAM_enabled = false;
     selected_ROM_bank_lower_bits = 0x01;
     number_of_ROM_banks = (1 << (header.ROM_size_shift + 1));
+    number_of_RAM_banks = get_number_of_RAM_banks(header);
+    ROM_data = std::shared_ptr<uint8_t[]>(new uint8_t[number_of_ROM_banks * SINGLE_ROM_BANK_SIZE]);
+    selected_banking_mode = ROM_BANKING_MODE;
+    selected_RAM_bank_or_upper_ROM_bits = 0;
+}
+
+MBC1Cart::~MBC1Cart() {
+
+}
+
+unsigned MBC1Cart::get_number_of_RAM_banks(cardridge_header_t &header) {
     switch(header.RAM_size_id) {
         case 0x02:
-            number_of_RAM_banks = 1;
-            break;
+            return 1;
         case 0x03:
-            number_of_RAM_banks = 4;
-            break;
+            return 4;
         case 0x04:
-            number_of_RAM_banks = 16;
-            break;
+            return 16;
         case 0x05:
-            number_of_RAM_banks = 8;
-            break;
+            return 8;
         default:
-            number_of_RAM_banks = 0;
-            break;
+            return 0;
     }
-    ROM_data = new uint8_t[number_of_ROM_banks * SINGLE_ROM_BANK_SIZE];
-    RAM_data = new uint8_t[number_of_RAM_banks * SINGLE_RAM_BANK_SIZE];
-    selected_banking_mode = ROM_BANKING_MODE;
-    selected_RAM_bank_or_upper_ROM_bits = 0;
-}
-
-MBC1Cart::~MBC1Cart() {
-    delete[] ROM_data;
-    delete[] RAM_data;
 }
 
-void MBC1Cart::load_from_file(std::ifstream &cart_file, unsigned file_size) {
-    if (file_size > (number_of_ROM_banks * SINGLE_ROM_BANK_SIZE)) {
-        throw EmulatorException("File has incorrect size for ROM-only cart. Expected %d, got %d",
-            number_of_ROM_banks * SINGLE_ROM_BANK_SIZE, file_size);
+void MBC1Cart::load_from_memory(const uint8_t *ROM_image, unsigned image_size) {
+    if (image_size > (number_of_ROM_banks * SINGLE_ROM_BANK_SIZE)) {
+        throw EmulatorException("File has incorrect size for MBC1 cart. Expected %d, got %d",
+            number_of_ROM_banks * SINGLE_ROM_BANK_SIZE, image_size);
     }
-    cart_file.seekg(0, std::ios::beg);
-    cart_file.read(reinterpret_cast<char *>(ROM_data), file_size);
-
+    memcpy(ROM_data.get(), ROM_image, image_size);
 }
 
 void MBC1Cart::write(uint16_t address, uint8_t value) {
@@ -65,7 +62,7 @@ void MBC1Cart::write(uint16_t address, uint8_t value) {
         uint16_t in_bank_address = address - 0xA000;
         unsigned selected_RAM_bank = (selected_banking_mode == RAM_BANKING_MODE ? selected_RAM_bank_or_upper_ROM_bits : 0);
         if (selected_RAM_bank < number_of_RAM_banks) { // Bank IDs start at 0
-            RAM_data[(selected_RAM_bank * SINGLE_RAM_BANK_SIZE) + in_bank_address] = value;
+            RAM_data.write((selected_RAM_bank * SINGLE_RAM_BANK_SIZE) + in_bank_address, value);
         }
     }
 }
@@ -86,16 +83,46 @@ uint8_t MBC1Cart::read(uint16_t address) {
         uint16_t in_bank_address = address - 0xA000;
         unsigned selected_RAM_bank = (selected_banking_mode == RAM_BANKING_MODE ? selected_RAM_bank_or_upper_ROM_bits : 0);
         if (selected_RAM_bank < number_of_RAM_banks) { // Bank IDs start at 0
-            return RAM_data[(selected_RAM_bank * SINGLE_RAM_BANK_SIZE) + in_bank_address];
+            return RAM_data.read((selected_RAM_bank * SINGLE_RAM_BANK_SIZE) + in_bank_address);
         }
     }
     return 0xFF; // TODO: What should be returned
 }
 
 uint8_t *MBC1Cart::get_raw_ROM_data() {
-    return ROM_data;
+    return ROM_data.get();
 }
 
 unsigned MBC1Cart::get_raw_ROM_size() {
     return number_of_ROM_banks * SINGLE_ROM_BANK_SIZE;
 }
+
+size_t MBC1Cart::get_state_size() {
+    return sizeof(banking_state_t) + number_of_RAM_banks * SINGLE_RAM_BANK_SIZE;
+}
+
+void MBC1Cart::save_state(uint8_t *state) {
+    banking_state_t banking_state;
+    // Padding is zeroed, so the same machine state always gives the same bytes
+    memset(&banking_state, 0, sizeof(banking_state));
+    banking_state.RAM_enabled = RAM_enabled;
+    banking_state.selected_banking_mode = selected_banking_mode;
+    banking_state.selected_ROM_bank_lower_bits = selected_ROM_bank_lower_bits;
+    banking_state.selected_RAM_bank_or_upper_ROM_bits = selected_RAM_bank_or_upper_ROM_bits;
+    memcpy(state, &banking_state, sizeof(banking_state));
+    RAM_data.copy_to(state + sizeof(banking_state));
+}
+
+void MBC1Cart::load_state(const uint8_t *state) {
+    banking_state_t banking_state;
+    memcpy(&banking_state, state, sizeof(banking_state));
+    RAM_enabled = banking_state.RAM_enabled;
+    selected_banking_mode = static_cast<banking_mode_t>(banking_state.selected_banking_mode);
+    selected_ROM_bank_lower_bits = banking_state.selected_ROM_bank_lower_bits;
+    selected_RAM_bank_or_upper_ROM_bits = banking_state.selected_RAM_bank_or_upper_ROM_bits;
+    RAM_data.copy_from(state + sizeof(banking_state));
+}
+
+Cartridge *MBC1Cart::fork() {
+    return new MBC1Cart(*this);
+}
@@ -1,39 +1,60 @@
+#include <cstring>
 #include "cartridge/rom_only_cart.h"
 #include "emulator_exception.h"
 
-ROMOnlyCart::ROMOnlyCart() {
-    
+ROMOnlyCart::ROMOnlyCart(): data(new uint8_t[MEMORY_SIZE]()), RAM(RAM_SIZE) {
+
 }
 
 ROMOnlyCart::~ROMOnlyCart() {
 
 }
 
-void ROMOnlyCart::load_from_file(std::ifstream &cart_file, unsigned file_size) {
-    if (file_size > MEMORY_SIZE) {
-        throw EmulatorException("File has incorrect size for ROM-only cart. Expected %d, got %d", MEMORY_SIZE, file_size);
+void ROMOnlyCart::load_from_memory(const uint8_t *ROM_image, unsigned image_size) {
+    if (image_size > MEMORY_SIZE) {
+        throw EmulatorException("File has incorrect size for ROM-only cart. Expected %d, got %d", MEMORY_SIZE, image_size);
     }
-    cart_file.seekg(0, std::ios::beg);
-    cart_file.read(reinterpret_cast<char *>(&data), file_size);
+    memcpy(data.get(), ROM_image, image_size);
 }
 
 void ROMOnlyCart::write(uint16_t address, uint8_t value) {
     /* Writes to ROM should be obviously futile but ROM only cartridge
      can optionally cantain up to 8kB of RAM located between 0xA000 and 0xBFFF
      */
-    if (address >= 0xA000 || address <= 0xBFFF) {
-        data[address] = value;
+    if (address >= 0xA000 && address <= 0xBFFF) {
+        RAM.write(address - 0xA000, value);
     }
 }
 
 uint8_t ROMOnlyCart::read(uint16_t address) {
-    return data[address];
+    if (address >= 0xA000 && address <= 0xBFFF) {
+        return RAM.read(address - 0xA000);
+    } else if (address < MEMORY_SIZE) {
+        return data[address];
+    }
+    return 0xFF;
 }
 
 uint8_t *ROMOnlyCart::get_raw_ROM_data() {
-    return data;
+    return data.get();
 }
 
 unsigned ROMOnlyCart::get_raw_ROM_size() {
     return MEMORY_SIZE;
 }
+
+size_t ROMOnlyCart::get_state_size() {
+    return RAM_SIZE;
+}
+
+void ROMOnlyCart::save_state(uint8_t *state) {
+    RAM.copy_to(state);
+}
+
+void ROMOnlyCart::load_state(const uint8_t *state) {
+    RAM.copy_from(state);
+}
+
+Cartridge *ROMOnlyCart::fork() {
+    return new ROMOnlyCart(*this);
+}
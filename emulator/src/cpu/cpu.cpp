@@ -1,4 +1,5 @@
 #include <cstring>
+#include <algorithm>
 #include "bus.h"
 #include "cpu/cpu.h"
 
@@ -52,6 +53,7 @@ static const int INSTRUCTION_LENGTH_LOOKUP[256] = {
 };
 
 CPU::CPU(Bus &bus, Logger &logger): bus{bus}, logger{logger} {
+    executed_instr_count = 0;
     restart();
 }
 
@@ -109,6 +111,53 @@ int CPU::exec_next_instr() {
     return cycles;
 }
 
+/**
+ * Runs the CPU until the master clock reaches a given cycle
+ * Timed events are dispatched by the scheduler once their deadline passes,
+ * so the CPU doesn't have to tick any other component between them
+ */
+void CPU::run_until(uint64_t target_cycle) {
+    Scheduler &scheduler = bus.scheduler;
+    while (scheduler.get_cycles() < target_cycle) {
+        if (is_halted && !bus.io.interrupts.is_interrupt_pending() && !bus.io.interrupts.get_is_IME_flag_enabling_scheduled()) {
+            /* Nothing but a timed event can wake up the halted CPU, so instead of executing
+            * NOPs one by one skip straight to the next deadline (still in 4 cycle steps)
+            */
+            uint64_t deadline = std::min(target_cycle, scheduler.get_next_event_cycle());
+            scheduler.advance(((deadline - scheduler.get_cycles() + 3) / 4) * 4);
+        } else {
+            scheduler.advance(exec_next_instr());
+            ++executed_instr_count;
+        }
+    }
+}
+
+void CPU::save_state(state_t &state) {
+    state.A = regA;
+    state.F = flags_reg.value;
+    state.BC = regBC;
+    state.DE = regDE;
+    state.HL = regHL;
+    state.PC = regPC;
+    state.SP = regSP;
+    state.is_halted = is_halted;
+    state.is_stopped = is_stopped;
+    state.executed_instr_count = executed_instr_count;
+}
+
+void CPU::load_state(const state_t &state) {
+    regA = state.A;
+    flags_reg.value = state.F;
+    regBC = state.BC;
+    regDE = state.DE;
+    regHL = state.HL;
+    regPC = state.PC;
+    regSP = state.SP;
+    is_halted = state.is_halted;
+    is_stopped = state.is_stopped;
+    executed_instr_count = state.executed_instr_count;
+}
+
 long CPU::get_clock_speed_Hz() {
     return CLOCK_SPEED_HZ;
 }
@@ -1899,5 +1948,8 @@ int CPU::cpu_exec_op(instruction_t instruction) {
         default:
             break;
     }
+    #if PROFILE_OPCODES == 1
+        opcode_profile.record(instruction, operation_cycles, flags_reg);
+    #endif
     return operation_cycles;
 }
@@ -0,0 +1,41 @@
+#include "cpu/cpu_engine.h"
+
+ScalarCPUEngine::ScalarCPUEngine(GameBoy &game_boy): game_boy(game_boy) {
+
+}
+
+ScalarCPUEngine::~ScalarCPUEngine() {
+
+}
+
+std::string ScalarCPUEngine::get_name() {
+    return "scalar";
+}
+
+GameBoy &ScalarCPUEngine::get_game_boy() {
+    return game_boy;
+}
+
+void ScalarCPUEngine::run_until(uint64_t target_cycle) {
+    game_boy.cpu.run_until(target_cycle);
+}
+
+LockstepCPUEngine::LockstepCPUEngine(GameBoy &game_boy): game_boy(game_boy), lockstep_cpu({&game_boy}) {
+
+}
+
+LockstepCPUEngine::~LockstepCPUEngine() {
+
+}
+
+std::string LockstepCPUEngine::get_name() {
+    return "lockstep";
+}
+
+GameBoy &LockstepCPUEngine::get_game_boy() {
+    return game_boy;
+}
+
+void LockstepCPUEngine::run_until(uint64_t target_cycle) {
+    lockstep_cpu.run_until(target_cycle);
+}
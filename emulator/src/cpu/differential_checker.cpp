@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cstdio>
+#include "cpu/differential_checker.h"
+#include "cpu/disassembler.h"
+
+DifferentialChecker::DifferentialChecker(CPUEngine &reference, CPUEngine &checked, const config_t &config):
+    reference(reference), checked(checked), config(config) {
+    is_diverged = false;
+    step_count = 0;
+}
+
+DifferentialChecker::~DifferentialChecker() {
+
+}
+
+bool DifferentialChecker::run_until(uint64_t target_cycle) {
+    GameBoy &reference_game_boy = reference.get_game_boy();
+    GameBoy &checked_game_boy = checked.get_game_boy();
+    machine_state_t reference_state, checked_state;
+    while (!is_diverged && reference_game_boy.get_cycles() < target_cycle) {
+        uint64_t start_cycle = reference_game_boy.get_cycles();
+        // One cycle ahead means exactly one instruction
+        uint64_t step_end = start_cycle + ((config.block_cycles > 0) ? config.block_cycles : 1);
+        step_end = std::min(step_end, target_cycle);
+        if (config.context_size > 0) {
+            context.push_back(disassemble_at(reference_game_boy, reference_game_boy.cpu.get_regPC()));
+            if (context.size() > config.context_size) {
+                context.pop_front();
+            }
+        }
+        reference.run_until(step_end);
+        checked.run_until(step_end);
+
+        save_machine_state(reference_game_boy, reference_state);
+        save_machine_state(checked_game_boy, checked_state);
+        std::vector<std::string> differences = compare(reference_state, checked_state);
+        if (!differences.empty()) {
+            is_diverged = true;
+            divergence.step_no = step_count;
+            divergence.reference_state = reference_state;
+            divergence.checked_state = checked_state;
+            divergence.differences = differences;
+            divergence.context.assign(context.begin(), context.end());
+            return false;
+        }
+        ++step_count;
+    }
+    return !is_diverged;
+}
+
+void DifferentialChecker::save_machine_state(GameBoy &game_boy, machine_state_t &state) {
+    state.cycles = game_boy.get_cycles();
+    game_boy.cpu.save_state(state.cpu);
+    game_boy.bus.io.interrupts.save_state(state.interrupts);
+}
+
+std::string DifferentialChecker::get_report() {
+    if (!is_diverged) {
+        return "Engines " + reference.get_name() + " and " + checked.get_name() + " match after "
+            + std::to_string(step_count) + " steps\n";
+    }
+    std::string report = "Engines " + reference.get_name() + " and " + checked.get_name() + " diverged after "
+        + std::to_string(divergence.step_no) + " matching steps\nDifferent:";
+    for (const std::string &difference: divergence.differences) {
+        report += " " + difference;
+    }
+    size_t name_width = std::max(reference.get_name().size(), checked.get_name().size()) + 1;
+    report += "\n" + (reference.get_name() + ":").append(name_width - reference.get_name().size(), ' ')
+        + format_state(divergence.reference_state) + "\n";
+    report += (checked.get_name() + ":").append(name_width - checked.get_name().size(), ' ')
+        + format_state(divergence.checked_state) + "\n";
+    report += "Steps leading to it (the last one diverged):\n";
+    for (size_t i = 0; i < divergence.context.size(); ++i) {
+        report += ((i + 1 == divergence.context.size()) ? "> " : "  ") + divergence.context[i] + "\n";
+    }
+    report += "Next: " + reference.get_name() + " "
+        + disassemble_at(reference.get_game_boy(), divergence.reference_state.cpu.PC) + ", "
+        + checked.get_name() + " " + disassemble_at(checked.get_game_boy(), divergence.checked_state.cpu.PC) + "\n";
+    return report;
+}
+
+/**
+ * Reads the instruction bytes through the bus, which for the ROM and RAM has no side effects
+ */
+std::string DifferentialChecker::disassemble_at(GameBoy &game_boy, uint16_t address) {
+    instruction_t instruction;
+    for (unsigned i = 0; i < 3; ++i) {
+        instruction.raw[i] = game_boy.bus.read((address + i) & 0xFFFF);
+    }
+    char disassembled[32];
+    char line[64];
+    Disassembler::disassemble_instr(instruction, disassembled);
+    snprintf(line, sizeof(line), "0x%04X: %s", address, disassembled);
+    return line;
+}
+
+std::vector<std::string> DifferentialChecker::compare(const machine_state_t &reference_state, const machine_state_t &checked_state) {
+    std::vector<std::string> differences;
+    const CPU::state_t &a = reference_state.cpu;
+    const CPU::state_t &b = checked_state.cpu;
+    const Interrupts::state_t &interrupts_a = reference_state.interrupts;
+    const Interrupts::state_t &interrupts_b = checked_state.interrupts;
+    auto check = [&differences](bool is_equal, const char *name) {
+        if (!is_equal) {
+            differences.push_back(name);
+        }
+    };
+    check(reference_state.cycles == checked_state.cycles, "cycles");
+    check(a.A == b.A, "A");
+    check(a.F == b.F, "F");
+    check(a.BC == b.BC, "BC");
+    check(a.DE == b.DE, "DE");
+    check(a.HL == b.HL, "HL");
+    check(a.SP == b.SP, "SP");
+    check(a.PC == b.PC, "PC");
+    check(a.is_halted == b.is_halted, "halted");
+    check(a.is_stopped == b.is_stopped, "stopped");
+    check(a.executed_instr_count == b.executed_instr_count, "instructions");
+    check(interrupts_a.IME_flag == interrupts_b.IME_flag, "IME");
+    check(interrupts_a.is_IME_flag_enabling_scheduled == interrupts_b.is_IME_flag_enabling_scheduled, "EI");
+    check(interrupts_a.interrupt_flag == interrupts_b.interrupt_flag, "IF");
+    check(interrupts_a.interrupt_enable == interrupts_b.interrupt_enable, "IE");
+    return differences;
+}
+
+std::string DifferentialChecker::format_state(const machine_state_t &state) {
+    const CPU::state_t &cpu = state.cpu;
+    char text[192];
+    snprintf(text, sizeof(text), "A=%02X F=%c%c%c%c BC=%04X DE=%04X HL=%04X SP=%04X PC=%04X IME=%d IF=%02X IE=%02X%s cycles=%llu",
+        cpu.A, (cpu.F & 0x80) ? 'Z' : '-', (cpu.F & 0x40) ? 'N' : '-', (cpu.F & 0x20) ? 'H' : '-', (cpu.F & 0x10) ? 'C' : '-',
+        cpu.BC, cpu.DE, cpu.HL, cpu.SP, cpu.PC, state.interrupts.IME_flag ? 1 : 0, state.interrupts.interrupt_flag,
+        state.interrupts.interrupt_enable, cpu.is_halted ? " halted" : "", (unsigned long long)state.cycles);
+    return text;
+}
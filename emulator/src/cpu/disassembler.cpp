@@ -1,6 +1,6 @@
 #include <cstring>
 #include <cstdio>
-#include "disassembler.h"
+#include "cpu/disassembler.h"
 
 int Disassembler::disassemble_instr(instruction_t const& instruction, char* buffer) {
     int op;
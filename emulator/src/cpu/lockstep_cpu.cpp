@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <stdexcept>
+#include "cpu/lockstep_cpu.h"
+
+static const uint8_t FLAG_Z = 0x80;
+static const uint8_t FLAG_N = 0x40;
+static const uint8_t FLAG_H = 0x20;
+static const uint8_t FLAG_C = 0x10;
+
+/**
+ * Returns the length of an instruction which can be executed in lockstep or 0 if it has to be executed by the scalar CPU
+ * Supported: NOP, LD r,r; LD r,n; INC/DEC r; INC/DEC rr; ALU A,r; ALU A,n; JR (cc); JP (cc)
+ * (everything that doesn't touch the memory, the stack or the interrupts)
+ */
+static unsigned lockstep_instr_length(uint8_t opcode) {
+    unsigned reg_x = (opcode >> 3) & 0x7;
+    unsigned reg_y = opcode & 0x7;
+    if (opcode == 0x00) {
+        return 1;
+    }
+    if (opcode >= 0x40 && opcode <= 0x7F) { // LD r,r (HALT and (HL) excluded)
+        return (reg_x != 6 && reg_y != 6) ? 1 : 0;
+    }
+    if (opcode >= 0x80 && opcode <= 0xBF) { // ALU A,r
+        return (reg_y != 6) ? 1 : 0;
+    }
+    if (opcode < 0x40) {
+        switch (opcode & 0xC7) {
+            case 0x04: // INC r
+            case 0x05: // DEC r
+                return (reg_x != 6) ? 1 : 0;
+            case 0x06: // LD r,n
+                return (reg_x != 6) ? 2 : 0;
+        }
+        switch (opcode & 0xCF) {
+            case 0x03: // INC rr
+            case 0x0B: // DEC rr
+                return 1;
+        }
+        if (opcode == 0x18 || opcode == 0x20 || opcode == 0x28 || opcode == 0x30 || opcode == 0x38) {
+            return 2;
+        }
+        return 0;
+    }
+    if ((opcode & 0xC7) == 0xC6) { // ALU A,n
+        return 2;
+    }
+    if (opcode == 0xC3 || opcode == 0xC2 || opcode == 0xCA || opcode == 0xD2 || opcode == 0xDA) {
+        return 3;
+    }
+    return 0;
+}
+
+/**
+ * Picks the new value for lanes taking part in the instruction (mask 0xFF) and keeps the old one for the others
+ */
+static inline uint8_t blend(uint8_t mask, uint8_t new_value, uint8_t old_value) {
+    return (new_value & mask) | (old_value & ~mask);
+}
+
+LockstepCPU::LockstepCPU(const std::vector<GameBoy *> &lanes)
+: lanes(lanes) {
+    if (lanes.empty() || lanes.size() > MAX_LANES) {
+        throw std::runtime_error("LockstepCPU needs between 1 and " + std::to_string(MAX_LANES) + " lanes");
+    }
+    lane_count = lanes.size();
+    std::fill(&regs8[0][0], &regs8[0][0] + sizeof(regs8), 0);
+    std::fill(flags, flags + MAX_LANES, 0);
+    std::fill(regSP, regSP + MAX_LANES, 0);
+    std::fill(regPC, regPC + MAX_LANES, 0);
+    std::fill(group_mask, group_mask + MAX_LANES, 0);
+    lockstep_instr_count = 0;
+    scalar_instr_count = 0;
+}
+
+LockstepCPU::~LockstepCPU() {
+
+}
+
+unsigned LockstepCPU::get_lane_count() {
+    return lane_count;
+}
+
+void LockstepCPU::run_until(uint64_t target_cycle) {
+    for (unsigned i = 0; i < lane_count; ++i) {
+        load_lane(i);
+    }
+    uint8_t is_done[MAX_LANES];
+    while (true) {
+        bool is_any_lane_active = false;
+        for (unsigned i = 0; i < lane_count; ++i) {
+            is_done[i] = lanes[i]->bus.scheduler.get_cycles() >= target_cycle;
+            is_any_lane_active |= !is_done[i];
+        }
+        if (!is_any_lane_active) {
+            break;
+        }
+
+        // Lanes are split into groups about to execute exactly the same bytes. Each group makes one step
+        for (unsigned leader = 0; leader < lane_count; ++leader) {
+            if (is_done[leader]) {
+                continue;
+            }
+            instruction_t instruction = fetch(leader, regPC[leader]);
+            unsigned length = lockstep_instr_length(instruction.fields.operation);
+            if (length == 0 || !can_run_lockstep(leader)) {
+                exec_scalar(leader, target_cycle);
+                is_done[leader] = true;
+                continue;
+            }
+            std::fill(group_mask, group_mask + MAX_LANES, 0);
+            for (unsigned i = leader; i < lane_count; ++i) {
+                if (!is_done[i] && regPC[i] == regPC[leader] && can_run_lockstep(i)) {
+                    instruction_t lane_instruction = (i == leader) ? instruction : fetch(i, regPC[i]);
+                    if (std::equal(instruction.raw, instruction.raw + length, lane_instruction.raw)) {
+                        group_mask[i] = 0xFF;
+                        is_done[i] = true;
+                    }
+                }
+            }
+            int cycles = exec_lockstep(instruction);
+            for (unsigned i = leader; i < lane_count; ++i) {
+                if (group_mask[i]) {
+                    lanes[i]->bus.scheduler.advance(cycles);
+                    ++lanes[i]->cpu.executed_instr_count;
+                    ++lockstep_instr_count;
+                }
+            }
+        }
+    }
+    for (unsigned i = 0; i < lane_count; ++i) {
+        store_lane(i);
+    }
+}
+
+void LockstepCPU::load_lane(unsigned lane_no) {
+    CPU &cpu = lanes[lane_no]->cpu;
+    regs8[REG_B][lane_no] = cpu._regBC.pair.higher;
+    regs8[REG_C][lane_no] = cpu._regBC.pair.lower;
+    regs8[REG_D][lane_no] = cpu._regDE.pair.higher;
+    regs8[REG_E][lane_no] = cpu._regDE.pair.lower;
+    regs8[REG_H][lane_no] = cpu._regHL.pair.higher;
+    regs8[REG_L][lane_no] = cpu._regHL.pair.lower;
+    regs8[REG_A][lane_no] = cpu.regA;
+    flags[lane_no] = cpu.flags_reg.value;
+    regSP[lane_no] = cpu._regSP.value;
+    regPC[lane_no] = cpu._regPC.value;
+}
+
+void LockstepCPU::store_lane(unsigned lane_no) {
+    CPU &cpu = lanes[lane_no]->cpu;
+    cpu._regBC.pair.higher = regs8[REG_B][lane_no];
+    cpu._regBC.pair.lower = regs8[REG_C][lane_no];
+    cpu._regDE.pair.higher = regs8[REG_D][lane_no];
+    cpu._regDE.pair.lower = regs8[REG_E][lane_no];
+    cpu._regHL.pair.higher = regs8[REG_H][lane_no];
+    cpu._regHL.pair.lower = regs8[REG_L][lane_no];
+    cpu.regA = regs8[REG_A][lane_no];
+    cpu.flags_reg.value = flags[lane_no];
+    cpu._regSP.value = regSP[lane_no];
+    cpu._regPC.value = regPC[lane_no];
+}
+
+/**
+ * Lockstep only covers plain instruction execution. Anything that the scalar CPU does before
+ * or after an instruction (waking up, interrupt dispatch, EI delay) is left to it
+ */
+bool LockstepCPU::can_run_lockstep(unsigned lane_no) {
+    CPU &cpu = lanes[lane_no]->cpu;
+    Interrupts &interrupts = lanes[lane_no]->bus.io.interrupts;
+    return !cpu.is_halted && !cpu.is_stopped
+        && !interrupts.get_is_IME_flag_enabling_scheduled()
+        && interrupts.get_ready_interrupt() == NO_INTERRUPT;
+}
+
+instruction_t LockstepCPU::fetch(unsigned lane_no, uint16_t address) {
+    Bus &bus = lanes[lane_no]->bus;
+    instruction_t instruction;
+    instruction.fields.operation = bus.read(address);
+    unsigned length = lockstep_instr_length(instruction.fields.operation);
+    for (unsigned i = 1; i < length; ++i) {
+        instruction.raw[i] = bus.read((address + i) & 0xFFFF);
+    }
+    return instruction;
+}
+
+void LockstepCPU::exec_scalar(unsigned lane_no, uint64_t target_cycle) {
+    CPU &cpu = lanes[lane_no]->cpu;
+    Scheduler &scheduler = lanes[lane_no]->bus.scheduler;
+    Interrupts &interrupts = lanes[lane_no]->bus.io.interrupts;
+    store_lane(lane_no);
+    uint64_t instr_count_before = cpu.executed_instr_count;
+    uint64_t step_end = scheduler.get_cycles() + 1; // Exactly one instruction
+    if (cpu.is_halted && !interrupts.is_interrupt_pending() && !interrupts.get_is_IME_flag_enabling_scheduled()) {
+        // Let the CPU skip straight to the event that may wake it up
+        step_end = std::max(step_end, std::min(target_cycle, scheduler.get_next_event_cycle()));
+    }
+    cpu.run_until(step_end);
+    scalar_instr_count += cpu.executed_instr_count - instr_count_before;
+    load_lane(lane_no);
+}
+
+int LockstepCPU::exec_lockstep(instruction_t instruction) {
+    uint8_t opcode = instruction.fields.operation;
+    unsigned length = lockstep_instr_length(opcode);
+    if (length == 0) {
+        return 0;
+    }
+    unsigned reg_x = (opcode >> 3) & 0x7;
+    unsigned reg_y = opcode & 0x7;
+    alignas(64) uint8_t immediate[MAX_LANES];
+    std::fill(immediate, immediate + MAX_LANES, instruction.fields.param1);
+
+    for (unsigned i = 0; i < MAX_LANES; ++i) {
+        regPC[i] = group_mask[i] ? (regPC[i] + length) & 0xFFFF : regPC[i];
+    }
+
+    if (opcode == 0x00) { // NOP
+        return 4;
+    }
+    if (opcode >= 0x40 && opcode <= 0x7F) { // LD r,r
+        uint8_t *destination = regs8[reg_x];
+        const uint8_t *source = regs8[reg_y];
+        for (unsigned i = 0; i < MAX_LANES; ++i) {
+            destination[i] = blend(group_mask[i], source[i], destination[i]);
+        }
+        return 4;
+    }
+    if (opcode >= 0x80 && opcode <= 0xBF) { // ALU A,r
+        exec_ALU(reg_x, regs8[reg_y]);
+        return 4;
+    }
+    if ((opcode & 0xC7) == 0xC6) { // ALU A,n
+        exec_ALU(reg_x, immediate);
+        return 8;
+    }
+    switch (opcode & 0xC7) {
+        case 0x04: // INC r
+            exec_INC_DEC_8bit(reg_x, false);
+            return 4;
+        case 0x05: // DEC r
+            exec_INC_DEC_8bit(reg_x, true);
+            return 4;
+        case 0x06: { // LD r,n
+            uint8_t *destination = regs8[reg_x];
+            for (unsigned i = 0; i < MAX_LANES; ++i) {
+                destination[i] = blend(group_mask[i], immediate[i], destination[i]);
+            }
+            return 8;
+        }
+    }
+    switch (opcode & 0xCF) {
+        case 0x03: // INC rr
+            exec_INC_DEC_16bit(reg_x >> 1, false);
+            return 8;
+        case 0x0B: // DEC rr
+            exec_INC_DEC_16bit(reg_x >> 1, true);
+            return 8;
+    }
+    switch (opcode) {
+        case 0x18: // JR n
+            exec_jump(0, false, true, instruction);
+            return 8;
+        case 0x20: // JR cc,n
+        case 0x28:
+        case 0x30:
+        case 0x38:
+            exec_jump((opcode >> 3) & 0x3, true, true, instruction);
+            return 8;
+        case 0xC3: // JP adr
+            exec_jump(0, false, false, instruction);
+            return 12;
+        case 0xC2: // JP cc,adr
+        case 0xCA:
+        case 0xD2:
+        case 0xDA:
+            exec_jump((opcode >> 3) & 0x3, true, false, instruction);
+            return 12;
+    }
+    return 0;
+}
+
+inline uint16_t LockstepCPU::get_reg16(unsigned pair_no, unsigned lane_no) {
+    if (pair_no == 3) {
+        return regSP[lane_no];
+    }
+    return (regs8[pair_no * 2][lane_no] << 8) | regs8[pair_no * 2 + 1][lane_no];
+}
+
+inline void LockstepCPU::set_reg16(unsigned pair_no, unsigned lane_no, uint16_t value) {
+    if (pair_no == 3) {
+        regSP[lane_no] = value;
+    } else {
+        regs8[pair_no * 2][lane_no] = value >> 8;
+        regs8[pair_no * 2 + 1][lane_no] = value & 0xFF;
+    }
+}
+
+/**
+ * Executes one of the 8 ALU operations (ADD, ADC, SUB, SBC, AND, XOR, OR, CP) on register A of all lanes in the group
+ * Flags are calculated the same way as in the scalar CPU
+ */
+void LockstepCPU::exec_ALU(unsigned op, const uint8_t *operand) {
+    uint8_t *regA = regs8[REG_A];
+    switch (op) {
+        case 0: // ADD
+        case 1: // ADC
+            for (unsigned i = 0; i < MAX_LANES; ++i) {
+                int carry = (op == 1) ? ((flags[i] & FLAG_C) ? 1 : 0) : 0;
+                int result = regA[i] + operand[i] + carry;
+                uint8_t result8bit = result & 0xFF;
+                uint8_t new_flags = (flags[i] & 0x0F)
+                    | ((result8bit == 0) ? FLAG_Z : 0)
+                    | ((((regA[i] & 0x0F) + (operand[i] & 0x0F) + carry) > 0x0F) ? FLAG_H : 0)
+                    | ((result >= 0x100) ? FLAG_C : 0);
+                regA[i] = blend(group_mask[i], result8bit, regA[i]);
+                flags[i] = blend(group_mask[i], new_flags, flags[i]);
+            }
+            break;
+        case 2: // SUB
+        case 3: // SBC
+        case 7: // CP
+            for (unsigned i = 0; i < MAX_LANES; ++i) {
+                int borrow = (op == 3) ? ((flags[i] & FLAG_C) ? 1 : 0) : 0;
+                int result = regA[i] - operand[i] - borrow;
+                uint8_t result8bit = result & 0xFF;
+                uint8_t new_flags = (flags[i] & 0x0F) | FLAG_N
+                    | ((result8bit == 0) ? FLAG_Z : 0)
+                    | (((regA[i] & 0x0F) < ((operand[i] & 0x0F) + borrow)) ? FLAG_H : 0)
+                    | ((result < 0) ? FLAG_C : 0);
+                regA[i] = blend(group_mask[i] & ((op == 7) ? 0 : 0xFF), result8bit, regA[i]);
+                flags[i] = blend(group_mask[i], new_flags, flags[i]);
+            }
+            break;
+        case 4: // AND
+        case 5: // XOR
+        case 6: // OR
+            for (unsigned i = 0; i < MAX_LANES; ++i) {
+                uint8_t result = (op == 4) ? (regA[i] & operand[i]) : ((op == 5) ? (regA[i] ^ operand[i]) : (regA[i] | operand[i]));
+                uint8_t new_flags = (flags[i] & 0x0F)
+                    | ((result == 0) ? FLAG_Z : 0)
+                    | ((op == 4) ? FLAG_H : 0);
+                regA[i] = blend(group_mask[i], result, regA[i]);
+                flags[i] = blend(group_mask[i], new_flags, flags[i]);
+            }
+            break;
+    }
+}
+
+void LockstepCPU::exec_INC_DEC_8bit(unsigned reg_no, bool is_decrement) {
+    uint8_t *reg = regs8[reg_no];
+    for (unsigned i = 0; i < MAX_LANES; ++i) {
+        uint8_t result = is_decrement ? reg[i] - 1 : reg[i] + 1;
+        bool half_carry = is_decrement ? ((reg[i] & 0x0F) == 0) : ((reg[i] & 0x0F) == 0x0F);
+        uint8_t new_flags = (flags[i] & (FLAG_C | 0x0F))
+            | ((result == 0) ? FLAG_Z : 0)
+            | (is_decrement ? FLAG_N : 0)
+            | (half_carry ? FLAG_H : 0);
+        reg[i] = blend(group_mask[i], result, reg[i]);
+        flags[i] = blend(group_mask[i], new_flags, flags[i]);
+    }
+}
+
+void LockstepCPU::exec_INC_DEC_16bit(unsigned pair_no, bool is_decrement) {
+    for (unsigned i = 0; i < lane_count; ++i) {
+        if (group_mask[i]) {
+            uint16_t value = get_reg16(pair_no, i);
+            set_reg16(pair_no, i, is_decrement ? value - 1 : value + 1);
+        }
+    }
+}
+
+/**
+ * Conditions are encoded as in the opcodes: 0 - NZ, 1 - Z, 2 - NC, 3 - C
+ */
+void LockstepCPU::exec_jump(unsigned condition, bool is_conditional, bool is_relative, instruction_t instruction) {
+    uint8_t condition_flag = (condition < 2) ? FLAG_Z : FLAG_C;
+    bool expected_flag_state = condition & 0x1;
+    int8_t offset = static_cast<int8_t>(instruction.fields.param1);
+    uint16_t address = instruction.fields.param1 | (instruction.fields.param2 << 8);
+    for (unsigned i = 0; i < MAX_LANES; ++i) {
+        bool is_taken = group_mask[i] && (!is_conditional || (((flags[i] & condition_flag) != 0) == expected_flag_state));
+        uint16_t jump_target = is_relative ? (regPC[i] + offset) & 0xFFFF : address;
+        regPC[i] = is_taken ? jump_target : regPC[i];
+    }
+}
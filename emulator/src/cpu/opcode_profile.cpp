@@ -0,0 +1,81 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include "cpu/opcode_profile.h"
+
+OpcodeProfile::OpcodeProfile() {
+    reset();
+}
+
+OpcodeProfile::~OpcodeProfile() {
+
+}
+
+void OpcodeProfile::reset() {
+    memset(counters, 0, sizeof(counters));
+    memset(CB_counters, 0, sizeof(CB_counters));
+}
+
+void OpcodeProfile::write_CSV(std::ostream &stream) {
+    stream << "prefix,opcode,count,cycles,taken,not_taken\n";
+    char line[128];
+    for (unsigned prefixed = 0; prefixed < 2; ++prefixed) {
+        const counter_t *table = prefixed ? CB_counters : counters;
+        for (unsigned opcode = 0; opcode < 256; ++opcode) {
+            const counter_t &counter = table[opcode];
+            if (counter.count == 0) {
+                continue;
+            }
+            snprintf(line, sizeof(line), "%s,0x%02X,%llu,%llu,%llu,%llu\n", prefixed ? "CB" : "", opcode,
+                (unsigned long long)counter.count, (unsigned long long)counter.cycles,
+                (unsigned long long)counter.taken, (unsigned long long)counter.not_taken);
+            stream << line;
+        }
+    }
+}
+
+void OpcodeProfile::write_JSON(std::ostream &stream) {
+    char line[192];
+    stream << "{\n";
+    for (unsigned prefixed = 0; prefixed < 2; ++prefixed) {
+        const counter_t *table = prefixed ? CB_counters : counters;
+        stream << (prefixed ? "  \"cb_opcodes\": [" : "  \"opcodes\": [");
+        bool is_first = true;
+        for (unsigned opcode = 0; opcode < 256; ++opcode) {
+            const counter_t &counter = table[opcode];
+            if (counter.count == 0) {
+                continue;
+            }
+            snprintf(line, sizeof(line), "%s\n    {\"opcode\": \"0x%02X\", \"count\": %llu, \"cycles\": %llu",
+                is_first ? "" : ",", opcode, (unsigned long long)counter.count, (unsigned long long)counter.cycles);
+            stream << line;
+            if (!prefixed && is_conditional(opcode)) {
+                snprintf(line, sizeof(line), ", \"taken\": %llu, \"not_taken\": %llu",
+                    (unsigned long long)counter.taken, (unsigned long long)counter.not_taken);
+                stream << line;
+            }
+            stream << "}";
+            is_first = false;
+        }
+        stream << (is_first ? "]" : "\n  ]") << (prefixed ? "\n" : ",\n");
+    }
+    stream << "}\n";
+}
+
+void OpcodeProfile::save_to_file(const std::string &file_path) {
+    std::ofstream file(file_path);
+    if (!file.good()) {
+        throw std::runtime_error("Cannot open file: " + file_path);
+    }
+    const std::string JSON_EXTENSION = ".json";
+    if (file_path.size() >= JSON_EXTENSION.size()
+        && file_path.compare(file_path.size() - JSON_EXTENSION.size(), JSON_EXTENSION.size(), JSON_EXTENSION) == 0) {
+        write_JSON(file);
+    } else {
+        write_CSV(file);
+    }
+    if (!file.good()) {
+        throw std::runtime_error("Cannot write opcode profile to file: " + file_path);
+    }
+}
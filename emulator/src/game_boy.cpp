@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include "game_boy.h"
+#include "save_state.h"
+
+const uint64_t GameBoy::FRAME_CYCLES;
+
+GameBoy::GameBoy(): GameBoy(null_logger) {
+
+}
+
+GameBoy::GameBoy(Logger &logger): cpu(bus, logger), ppu(bus) {
+    this->logger = (&logger != &null_logger) ? &logger : nullptr;
+    pressed_buttons = 0;
+}
+
+GameBoy::~GameBoy() {
+
+}
+
+void GameBoy::load_cartridge_from_file(std::string file_path) {
+    bus.load_cartridge_from_file(file_path);
+    restart();
+}
+
+void GameBoy::load_cartridge_from_memory(const uint8_t *ROM_image, size_t image_size) {
+    bus.load_cartridge_from_memory(ROM_image, image_size);
+    restart();
+}
+
+void GameBoy::restart() {
+    cpu.restart();
+    ppu.restart();
+    set_pressed_buttons(0);
+}
+
+void GameBoy::run_frames(unsigned frame_count) {
+    for (unsigned i = 0; i < frame_count; ++i) {
+        uint64_t start_frame = ppu.get_frame_count();
+        uint64_t deadline = bus.scheduler.get_cycles() + FRAME_CYCLES;
+        // VBlank is a scheduled event, so running to the next event never overshoots it
+        while (ppu.get_frame_count() == start_frame && bus.scheduler.get_cycles() < deadline) {
+            cpu.run_until(std::min(deadline, bus.scheduler.get_next_event_cycle()));
+        }
+    }
+}
+
+void GameBoy::run_cycles(uint64_t cycle_count) {
+    cpu.run_until(bus.scheduler.get_cycles() + cycle_count);
+}
+
+void GameBoy::set_button(Joypad::btn_type_t button, Joypad::btn_state_t state) {
+    bus.io.joypad.btn_change_state(button, state);
+    // Kept in sync, so set_pressed_buttons sees the buttons changed one at a time too
+    if (state == Joypad::PRESSED) {
+        pressed_buttons |= 1 << button;
+    } else {
+        pressed_buttons &= ~(1 << button);
+    }
+}
+
+void GameBoy::set_pressed_buttons(uint8_t button_mask) {
+    uint8_t changed = pressed_buttons ^ button_mask;
+    for (unsigned button = Joypad::RIGHT; button <= Joypad::SELECT; ++button) {
+        if (changed & (1 << button)) {
+            set_button(static_cast<Joypad::btn_type_t>(button), (button_mask & (1 << button)) ? Joypad::PRESSED : Joypad::NOT_PRESSED);
+        }
+    }
+    pressed_buttons = button_mask;
+}
+
+size_t GameBoy::get_state_size() {
+    Cartridge *cartridge = bus.get_cartridge();
+    return sizeof(save_state_header_t)
+        + get_machine_state_size()
+        + save_state_block_size((cartridge != nullptr) ? cartridge->get_state_size() : 0);
+}
+
+size_t GameBoy::get_machine_state_size() {
+    return save_state_block_size(sizeof(state_t))
+        + save_state_block_size(sizeof(CPU::state_t))
+        + save_state_block_size(sizeof(Scheduler::state_t))
+        + save_state_block_size(sizeof(Bus::state_t))
+        + save_state_block_size(sizeof(IO::state_t))
+        + save_state_block_size(sizeof(Interrupts::state_t))
+        + save_state_block_size(sizeof(Timer::state_t))
+        + save_state_block_size(sizeof(Joypad::state_t))
+        + save_state_block_size(sizeof(VideoRAM::state_t))
+        + save_state_block_size(sizeof(WorkRAM::state_t))
+        + save_state_block_size(sizeof(ObjectAttributeMemory::state_t))
+        + save_state_block_size(sizeof(PPU::state_t));
+}
+
+void GameBoy::save_state(std::vector<uint8_t> &buffer) {
+    buffer.resize(get_state_size());
+    save_state_header_t header = {SAVE_STATE_MAGIC, SAVE_STATE_VERSION, bus.get_ROM_hash(), buffer.size()};
+    memcpy(buffer.data(), &header, sizeof(header));
+
+    SaveStateWriter writer(buffer.data() + sizeof(header));
+    write_machine_blocks(writer);
+    Cartridge *cartridge = bus.get_cartridge();
+    size_t cartridge_state_size = (cartridge != nullptr) ? cartridge->get_state_size() : 0;
+    uint8_t *cartridge_state = writer.begin_block(BLOCK_CARTRIDGE, cartridge_state_size);
+    if (cartridge != nullptr) {
+        cartridge->save_state(cartridge_state);
+    }
+}
+
+void GameBoy::load_state(const uint8_t *state, size_t size) {
+    save_state_header_t header;
+    if (size < sizeof(header)) {
+        throw std::runtime_error("Save state is truncated");
+    }
+    memcpy(&header, state, sizeof(header));
+    if (header.magic != SAVE_STATE_MAGIC) {
+        throw std::runtime_error("Not a save state");
+    }
+    if (header.version != SAVE_STATE_VERSION) {
+        throw std::runtime_error("Save state version " + std::to_string(header.version) + " isn't supported");
+    }
+    if (header.ROM_hash != bus.get_ROM_hash()) {
+        throw std::runtime_error("Save state was made with another ROM");
+    }
+    // With the same version and cartridge all blocks have known sizes, so this validates the whole layout
+    if (header.size != size || size != get_state_size()) {
+        throw std::runtime_error("Save state has incorrect size");
+    }
+    // Blocks are used in place, unless the state isn't aligned
+    std::vector<uint64_t> aligned_copy;
+    if (reinterpret_cast<uintptr_t>(state) % SAVE_STATE_ALIGNMENT != 0) {
+        aligned_copy.resize((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        memcpy(aligned_copy.data(), state, size);
+        state = reinterpret_cast<const uint8_t *>(aligned_copy.data());
+    }
+
+    // Every block header is checked before anything is loaded
+    SaveStateReader validator(state + sizeof(header), size - sizeof(header), true);
+    read_blocks(validator);
+    SaveStateReader reader(state + sizeof(header), size - sizeof(header));
+    read_blocks(reader);
+}
+
+std::unique_ptr<GameBoy> GameBoy::fork() {
+    std::unique_ptr<GameBoy> child = (logger != nullptr) ? std::make_unique<GameBoy>(*logger) : std::make_unique<GameBoy>();
+    child->bus.insert_forked_cartridge(bus);
+    child->ppu.set_render_mode(ppu.get_render_mode(), ppu.get_render_frame_interval());
+    std::vector<uint64_t> state((get_machine_state_size() + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    uint8_t *state_bytes = reinterpret_cast<uint8_t *>(state.data());
+    SaveStateWriter writer(state_bytes);
+    write_machine_blocks(writer);
+    SaveStateReader reader(state_bytes, get_machine_state_size());
+    child->read_machine_blocks(reader);
+    return child;
+}
+
+void GameBoy::write_machine_blocks(SaveStateWriter &writer) {
+    writer.write_block(BLOCK_GAME_BOY, *this);
+    writer.write_block(BLOCK_CPU, cpu);
+    writer.write_block(BLOCK_SCHEDULER, bus.scheduler);
+    writer.write_block(BLOCK_BUS, bus);
+    writer.write_block(BLOCK_IO, bus.io);
+    writer.write_block(BLOCK_INTERRUPTS, bus.io.interrupts);
+    writer.write_block(BLOCK_TIMER, bus.io.timer);
+    writer.write_block(BLOCK_JOYPAD, bus.io.joypad);
+    writer.write_block(BLOCK_VRAM, bus.vram);
+    writer.write_block(BLOCK_WRAM, bus.wram);
+    writer.write_block(BLOCK_OAM, bus.oam);
+    writer.write_block(BLOCK_PPU, ppu);
+}
+
+void GameBoy::read_machine_blocks(SaveStateReader &reader) {
+    reader.read_block(BLOCK_GAME_BOY, *this);
+    reader.read_block(BLOCK_CPU, cpu);
+    reader.read_block(BLOCK_SCHEDULER, bus.scheduler);
+    reader.read_block(BLOCK_BUS, bus);
+    reader.read_block(BLOCK_IO, bus.io);
+    reader.read_block(BLOCK_INTERRUPTS, bus.io.interrupts);
+    reader.read_block(BLOCK_TIMER, bus.io.timer);
+    reader.read_block(BLOCK_JOYPAD, bus.io.joypad);
+    reader.read_block(BLOCK_VRAM, bus.vram);
+    reader.read_block(BLOCK_WRAM, bus.wram);
+    reader.read_block(BLOCK_OAM, bus.oam);
+    reader.read_block(BLOCK_PPU, ppu);
+}
+
+void GameBoy::read_blocks(SaveStateReader &reader) {
+    read_machine_blocks(reader);
+    Cartridge *cartridge = bus.get_cartridge();
+    size_t cartridge_state_size = (cartridge != nullptr) ? cartridge->get_state_size() : 0;
+    const uint8_t *cartridge_state = reader.next_block(BLOCK_CARTRIDGE, cartridge_state_size);
+    if (cartridge != nullptr && !reader.get_is_dry_run()) {
+        cartridge->load_state(cartridge_state);
+    }
+}
+
+void GameBoy::save_state(state_t &state) {
+    state.pressed_buttons = pressed_buttons;
+}
+
+void GameBoy::load_state(const state_t &state) {
+    pressed_buttons = state.pressed_buttons;
+}
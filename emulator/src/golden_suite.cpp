@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "golden_suite.h"
+
+GoldenSuite::GoldenSuite() {
+
+}
+
+GoldenSuite::~GoldenSuite() {
+
+}
+
+void GoldenSuite::load_from_file(std::string file_path) {
+    std::ifstream file(file_path);
+    if (!file.good()) {
+        throw std::runtime_error("Cannot open file: " + file_path);
+    }
+    size_t separator = file_path.find_last_of('/');
+    std::string directory = (separator == std::string::npos) ? "" : file_path.substr(0, separator + 1);
+    auto resolve = [&directory](const std::string &path) {
+        return (path.empty() || path[0] == '/') ? path : directory + path;
+    };
+
+    entries.clear();
+    comments.clear();
+    std::string line, token;
+    int line_no = 0;
+    while (std::getline(file, line)) {
+        ++line_no;
+        if (line.find_first_not_of(" \t") == std::string::npos || line[line.find_first_not_of(" \t")] == '#') {
+            comments.push_back({entries.size(), line});
+            continue;
+        }
+        std::istringstream line_stream(line);
+        entry_t entry;
+        line_stream >> entry.ROM_name;
+        try {
+            while (line_stream >> token) {
+                if (token.rfind("input=", 0) == 0) {
+                    entry.input_script_name = token.substr(strlen("input="));
+                    continue;
+                }
+                checkpoint_t checkpoint;
+                size_t equals = token.find('=');
+                checkpoint.frame = std::stoull(token.substr(0, equals));
+                checkpoint.has_hash = (equals != std::string::npos);
+                checkpoint.hash = checkpoint.has_hash ? std::stoull(token.substr(equals + 1), nullptr, 16) : 0;
+                entry.checkpoints.push_back(checkpoint);
+            }
+        } catch (std::logic_error &e) {
+            throw std::runtime_error("Invalid golden suite line " + std::to_string(line_no) + ": " + line);
+        }
+        std::stable_sort(entry.checkpoints.begin(), entry.checkpoints.end(), [](const checkpoint_t &a, const checkpoint_t &b) {
+            return a.frame < b.frame;
+        });
+        if (entry.checkpoints.empty() || entry.checkpoints.front().frame == 0) {
+            throw std::runtime_error("No checkpoints (from frame 1) in golden suite line " + std::to_string(line_no) + ": " + line);
+        }
+        entry.ROM_path = resolve(entry.ROM_name);
+        entry.input_script_path = resolve(entry.input_script_name);
+        entries.push_back(entry);
+    }
+}
+
+void GoldenSuite::save_to_file(std::string file_path) {
+    std::ofstream file(file_path);
+    if (!file.good()) {
+        throw std::runtime_error("Cannot open file: " + file_path);
+    }
+    size_t next_comment = 0;
+    for (size_t i = 0; i <= entries.size(); ++i) {
+        while (next_comment < comments.size() && comments[next_comment].first == i) {
+            file << comments[next_comment++].second << std::endl;
+        }
+        if (i == entries.size()) {
+            break;
+        }
+        file << entries[i].ROM_name;
+        if (!entries[i].input_script_name.empty()) {
+            file << " input=" << entries[i].input_script_name;
+        }
+        for (const checkpoint_t &checkpoint: entries[i].checkpoints) {
+            file << " " << checkpoint.frame;
+            if (checkpoint.has_hash) {
+                char hash[17];
+                snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)checkpoint.hash);
+                file << "=" << hash;
+            }
+        }
+        file << std::endl;
+    }
+}
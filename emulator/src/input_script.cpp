@@ -0,0 +1,79 @@
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include "input_script.h"
+
+InputScript::InputScript() {
+    next_event = 0;
+}
+
+InputScript::~InputScript() {
+
+}
+
+void InputScript::load_from_file(std::string file_path) {
+    std::ifstream file(file_path);
+    if (!file.good()) {
+        throw std::runtime_error("Cannot open file: " + file_path);
+    }
+    std::string line, button, state;
+    input_event_t event;
+    int line_no = 0;
+    while (std::getline(file, line)) {
+        ++line_no;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream line_stream(line);
+        if (!(line_stream >> event.frame >> button >> state)) {
+            throw std::runtime_error("Invalid input script line " + std::to_string(line_no) + ": " + line);
+        }
+        event.button = parse_button(button);
+        if (state == "press") {
+            event.state = Joypad::btn_state_t::PRESSED;
+        } else if (state == "release") {
+            event.state = Joypad::btn_state_t::NOT_PRESSED;
+        } else {
+            throw std::runtime_error("Invalid button state in input script line " + std::to_string(line_no) + ": " + state);
+        }
+        events.push_back(event);
+    }
+    // Changes in the same frame keep the order from the file
+    std::stable_sort(events.begin(), events.end(), [](const input_event_t &a, const input_event_t &b) {
+        return a.frame < b.frame;
+    });
+    next_event = 0;
+}
+
+void InputScript::apply(GameBoy &game_boy, uint64_t frame) {
+    while (next_event < events.size() && events[next_event].frame <= frame) {
+        game_boy.set_button(events[next_event].button, events[next_event].state);
+        ++next_event;
+    }
+}
+
+bool InputScript::is_finished() {
+    return next_event >= events.size();
+}
+
+Joypad::btn_type_t InputScript::parse_button(const std::string &name) {
+    if (name == "right") {
+        return Joypad::btn_type_t::RIGHT;
+    } else if (name == "left") {
+        return Joypad::btn_type_t::LEFT;
+    } else if (name == "up") {
+        return Joypad::btn_type_t::UP;
+    } else if (name == "down") {
+        return Joypad::btn_type_t::DOWN;
+    } else if (name == "a") {
+        return Joypad::btn_type_t::A;
+    } else if (name == "b") {
+        return Joypad::btn_type_t::B;
+    } else if (name == "start") {
+        return Joypad::btn_type_t::START;
+    } else if (name == "select") {
+        return Joypad::btn_type_t::SELECT;
+    }
+    throw std::runtime_error("Unknown button in input script: " + name);
+}
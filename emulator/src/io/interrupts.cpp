@@ -96,3 +96,17 @@ void Interrupts::mark_used(intr_type_t type) {
             break;
     }
 }
+
+void Interrupts::save_state(state_t &state) {
+    state.interrupt_flag = interrupt_flag.value;
+    state.interrupt_enable = interrupt_enable.value;
+    state.IME_flag = IME_flag;
+    state.is_IME_flag_enabling_scheduled = is_IME_flag_enabling_scheduled;
+}
+
+void Interrupts::load_state(const state_t &state) {
+    interrupt_flag.value = state.interrupt_flag;
+    interrupt_enable.value = state.interrupt_enable;
+    IME_flag = state.IME_flag;
+    is_IME_flag_enabling_scheduled = state.is_IME_flag_enabling_scheduled;
+}
@@ -1,6 +1,11 @@
+#include <cstring>
 #include "io/io.h"
+#include "ppu/ppu.h"
 
 IO::IO() {
+    memset(data, 0, sizeof(data));
+    ppu = nullptr;
+    serial_listener = nullptr;
     timer.attach_interrupts_handler(&interrupts);
     joypad.attach_interrupts_handler(&interrupts);
 }
@@ -9,6 +14,14 @@ IO::~IO() {
 
 }
 
+void IO::attach_PPU(PPU *ppu) {
+    this->ppu = ppu;
+}
+
+void IO::attach_serial_listener(SerialListenerInterface *listener) {
+    serial_listener = listener;
+}
+
 void IO::write(uint16_t address, uint8_t value) {
     // TODO: Make all IO's use references to shared memory instead of this
     if (address == 0xFF00) { // Joypad
@@ -19,6 +32,14 @@ void IO::write(uint16_t address, uint8_t value) {
         interrupts.interrupt_enable.value = value;
     } else if (address >= 0xFF04 && address <= 0xFF07) {
         timer.write(address, value);
+    } else if (address == 0xFF02 && serial_listener != nullptr && (value & 0x81) == 0x81) { // Serial transfer start
+        serial_listener->serial_byte_sent(data[0x01]);
+        data[0x02] = value & 0x7F;
+    } else if (ppu != nullptr && address >= LCD_REGISTERS_START && address <= LCD_REGISTERS_END) {
+        ppu->sync();
+        uint8_t old_value = data[address-0xFF00];
+        data[address-0xFF00] = value;
+        ppu->register_written(address, old_value);
     } else {
         data[address-0xFF00] = value;
     }
@@ -35,7 +56,18 @@ uint8_t IO::read(uint16_t address) {
     } else if (address >= 0xFF04 && address <= 0xFF07) {
         value = timer.read(address);
     } else {
+        if (ppu != nullptr && address >= LCD_REGISTERS_START && address <= LCD_REGISTERS_END) {
+            ppu->sync();
+        }
         value = data[address-0xFF00];
     }
     return value;
 }
+
+void IO::save_state(state_t &state) {
+    memcpy(state.data, data, sizeof(data));
+}
+
+void IO::load_state(const state_t &state) {
+    memcpy(data, state.data, sizeof(data));
+}
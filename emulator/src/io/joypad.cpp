@@ -3,7 +3,10 @@
 
 Joypad::Joypad() {
     // TODO: What about those unused bits?
-    memset(btn_states, NOT_PRESSED, 8 * sizeof(btn_state_t));
+    // memset would fill every byte of the enums, not the enums themselves
+    for (unsigned button = RIGHT; button <= SELECT; ++button) {
+        btn_states[button] = NOT_PRESSED;
+    }
 }
 
 Joypad::~Joypad() {
@@ -25,6 +28,16 @@ void Joypad::btn_change_state(btn_type_t button, btn_state_t new_state) {
     btn_states[button] = new_state;
 }
 
+uint8_t Joypad::get_pressed_buttons() {
+    uint8_t pressed_buttons = 0;
+    for (unsigned button = RIGHT; button <= SELECT; ++button) {
+        if (btn_states[button] == PRESSED) {
+            pressed_buttons |= (1 << button);
+        }
+    }
+    return pressed_buttons;
+}
+
 uint8_t Joypad::get_data_reg_val() {
     if (data_reg.bits.select_action_btns == btn_select_t::SELECTED) {
         data_reg.bits.right_or_A = btn_states[btn_type_t::A];
@@ -46,3 +59,17 @@ uint8_t Joypad::get_data_reg_val() {
 void Joypad::set_data_reg_val(uint8_t value) {
     data_reg.value = value;
 }
+
+void Joypad::save_state(state_t &state) {
+    state.data_reg = data_reg.value;
+    for (int i = 0; i < 8; ++i) {
+        state.btn_states[i] = btn_states[i];
+    }
+}
+
+void Joypad::load_state(const state_t &state) {
+    data_reg.value = state.data_reg;
+    for (int i = 0; i < 8; ++i) {
+        btn_states[i] = static_cast<btn_state_t>(state.btn_states[i]);
+    }
+}
@@ -2,14 +2,17 @@
 
 // TODO: Implement timer obscure behaviour - https://gbdev.io/pandocs/Timer_Obscure_Behaviour.html
 Timer::Timer() {
-    DIV_CPU_clock_counter = 0;
-    TIMA_CPU_clock_counter = 0;
+    interrupts = nullptr;
+    scheduler = nullptr;
     is_DIV_stopped = false;
     // Set the initial values // TODO: Add reset function
     timer_data.DIV = 0xAB;
     timer_data.TIMA = 0x00;
     timer_data.TMA = 0x00;
     timer_data.TAC.value = 0xF8;
+    // Internal counter starts at 0xAB00 so DIV reads 0xAB at power on
+    DIV_reset_cycle = 0 - (static_cast<uint64_t>(timer_data.DIV) << 8);
+    TIMA_sync_cycle = 0;
 }
 
 Timer::~Timer() {
@@ -20,44 +23,47 @@ void Timer::attach_interrupts_handler(Interrupts *interrupts) {
     this->interrupts = interrupts; // TODO: Maybe do it differently
 }
 
-void Timer::tick(unsigned cpu_cycles) {
-    if (!is_DIV_stopped) {
-        DIV_CPU_clock_counter += cpu_cycles;
-        // DIV is incremented at a rate of 16384Hz which is equal to 256 CPU clock cycles
-        if (DIV_CPU_clock_counter >= 256) { // TODO: 256 or 255 xd
-            timer_data.DIV = (timer_data.DIV + 1) & 0xFF;
-        }
-        DIV_CPU_clock_counter %= 256;
-    }
+void Timer::attach_scheduler(Scheduler *scheduler) {
+    this->scheduler = scheduler;
+    scheduler->attach_handler(event_type_t::TIMER_OVERFLOW, this);
+    DIV_reset_cycle += scheduler->get_cycles();
+    TIMA_sync_cycle = scheduler->get_cycles();
+    schedule_TIMA_overflow();
+}
 
-    if (timer_data.TAC.mode.timer_enabled) {
-        TIMA_CPU_clock_counter += cpu_cycles;
-        if (TIMA_CPU_clock_counter >= CLK_DIVIDER_LOOKUP[timer_data.TAC.mode.clk_divider]) { // TODO: Same as above xd
-            // Timer will overflow when incremented
-            if (timer_data.TIMA == 0xFF) {
-                timer_data.TIMA = timer_data.TMA;
-                interrupts->signal(intr_type_t::TIMER);
-            } else {
-                ++timer_data.TIMA;
-            }
-            TIMA_CPU_clock_counter %= CLK_DIVIDER_LOOKUP[timer_data.TAC.mode.clk_divider];
-        }
+void Timer::handle_event(event_type_t type) {
+    if (type == event_type_t::TIMER_OVERFLOW) {
+        // TIMA overflowed exactly at the scheduled cycle, the rest is counted from there
+        TIMA_sync_cycle = DIV_reset_cycle + (((TIMA_sync_cycle - DIV_reset_cycle) / get_TAC_clock_divider())
+            + (0x100 - timer_data.TIMA)) * get_TAC_clock_divider();
+        timer_data.TIMA = timer_data.TMA;
+        interrupts->signal(intr_type_t::TIMER);
+        sync_TIMA();
+        schedule_TIMA_overflow();
     }
 }
 
 void Timer::stop_DIV() {
+    sync_TIMA();
     reset_DIV_counter();
     is_DIV_stopped = true;
+    schedule_TIMA_overflow();
 }
 
 void Timer::run_DIV_after_stop() {
-    is_DIV_stopped = false;
+    if (is_DIV_stopped) {
+        is_DIV_stopped = false;
+        reset_DIV_counter();
+        TIMA_sync_cycle = get_cycles();
+        schedule_TIMA_overflow();
+    }
 }
 
 void Timer::write(uint16_t address, uint8_t value) {
+    sync_TIMA();
     switch (address) {
-        case 0xFF04:
-            timer_data.DIV = value;
+        case 0xFF04: // Writing any value resets DIV
+            reset_DIV_counter();
             break;
         case 0xFF05:
             timer_data.TIMA = value;
@@ -71,16 +77,17 @@ void Timer::write(uint16_t address, uint8_t value) {
         default:
             break;
     }
+    schedule_TIMA_overflow();
 }
 
 uint8_t Timer::read(uint16_t address) {
     uint8_t value = 0;
     switch (address) {
         case 0xFF04:
-            value = timer_data.DIV;
+            value = get_DIV();
             break;
         case 0xFF05:
-            value = timer_data.TIMA = value;
+            value = get_TIMA();
             break;
         case 0xFF06:
             value = timer_data.TMA;
@@ -94,16 +101,52 @@ uint8_t Timer::read(uint16_t address) {
     return value;
 }
 
+inline uint64_t Timer::get_cycles() {
+    return (scheduler != nullptr) ? scheduler->get_cycles() : 0;
+}
+
 inline void Timer::reset_DIV_counter() {
-    timer_data.DIV = 0;
-    DIV_CPU_clock_counter = 0;
+    DIV_reset_cycle = get_cycles();
+}
+
+/**
+ * Adds TIMA increments that happened since the last sync. TIMA is incremented each time
+ * the internal counter reaches a multiple of the selected divider
+ */
+inline void Timer::sync_TIMA() {
+    uint64_t current_cycle = get_cycles();
+    if (timer_data.TAC.mode.timer_enabled && !is_DIV_stopped) {
+        unsigned divider = get_TAC_clock_divider();
+        uint64_t increments = (current_cycle - DIV_reset_cycle) / divider - (TIMA_sync_cycle - DIV_reset_cycle) / divider;
+        // Overflow is a scheduled event, so there will never be enough increments to pass 0xFF here
+        timer_data.TIMA += increments;
+    }
+    TIMA_sync_cycle = current_cycle;
+}
+
+inline void Timer::schedule_TIMA_overflow() {
+    if (scheduler == nullptr) {
+        return;
+    }
+    if (timer_data.TAC.mode.timer_enabled && !is_DIV_stopped) {
+        unsigned divider = get_TAC_clock_divider();
+        uint64_t overflow_cycle = DIV_reset_cycle + (((TIMA_sync_cycle - DIV_reset_cycle) / divider)
+            + (0x100 - timer_data.TIMA)) * divider;
+        scheduler->schedule(event_type_t::TIMER_OVERFLOW, overflow_cycle);
+    } else {
+        scheduler->cancel(event_type_t::TIMER_OVERFLOW);
+    }
 }
 
 uint8_t Timer::get_DIV() {
-    return timer_data.DIV;
+    if (is_DIV_stopped) {
+        return 0;
+    }
+    return ((get_cycles() - DIV_reset_cycle) >> 8) & 0xFF;
 }
 
 uint8_t Timer::get_TIMA() {
+    sync_TIMA();
     return timer_data.TIMA;
 }
 
@@ -118,3 +161,23 @@ bool Timer::get_TAC_is_enabled() {
 unsigned Timer::get_TAC_clock_divider() {
     return CLK_DIVIDER_LOOKUP[timer_data.TAC.mode.clk_divider];
 }
+
+void Timer::save_state(state_t &state) {
+    state.DIV = timer_data.DIV;
+    state.TIMA = timer_data.TIMA;
+    state.TMA = timer_data.TMA;
+    state.TAC = timer_data.TAC.value;
+    state.is_DIV_stopped = is_DIV_stopped;
+    state.DIV_reset_cycle = DIV_reset_cycle;
+    state.TIMA_sync_cycle = TIMA_sync_cycle;
+}
+
+void Timer::load_state(const state_t &state) {
+    timer_data.DIV = state.DIV;
+    timer_data.TIMA = state.TIMA;
+    timer_data.TMA = state.TMA;
+    timer_data.TAC.value = state.TAC;
+    is_DIV_stopped = state.is_DIV_stopped;
+    DIV_reset_cycle = state.DIV_reset_cycle;
+    TIMA_sync_cycle = state.TIMA_sync_cycle;
+}
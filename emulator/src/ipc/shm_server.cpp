@@ -0,0 +1,188 @@
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ipc/shm_server.h"
+
+static_assert(PPU::SCREEN_WIDTH == SHM_FRAMEBUFFER_WIDTH && PPU::SCREEN_HEIGHT == SHM_FRAMEBUFFER_HEIGHT,
+    "Shared memory frame size doesn't match the PPU");
+static_assert(WorkRAM::WRAM_SIZE == SHM_WRAM_SIZE, "Shared memory WRAM size doesn't match");
+
+ShmInstanceServer::ShmInstanceServer(const std::string &name, unsigned instance_count, const std::string &ROM_path)
+: name(name), should_stop(false) {
+    if (instance_count == 0 || instance_count > UINT16_MAX) {
+        throw std::runtime_error("Instance server needs between 1 and 65535 instances");
+    }
+    for (unsigned i = 0; i < instance_count; ++i) {
+        instances.push_back(std::make_unique<GameBoy>());
+        if (!ROM_path.empty()) {
+            instances.back()->load_cartridge_from_file(ROM_path);
+        }
+    }
+
+    int file = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (file < 0) {
+        throw std::runtime_error("Cannot create shared memory " + name + ": " + strerror(errno));
+    }
+    segment_size = shm_segment_size(instance_count);
+    void *segment = MAP_FAILED;
+    if (ftruncate(file, segment_size) == 0) {
+        segment = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    }
+    close(file);
+    if (segment == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Cannot map shared memory " + name + ": " + strerror(errno));
+    }
+
+    // Fresh segment is zeroed, only the non-zero fields have to be set
+    header = new (segment) shm_header_t;
+    header->magic = SHM_MAGIC;
+    header->version = SHM_PROTOCOL_VERSION;
+    header->instance_count = instance_count;
+    header->instance_size = sizeof(shm_instance_t);
+    for (uint32_t i = 0; i < SHM_RING_CAPACITY; ++i) {
+        header->ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    for (unsigned i = 0; i < instance_count; ++i) {
+        new (shm_get_instance(header, i)) shm_instance_t;
+        publish_instance_state(i);
+    }
+    header->is_ready.store(1, std::memory_order_release);
+}
+
+ShmInstanceServer::~ShmInstanceServer() {
+    header->is_shut_down.store(1, std::memory_order_release);
+    shm_futex_wake_all(&header->completed_count);
+    munmap(header, segment_size);
+    shm_unlink(name.c_str());
+}
+
+void ShmInstanceServer::serve() {
+    while (!should_stop.load(std::memory_order_acquire)) {
+        uint32_t observed_counter = header->command_counter.load(std::memory_order_seq_cst);
+        if (!process_pending_commands()) {
+            break;
+        }
+        // Producers bump the counter after pushing, so a command queued since it was read makes the wait return at once
+        header->is_server_sleeping.store(1, std::memory_order_seq_cst);
+        if (header->command_counter.load(std::memory_order_seq_cst) == observed_counter && !should_stop.load()) {
+            shm_futex_wait(&header->command_counter, observed_counter, 100);
+        }
+        header->is_server_sleeping.store(0, std::memory_order_seq_cst);
+    }
+    header->is_shut_down.store(1, std::memory_order_release);
+    shm_futex_wake_all(&header->completed_count);
+}
+
+bool ShmInstanceServer::process_pending_commands() {
+    shm_command_t command;
+    while (shm_ring_pop(header, command)) {
+        exec_command(command);
+        header->completed_count.fetch_add(1, std::memory_order_seq_cst);
+        if (header->sleeping_client_count.load(std::memory_order_seq_cst) > 0) {
+            shm_futex_wake_all(&header->completed_count);
+        }
+        if (command.type == SHM_CMD_SHUTDOWN) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShmInstanceServer::stop() {
+    should_stop.store(true, std::memory_order_release);
+    header->command_counter.fetch_add(1, std::memory_order_seq_cst);
+    shm_futex_wake_all(&header->command_counter);
+}
+
+GameBoy &ShmInstanceServer::get_instance(unsigned instance_no) {
+    return *instances.at(instance_no);
+}
+
+void ShmInstanceServer::exec_command(const shm_command_t &command) {
+    if (command.type == SHM_CMD_SHUTDOWN) {
+        return;
+    }
+    if (command.instance_no >= instances.size()) {
+        return;
+    }
+    shm_instance_t *instance = shm_get_instance(header, command.instance_no);
+    int32_t status = SHM_OK;
+    try {
+        switch (command.type) {
+            case SHM_CMD_STEP_FRAMES:
+                step_frames(command.instance_no, command.argument);
+                break;
+            case SHM_CMD_RESET:
+                instances[command.instance_no]->restart();
+                break;
+            case SHM_CMD_SAVE_STATE:
+                save_state(command.instance_no);
+                break;
+            case SHM_CMD_LOAD_STATE:
+                load_state(command.instance_no);
+                break;
+            default:
+                status = SHM_UNKNOWN_COMMAND;
+                break;
+        }
+    } catch (std::exception &) {
+        status = SHM_ERROR;
+    }
+    publish_instance_state(command.instance_no);
+    instance->last_status = status;
+}
+
+void ShmInstanceServer::step_frames(unsigned instance_no, unsigned frame_count) {
+    GameBoy &game_boy = *instances[instance_no];
+    shm_instance_t *instance = shm_get_instance(header, instance_no);
+    for (unsigned i = 0; i < frame_count; ++i) {
+        game_boy.set_pressed_buttons(instance->input.load(std::memory_order_relaxed));
+        game_boy.run_frames(1);
+    }
+}
+
+void ShmInstanceServer::save_state(unsigned instance_no) {
+    shm_instance_t *instance = shm_get_instance(header, instance_no);
+    instances[instance_no]->save_state(state_buffer);
+    if (state_buffer.size() > sizeof(instance->state)) {
+        throw std::runtime_error("Save state doesn't fit in the shared memory slot");
+    }
+    memcpy(instance->state, state_buffer.data(), state_buffer.size());
+    instance->state_size = state_buffer.size();
+}
+
+/**
+ * Invalid states (other ROM, version or size) are refused by GameBoy::load_state without touching the machine
+ */
+void ShmInstanceServer::load_state(unsigned instance_no) {
+    shm_instance_t *instance = shm_get_instance(header, instance_no);
+    if (instance->state_size > sizeof(instance->state)) {
+        throw std::runtime_error("Save state is larger than the shared memory slot");
+    }
+    instances[instance_no]->load_state(instance->state, instance->state_size);
+}
+
+/**
+ * Frame and RAM are copied once per command, not per emulated frame
+ */
+void ShmInstanceServer::publish_instance_state(unsigned instance_no) {
+    GameBoy &game_boy = *instances[instance_no];
+    shm_instance_t *instance = shm_get_instance(header, instance_no);
+    if (game_boy.ppu.has_new_frame() || instance->frame_count == 0) {
+        const PPU::frame_t &frame = game_boy.ppu.get_latest_frame();
+        memcpy(instance->framebuffer, frame.pixels, sizeof(instance->framebuffer));
+        instance->frame_no = frame.frame_no;
+    }
+    memcpy(instance->WRAM, game_boy.bus.wram.get_raw_data(), sizeof(instance->WRAM));
+    instance->frame_count = game_boy.get_frame_count();
+    instance->cycles = game_boy.get_cycles();
+    instance->executed_instr_count = game_boy.cpu.get_executed_instr_count();
+}
+
+#endif
@@ -0,0 +1,54 @@
+#include <cstring>
+#include "memory/copy_on_write_memory.h"
+
+CopyOnWriteMemory::CopyOnWriteMemory(size_t size) {
+    pages.resize((size + PAGE_SIZE - 1) / PAGE_SIZE);
+    for (std::shared_ptr<page_t> &page: pages) {
+        page = std::make_shared<page_t>();
+        page->fill(0);
+    }
+    is_page_private.assign(pages.size(), true);
+}
+
+CopyOnWriteMemory::CopyOnWriteMemory(const CopyOnWriteMemory &other): pages(other.pages) {
+    other.is_page_private.assign(other.pages.size(), false);
+    is_page_private.assign(pages.size(), false);
+}
+
+CopyOnWriteMemory::~CopyOnWriteMemory() {
+
+}
+
+void CopyOnWriteMemory::copy_to(uint8_t *destination) {
+    for (size_t i = 0; i < pages.size(); ++i) {
+        memcpy(destination + i * PAGE_SIZE, pages[i]->data(), PAGE_SIZE);
+    }
+}
+
+void CopyOnWriteMemory::copy_from(const uint8_t *source) {
+    for (size_t i = 0; i < pages.size(); ++i) {
+        const uint8_t *source_page = source + i * PAGE_SIZE;
+        if (!is_page_private[i]) {
+            // Loading a state usually leaves most of the pages as they were
+            if (memcmp(pages[i]->data(), source_page, PAGE_SIZE) == 0) {
+                continue;
+            }
+            pages[i] = std::make_shared<page_t>();
+            is_page_private[i] = true;
+        }
+        memcpy(pages[i]->data(), source_page, PAGE_SIZE);
+    }
+}
+
+unsigned CopyOnWriteMemory::get_shared_page_count() {
+    unsigned count = 0;
+    for (uint8_t is_private: is_page_private) {
+        count += is_private ? 0 : 1;
+    }
+    return count;
+}
+
+void CopyOnWriteMemory::make_page_private(size_t page_no) {
+    pages[page_no] = std::make_shared<page_t>(*pages[page_no]);
+    is_page_private[page_no] = true;
+}
@@ -0,0 +1,32 @@
+#include <cstring>
+#include "memory/object_attribute_memory.h"
+
+ObjectAttributeMemory::ObjectAttributeMemory() {
+    memset(data, 0, sizeof(data));
+}
+
+ObjectAttributeMemory::~ObjectAttributeMemory() {
+
+}
+
+void ObjectAttributeMemory::write(uint16_t address, uint8_t value) {
+    // TODO: Implement access control
+    data[address - OAM_MEMORY_START_ADDR] = value;
+}
+
+uint8_t ObjectAttributeMemory::read(uint16_t address) {
+    // TODO: Implement access control
+    return data[address - OAM_MEMORY_START_ADDR];
+}
+
+uint8_t *ObjectAttributeMemory::get_raw_data() {
+    return data;
+}
+
+void ObjectAttributeMemory::save_state(state_t &state) {
+    memcpy(state.data, data, sizeof(data));
+}
+
+void ObjectAttributeMemory::load_state(const state_t &state) {
+    memcpy(data, state.data, sizeof(data));
+}
@@ -1,7 +1,9 @@
+#include <cstring>
 #include "memory/video_ram.h"
 
 VideoRAM::VideoRAM() {
-
+    memset(data, 0, sizeof(data));
+    memset(decoded_tiles, 0, sizeof(decoded_tiles));
 }
 
 VideoRAM::~VideoRAM() {
@@ -10,7 +12,12 @@ VideoRAM::~VideoRAM() {
 
 void VideoRAM::write(uint16_t address, uint8_t value) {
     // TODO: Implement access control
-    data[address - VRAM_MEMORY_START_ADDR] = value;
+    unsigned offset = address - VRAM_MEMORY_START_ADDR;
+    data[offset] = value;
+    if (offset < TILE_DATA_SIZE) {
+        // Each tile line is stored in 2 bytes, the lower one comes first
+        decode_tile_line(offset & ~1u);
+    }
 }
 
 uint8_t VideoRAM::read(uint16_t address) {
@@ -21,3 +28,26 @@ uint8_t VideoRAM::read(uint16_t address) {
 uint8_t *VideoRAM::get_raw_data() {
     return data;
 }
+
+/**
+ * Converts a single tile line (a pair of bytes) to 8 color ids and stores it in the tile cache
+ */
+inline void VideoRAM::decode_tile_line(unsigned tile_line_offset) {
+    uint8_t low_byte = data[tile_line_offset];
+    uint8_t high_byte = data[tile_line_offset + 1];
+    uint8_t *pixels = decoded_tiles[tile_line_offset / TILE_SIZE][(tile_line_offset % TILE_SIZE) / 2];
+    for (int bit_no = 7; bit_no >= 0; --bit_no) {
+        pixels[7 - bit_no] = ((high_byte >> bit_no) & 1) << 1 | ((low_byte >> bit_no) & 1);
+    }
+}
+
+void VideoRAM::save_state(state_t &state) {
+    memcpy(state.data, data, sizeof(data));
+}
+
+void VideoRAM::load_state(const state_t &state) {
+    memcpy(data, state.data, sizeof(data));
+    for (unsigned tile_line_offset = 0; tile_line_offset < TILE_DATA_SIZE; tile_line_offset += 2) {
+        decode_tile_line(tile_line_offset);
+    }
+}
@@ -0,0 +1,31 @@
+#include <cstring>
+#include "memory/work_ram.h"
+
+WorkRAM::WorkRAM() {
+    memset(data, 0, sizeof(data));
+}
+
+WorkRAM::~WorkRAM() {
+
+}
+
+void WorkRAM::write(uint16_t address, uint8_t value) {
+    // Works for both the RAM and its echo
+    data[address & (WRAM_SIZE - 1)] = value;
+}
+
+uint8_t WorkRAM::read(uint16_t address) {
+    return data[address & (WRAM_SIZE - 1)];
+}
+
+uint8_t *WorkRAM::get_raw_data() {
+    return data;
+}
+
+void WorkRAM::save_state(state_t &state) {
+    memcpy(state.data, data, sizeof(data));
+}
+
+void WorkRAM::load_state(const state_t &state) {
+    memcpy(data, state.data, sizeof(data));
+}
@@ -0,0 +1,95 @@
+#include <fstream>
+#include <stdexcept>
+#include "movie/movie.h"
+
+Movie::Movie() {
+    clear();
+}
+
+Movie::~Movie() {
+
+}
+
+void Movie::clear() {
+    ROM_hash = 0;
+    end_cycle = 0;
+    end_frame_no = 0;
+    events.clear();
+    keyframes.clear();
+}
+
+void Movie::save_to_file(const std::string &file_path) {
+    std::ofstream file(file_path, std::ios::binary);
+    if (!file.good()) {
+        throw std::runtime_error("Cannot open file: " + file_path);
+    }
+    file_header_t header = {MOVIE_MAGIC, MOVIE_VERSION, ROM_hash, end_cycle, end_frame_no, events.size(), keyframes.size()};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    std::vector<file_event_t> file_events(events.size());
+    for (size_t i = 0; i < events.size(); ++i) {
+        file_events[i] = {events[i].cycle, events[i].pressed_buttons};
+    }
+    file.write(reinterpret_cast<const char *>(file_events.data()), file_events.size() * sizeof(file_event_t));
+    for (const keyframe_t &keyframe: keyframes) {
+        file_keyframe_header_t keyframe_header = {keyframe.cycle, keyframe.frame_no, keyframe.next_event, keyframe.state.size()};
+        file.write(reinterpret_cast<const char *>(&keyframe_header), sizeof(keyframe_header));
+        file.write(reinterpret_cast<const char *>(keyframe.state.data()), keyframe.state.size());
+    }
+    if (!file.good()) {
+        throw std::runtime_error("Cannot write movie to file: " + file_path);
+    }
+}
+
+void Movie::load_from_file(const std::string &file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.good()) {
+        throw std::runtime_error("Cannot open file: " + file_path);
+    }
+    file_header_t header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file.good() || header.magic != MOVIE_MAGIC) {
+        throw std::runtime_error("Not a movie file: " + file_path);
+    }
+    if (header.version != MOVIE_VERSION) {
+        throw std::runtime_error("Movie version " + std::to_string(header.version) + " isn't supported");
+    }
+    clear();
+    ROM_hash = header.ROM_hash;
+    end_cycle = header.end_cycle;
+    end_frame_no = header.end_frame_no;
+    std::vector<file_event_t> file_events(header.event_count);
+    file.read(reinterpret_cast<char *>(file_events.data()), file_events.size() * sizeof(file_event_t));
+    for (const file_event_t &file_event: file_events) {
+        events.push_back({file_event.cycle, static_cast<uint8_t>(file_event.pressed_buttons)});
+    }
+    keyframes.resize(header.keyframe_count);
+    for (keyframe_t &keyframe: keyframes) {
+        file_keyframe_header_t keyframe_header;
+        file.read(reinterpret_cast<char *>(&keyframe_header), sizeof(keyframe_header));
+        if (!file.good()) {
+            break;
+        }
+        keyframe.cycle = keyframe_header.cycle;
+        keyframe.frame_no = keyframe_header.frame_no;
+        keyframe.next_event = keyframe_header.next_event;
+        keyframe.state.resize(keyframe_header.state_size);
+        file.read(reinterpret_cast<char *>(keyframe.state.data()), keyframe.state.size());
+    }
+    if (!file.good() || keyframes.empty() || keyframes.back().next_event > events.size()) {
+        clear();
+        throw std::runtime_error("Movie file is truncated: " + file_path);
+    }
+}
+
+void Movie::add_event(uint64_t cycle, uint8_t pressed_buttons) {
+    events.push_back({cycle, pressed_buttons});
+}
+
+void Movie::add_keyframe(uint64_t cycle, uint64_t frame_no, const std::vector<uint8_t> &state) {
+    keyframes.push_back({cycle, frame_no, events.size(), state});
+}
+
+void Movie::set_end(uint64_t cycle, uint64_t frame_no) {
+    end_cycle = cycle;
+    end_frame_no = frame_no;
+}
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "movie/movie_player.h"
+
+MoviePlayer::MoviePlayer(GameBoy &game_boy, Movie &movie): game_boy(game_boy), movie(movie) {
+    if (movie.get_keyframes().empty()) {
+        throw std::runtime_error("Movie is empty");
+    }
+    if (movie.get_ROM_hash() != game_boy.bus.get_ROM_hash()) {
+        throw std::runtime_error("Movie was recorded with another ROM");
+    }
+    load_keyframe(0);
+}
+
+MoviePlayer::~MoviePlayer() {
+
+}
+
+void MoviePlayer::seek_to_frame(uint64_t frame_no) {
+    const std::vector<Movie::keyframe_t> &keyframes = movie.get_keyframes();
+    // Keyframes may be taken in the middle of a frame, so the one of frame_no itself could be too late
+    size_t keyframe_no = 0;
+    while (keyframe_no + 1 < keyframes.size() && keyframes[keyframe_no + 1].frame_no < frame_no) {
+        ++keyframe_no;
+    }
+    // Going on from the current position is cheaper, unless it's before the keyframe
+    if (game_boy.get_frame_count() >= frame_no || game_boy.get_cycles() < keyframes[keyframe_no].cycle) {
+        load_keyframe(keyframe_no);
+    }
+    if (frame_no > game_boy.get_frame_count()) {
+        run_frames(frame_no - game_boy.get_frame_count());
+    }
+}
+
+void MoviePlayer::seek_to_cycle(uint64_t cycle) {
+    const std::vector<Movie::keyframe_t> &keyframes = movie.get_keyframes();
+    size_t keyframe_no = 0;
+    while (keyframe_no + 1 < keyframes.size() && keyframes[keyframe_no + 1].cycle <= cycle) {
+        ++keyframe_no;
+    }
+    if (game_boy.get_cycles() > cycle || game_boy.get_cycles() < keyframes[keyframe_no].cycle) {
+        load_keyframe(keyframe_no);
+    }
+    run_until(cycle);
+}
+
+void MoviePlayer::run_frames(unsigned frame_count) {
+    // Same as GameBoy::run_frames, with the input events as additional stops
+    for (unsigned i = 0; i < frame_count; ++i) {
+        uint64_t start_frame = game_boy.get_frame_count();
+        uint64_t deadline = game_boy.get_cycles() + GameBoy::FRAME_CYCLES;
+        while (game_boy.get_frame_count() == start_frame && game_boy.get_cycles() < deadline) {
+            run_until(std::min(deadline, game_boy.bus.scheduler.get_next_event_cycle()));
+        }
+    }
+}
+
+bool MoviePlayer::is_finished() {
+    return game_boy.get_cycles() >= movie.get_end_cycle();
+}
+
+void MoviePlayer::load_keyframe(size_t keyframe_no) {
+    const Movie::keyframe_t &keyframe = movie.get_keyframes()[keyframe_no];
+    game_boy.load_state(keyframe.state);
+    next_event = keyframe.next_event;
+    // Position at a cycle always includes the input changed at it
+    apply_due_events();
+}
+
+void MoviePlayer::apply_due_events() {
+    const std::vector<Movie::input_event_t> &events = movie.get_events();
+    while (next_event < events.size() && events[next_event].cycle <= game_boy.get_cycles()) {
+        game_boy.set_pressed_buttons(events[next_event].pressed_buttons);
+        ++next_event;
+    }
+}
+
+void MoviePlayer::run_until(uint64_t target_cycle) {
+    const std::vector<Movie::input_event_t> &events = movie.get_events();
+    apply_due_events();
+    while (game_boy.get_cycles() < target_cycle) {
+        uint64_t stop_cycle = target_cycle;
+        if (next_event < events.size()) {
+            stop_cycle = std::min(stop_cycle, events[next_event].cycle);
+        }
+        game_boy.cpu.run_until(stop_cycle);
+        apply_due_events();
+    }
+}
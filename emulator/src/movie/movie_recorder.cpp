@@ -0,0 +1,34 @@
+#include "movie/movie_recorder.h"
+
+const unsigned MovieRecorder::DEFAULT_KEYFRAME_INTERVAL;
+
+MovieRecorder::MovieRecorder(GameBoy &game_boy, unsigned keyframe_interval): game_boy(game_boy) {
+    this->keyframe_interval = keyframe_interval;
+    movie.set_ROM_hash(game_boy.bus.get_ROM_hash());
+    // Joypad state is a part of the keyframe
+    last_pressed_buttons = game_boy.bus.io.joypad.get_pressed_buttons();
+    add_keyframe();
+}
+
+MovieRecorder::~MovieRecorder() {
+
+}
+
+void MovieRecorder::update() {
+    uint8_t pressed_buttons = game_boy.bus.io.joypad.get_pressed_buttons();
+    if (pressed_buttons != last_pressed_buttons) {
+        movie.add_event(game_boy.get_cycles(), pressed_buttons);
+        last_pressed_buttons = pressed_buttons;
+    }
+    if (game_boy.get_frame_count() >= last_keyframe_frame_no + keyframe_interval) {
+        add_keyframe();
+    }
+    movie.set_end(game_boy.get_cycles(), game_boy.get_frame_count());
+}
+
+void MovieRecorder::add_keyframe() {
+    game_boy.save_state(state);
+    movie.add_keyframe(game_boy.get_cycles(), game_boy.get_frame_count(), state);
+    last_keyframe_frame_no = game_boy.get_frame_count();
+    movie.set_end(game_boy.get_cycles(), game_boy.get_frame_count());
+}
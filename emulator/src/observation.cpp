@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "observation.h"
+
+/**
+ * Shade to gray level: 0 - 255, 1 - 170, 2 - 85, 3 - 0 (same as PPU::convert_to_RGBA)
+ * Arithmetic instead of a lookup table lets the compiler vectorize the loops using it
+ */
+static inline uint8_t shade_to_gray(uint8_t shade) {
+    return 255 - shade * 85;
+}
+
+ObservationStage::ObservationStage(const config_t &config) {
+    if (config.stack_size == 0) {
+        throw std::runtime_error("Observation stack size must be at least 1");
+    }
+    format = config.format;
+    stack_size = config.stack_size;
+    switch (format) {
+        case GRAYSCALE:
+            width = SOURCE_WIDTH;
+            height = SOURCE_HEIGHT;
+            row_size = width;
+            break;
+        case GRAYSCALE_RESIZED:
+            if (config.width == 0 || config.height == 0 || config.width > SOURCE_WIDTH || config.height > SOURCE_HEIGHT) {
+                throw std::runtime_error("Observation size must be between 1x1 and 160x144");
+            }
+            width = config.width;
+            height = config.height;
+            row_size = width;
+            // Every output pixel takes the source pixel closest to its center
+            for (unsigned x = 0; x < width; ++x) {
+                source_columns.push_back(((2 * x + 1) * SOURCE_WIDTH) / (2 * width));
+            }
+            for (unsigned y = 0; y < height; ++y) {
+                source_rows.push_back(((2 * y + 1) * SOURCE_HEIGHT) / (2 * height));
+            }
+            break;
+        case PACKED_2BIT:
+            width = SOURCE_WIDTH;
+            height = SOURCE_HEIGHT;
+            row_size = width / 4;
+            break;
+        default:
+            throw std::runtime_error("Unknown observation format");
+    }
+    slots.resize(get_observation_size() * stack_size);
+    slot_frame_nos.resize(stack_size);
+    clear();
+}
+
+ObservationStage::~ObservationStage() {
+
+}
+
+void ObservationStage::push_frame(const uint8_t *pixels, unsigned row_stride, uint64_t frame_no) {
+    newest_slot = (newest_slot + 1) % stack_size;
+    uint8_t *observation = slots.data() + newest_slot * get_observation_size();
+    switch (format) {
+        case GRAYSCALE:
+            make_grayscale(pixels, row_stride, observation);
+            break;
+        case GRAYSCALE_RESIZED:
+            make_grayscale_resized(pixels, row_stride, observation);
+            break;
+        case PACKED_2BIT:
+            make_packed_2bit(pixels, row_stride, observation);
+            break;
+    }
+    slot_frame_nos[newest_slot] = frame_no;
+    ++pushed_count;
+}
+
+const uint8_t *ObservationStage::get_observation(unsigned age) {
+    return slots.data() + get_slot_no(age) * get_observation_size();
+}
+
+uint64_t ObservationStage::get_frame_no(unsigned age) {
+    return slot_frame_nos[get_slot_no(age)];
+}
+
+void ObservationStage::copy_stack(uint8_t *destination) {
+    for (unsigned age = stack_size; age-- > 0;) {
+        memcpy(destination, get_observation(age), get_observation_size());
+        destination += get_observation_size();
+    }
+}
+
+void ObservationStage::clear() {
+    std::fill(slots.begin(), slots.end(), 0);
+    std::fill(slot_frame_nos.begin(), slot_frame_nos.end(), 0);
+    newest_slot = stack_size - 1;
+    pushed_count = 0;
+}
+
+inline unsigned ObservationStage::get_slot_no(unsigned age) {
+    if (age >= stack_size) {
+        throw std::runtime_error("Observation age out of range");
+    }
+    return (newest_slot + stack_size - age) % stack_size;
+}
+
+void ObservationStage::make_grayscale(const uint8_t *pixels, unsigned row_stride, uint8_t *observation) {
+    for (unsigned y = 0; y < SOURCE_HEIGHT; ++y) {
+        const uint8_t *source_row = pixels + y * row_stride;
+        uint8_t *observation_row = observation + y * row_size;
+        for (unsigned x = 0; x < SOURCE_WIDTH; ++x) {
+            observation_row[x] = shade_to_gray(source_row[x]);
+        }
+    }
+}
+
+void ObservationStage::make_grayscale_resized(const uint8_t *pixels, unsigned row_stride, uint8_t *observation) {
+    for (unsigned y = 0; y < height; ++y) {
+        const uint8_t *source_row = pixels + source_rows[y] * row_stride;
+        uint8_t *observation_row = observation + y * row_size;
+        // Gathering the pixels can't be vectorized, so the conversion is done in a separate loop
+        for (unsigned x = 0; x < width; ++x) {
+            observation_row[x] = source_row[source_columns[x]];
+        }
+        for (unsigned x = 0; x < width; ++x) {
+            observation_row[x] = shade_to_gray(observation_row[x]);
+        }
+    }
+}
+
+void ObservationStage::make_packed_2bit(const uint8_t *pixels, unsigned row_stride, uint8_t *observation) {
+    for (unsigned y = 0; y < SOURCE_HEIGHT; ++y) {
+        const uint8_t *source_row = pixels + y * row_stride;
+        uint8_t *observation_row = observation + y * row_size;
+        for (unsigned x = 0; x < row_size; ++x) {
+            observation_row[x] = (source_row[4 * x] & 0b11)
+                | ((source_row[4 * x + 1] & 0b11) << 2)
+                | ((source_row[4 * x + 2] & 0b11) << 4)
+                | ((source_row[4 * x + 3] & 0b11) << 6);
+        }
+    }
+}
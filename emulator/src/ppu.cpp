@@ -4,82 +4,210 @@
 
 PPU::PPU(Bus &bus): bus(bus) {
     LCD_data = (LCD_data_t *)(bus.io.data + 0xFF40 - 0xFF00);
+    screen_pixels = frames.get_back().pixels;
+    observation = nullptr;
+    memset(line_BG_color_ids, 0, sizeof(line_BG_color_ids));
+    line_OBJ_count = 0;
+    frame_count = 0;
+    render_mode = render_mode_t::RENDER_ALL_FRAMES;
+    render_frame_interval = 1;
+    bus.io.attach_PPU(this);
+    bus.scheduler.attach_handler(event_type_t::PPU_MODE_CHANGE, this);
     restart();
 }
 
 PPU::~PPU() {
-
+    bus.io.attach_PPU(nullptr);
+    bus.scheduler.cancel(event_type_t::PPU_MODE_CHANGE);
+    bus.scheduler.attach_handler(event_type_t::PPU_MODE_CHANGE, nullptr);
 }
 
 void PPU::restart() {
-    dots_in_current_mode = 0;
     LCD_data->LCD_control.value = 0x91;
     LCD_data->SCY = 0;
     LCD_data->SCX = 0;
     LCD_data->LYC = 0;
-    LCD_data->BGP.value = 0x00;
+    LCD_data->BGP.value = 0xFC;
     LCD_data->OBP0.value = 0xFF;
     LCD_data->OBP1.value = 0xFF;
     LCD_data->WY = 0;
     LCD_data->WX = 0;
+    build_palette_lut(LCD_data->BGP, BG_palette_lut);
+    build_palette_lut(LCD_data->OBP0, OBJ_palette_luts[0]);
+    build_palette_lut(LCD_data->OBP1, OBJ_palette_luts[1]);
+    set_LY(0);
+    start_frame();
+    LCD_data->LCD_status.bits.mode_flag = mode_flag_t::SEARCHING_OAM;
+    next_event_cycle = bus.scheduler.get_cycles() + SEARCHING_OAM_DOTS;
+    schedule_next_event();
+}
+
+void PPU::set_render_mode(render_mode_t mode, unsigned frame_interval) {
+    render_mode = mode;
+    render_frame_interval = (frame_interval > 0) ? frame_interval : 1;
+    // The current frame follows the new mode as well
+    start_frame();
 }
 
-void PPU::tick(unsigned cpu_clocks) {
+render_mode_t PPU::get_render_mode() {
+    return render_mode;
+}
+
+void PPU::sync() {
     // TODO: Enable / disable VRAM access
-    // TODO: Implement a proper cycle to dot conversion
-    if (LCD_data->LCD_control.bits.LCD_and_PPU_enabled) {
-        dots_in_current_mode += cpu_clocks;
-
-        switch(LCD_data->LCD_status.bits.mode_flag) {
-            case mode_flag_t::IN_HBLANK:
-                if (dots_in_current_mode >= 85-1) { // TODO: 85 or 84
-                    // Line 143 is the last line in a frame. After this PPU enters VBlank
-                    if (LCD_data->LY <= 143) {
-                        // Begin a new line
-                        enter_mode_searching_OAM();
-                    } else {
-                        // Enter VBlank
-                        enter_mode_vblank();
-                    }
-                    dots_in_current_mode -= 85;
-                }
-                break;
-            case mode_flag_t::IN_VBLANK:
-                if (dots_in_current_mode >= 4560-1) {
-                    // Begin a new line
-                    enter_mode_searching_OAM();
-                    dots_in_current_mode -= 4560;
-                } else if (LCD_data->LY < 153) { // LY should go from 144 to 153 in this mode
-                    increment_LY();
-                }
-                break;
-            case mode_flag_t::SEARCHING_OAM:
-                if (dots_in_current_mode >= 80-1) {
-                    enter_mode_rendering();
-                    dots_in_current_mode -= 80;
-                }
-                break;
-            case mode_flag_t::RENDERING:
-                if (dots_in_current_mode >= 291-1) {
-                    enter_mode_hblank();
-                    dots_in_current_mode -= 291;
-                }
-                break;
+    uint64_t current_cycle = bus.scheduler.get_cycles();
+    if (next_event_cycle <= current_cycle) {
+        while (next_event_cycle <= current_cycle) {
+            exec_mode_transition();
         }
+        schedule_next_event();
+    }
+}
+
+void PPU::handle_event(event_type_t type) {
+    if (type == event_type_t::PPU_MODE_CHANGE) {
+        sync();
+    }
+}
+
+void PPU::register_written(uint16_t address, uint8_t old_value) {
+    LLCDC_t old_LCD_control;
+    switch (address) {
+        case 0xFF40: // LCDC
+            old_LCD_control.value = old_value;
+            if (LCD_data->LCD_control.bits.LCD_and_PPU_enabled && !old_LCD_control.bits.LCD_and_PPU_enabled) {
+                // The first line after turning the LCD on starts right away
+                set_LY(0);
+                start_frame();
+                LCD_data->LCD_status.bits.mode_flag = mode_flag_t::SEARCHING_OAM;
+                next_event_cycle = bus.scheduler.get_cycles() + SEARCHING_OAM_DOTS;
+                schedule_next_event();
+            } else if (!LCD_data->LCD_control.bits.LCD_and_PPU_enabled && old_LCD_control.bits.LCD_and_PPU_enabled) {
+                set_LY(0);
+                LCD_data->LCD_status.bits.mode_flag = mode_flag_t::IN_HBLANK;
+                next_event_cycle = Scheduler::NO_EVENT;
+                schedule_next_event();
+            }
+            break;
+        case 0xFF41: // STAT - mode and LY=LYC bits are read only
+            LCD_data->LCD_status.value = (LCD_data->LCD_status.value & 0xF8) | (old_value & 0x07);
+            break;
+        case 0xFF44: // LY is read only
+            LCD_data->LY = old_value;
+            break;
+        case 0xFF45: // LYC
+            LCD_data->LCD_status.bits.LYC_eq_LY = (LCD_data->LY == LCD_data->LYC);
+            break;
+        case 0xFF47: // BGP
+            build_palette_lut(LCD_data->BGP, BG_palette_lut);
+            break;
+        case 0xFF48: // OBP0
+            build_palette_lut(LCD_data->OBP0, OBJ_palette_luts[0]);
+            break;
+        case 0xFF49: // OBP1
+            build_palette_lut(LCD_data->OBP1, OBJ_palette_luts[1]);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Performs the mode transition that is due at next_event_cycle and schedules the next one
+ * Each line goes through OAM search, rendering and HBlank. Lines 144-153 are spent in VBlank
+ */
+inline void PPU::exec_mode_transition() {
+    switch(LCD_data->LCD_status.bits.mode_flag) {
+        case mode_flag_t::SEARCHING_OAM:
+            enter_mode_rendering();
+            next_event_cycle += RENDERING_DOTS;
+            break;
+        case mode_flag_t::RENDERING:
+            enter_mode_hblank();
+            next_event_cycle += HBLANK_DOTS;
+            break;
+        case mode_flag_t::IN_HBLANK:
+            set_LY(LCD_data->LY + 1);
+            // Line 143 is the last line in a frame. After this PPU enters VBlank
+            if (LCD_data->LY > LAST_VISIBLE_LINE) {
+                enter_mode_vblank();
+                next_event_cycle += LINE_DOTS;
+            } else {
+                enter_mode_searching_OAM();
+                next_event_cycle += SEARCHING_OAM_DOTS;
+            }
+            break;
+        case mode_flag_t::IN_VBLANK:
+            // LY goes from 144 to 153 in this mode, once per line
+            if (LCD_data->LY < LAST_LINE) {
+                set_LY(LCD_data->LY + 1);
+                next_event_cycle += LINE_DOTS;
+            } else {
+                // Begin a new frame
+                set_LY(0);
+                start_frame();
+                enter_mode_searching_OAM();
+                next_event_cycle += SEARCHING_OAM_DOTS;
+            }
+            break;
+    }
+}
+
+/**
+ * Decides whether pixels of the frame that is about to begin will be rendered
+ */
+inline void PPU::start_frame() {
+    switch (render_mode) {
+        case render_mode_t::RENDER_ALL_FRAMES:
+            is_current_frame_rendered = true;
+            break;
+        case render_mode_t::RENDER_EVERY_NTH_FRAME:
+            is_current_frame_rendered = ((frame_count % render_frame_interval) == 0);
+            break;
+        case render_mode_t::RENDER_TIMING_ONLY:
+            is_current_frame_rendered = false;
+            break;
     }
 }
 
 inline void PPU::enter_mode_searching_OAM() {
     LCD_data->LCD_status.bits.mode_flag = mode_flag_t::SEARCHING_OAM;
-    increment_LY();
     if (LCD_data->LCD_status.bits.OAM_STAT_intr_src_enabled) {
         bus.io.interrupts.signal(intr_type_t::LCD_STAT);
     }
 }
 
+/**
+ * Selects up to 10 objects that overlap the current line (in OAM order, like the hardware does)
+ * and sorts them by drawing priority: lower X first, then lower OAM index
+ */
+inline void PPU::search_OAM() {
+    const OBJ_t *OBJs = reinterpret_cast<const OBJ_t *>(bus.oam.get_raw_data());
+    int OBJ_height = (LCD_data->LCD_control.bits.OBJ_size == OBJ_size_t::SIZE_16x16) ? 16 : 8;
+    int line = LCD_data->LY;
+    line_OBJ_count = 0;
+    for (unsigned i = 0; i < OAM_OBJ_COUNT && line_OBJ_count < MAX_OBJS_PER_LINE; ++i) {
+        int OBJ_top = OBJs[i].y - 16;
+        if (line >= OBJ_top && line < OBJ_top + OBJ_height) {
+            // Insertion sort is stable, so objects with equal X stay in OAM order
+            unsigned pos = line_OBJ_count;
+            while (pos > 0 && line_OBJs[pos - 1].x > OBJs[i].x) {
+                line_OBJs[pos] = line_OBJs[pos - 1];
+                --pos;
+            }
+            line_OBJs[pos] = OBJs[i];
+            ++line_OBJ_count;
+        }
+    }
+}
+
 inline void PPU::enter_mode_rendering() {
     LCD_data->LCD_status.bits.mode_flag = mode_flag_t::RENDERING;
-    render_current_screen_line();
+    if (is_current_frame_rendered) {
+        // The search itself doesn't affect timing, so it's skipped for frames that are not rendered
+        search_OAM();
+        render_current_screen_line();
+    }
 }
 
 inline void PPU::enter_mode_hblank() {
@@ -91,15 +219,47 @@ inline void PPU::enter_mode_hblank() {
 
 inline void PPU::enter_mode_vblank() {
     LCD_data->LCD_status.bits.mode_flag = mode_flag_t::IN_VBLANK;
-    increment_LY();
+    if (is_current_frame_rendered) {
+        if (observation != nullptr) {
+            observation->push_frame(screen_pixels, SCREEN_WIDTH, frame_count);
+        }
+        frames.get_back().frame_no = frame_count;
+        frames.publish();
+        screen_pixels = frames.get_back().pixels;
+    }
+    ++frame_count;
     bus.io.interrupts.signal(intr_type_t::VBLANK);
     if (LCD_data->LCD_status.bits.vblank_STAT_intr_src_enabled) {
         bus.io.interrupts.signal(intr_type_t::LCD_STAT);
     }
 }
 
-inline void PPU::increment_LY() {
-    LCD_data->LY = (LCD_data->LY  + 1) % 154;
+inline void PPU::schedule_next_event() {
+    if (next_event_cycle != Scheduler::NO_EVENT) {
+        bus.scheduler.schedule(event_type_t::PPU_MODE_CHANGE, next_event_cycle);
+    } else {
+        bus.scheduler.cancel(event_type_t::PPU_MODE_CHANGE);
+    }
+}
+
+inline void PPU::build_palette_lut(palette_data_t palette, palette_lut_t &lut) {
+    for (int i = 0; i < 4; ++i) {
+        lut.shades[i] = (palette.value >> (2 * i)) & 0b11;
+    }
+}
+
+/**
+ * Converts 8 color ids of a tile line to shades
+ */
+inline void PPU::apply_palette(const uint8_t *color_ids, uint8_t *shades, const palette_lut_t &lut) {
+    for (int i = 0; i < 8; ++i) {
+        shades[i] = lut.shades[color_ids[i]];
+    }
+}
+
+inline void PPU::set_LY(uint8_t value) {
+    LCD_data->LY = value;
+    LCD_data->LCD_status.bits.LYC_eq_LY = (LCD_data->LY == LCD_data->LYC);
     if ((LCD_data->LY == LCD_data->LYC) && (LCD_data->LCD_status.bits.LYC_eq_LY_STAT_intr_src_enabled)) {
         bus.io.interrupts.signal(intr_type_t::LCD_STAT);
     }
@@ -110,17 +270,12 @@ void PPU::render_current_screen_line() {
     int tile_row = LCD_data->LY / 8;
     int tile_line_no = LCD_data->LY % 8;
 
-    int high_byte;
-    int low_byte;
-    int color;
-    int col, row;
     uint8_t *tile_map;
-    int tile_addr;
+    unsigned tile_no;
     int8_t signed_offset;
+    uint8_t *line_pixels = screen_pixels + (8 * tile_row + tile_line_no) * SCREEN_WIDTH;
     uint8_t *vram_data = bus.vram.get_raw_data();
 
-    uint32_t color_palette[] = {0xFF000000, 0xFF555555, 0xFFAAAAAA, 0xFFFFFFFF}; // TODO: Use the palette from register
-
     if (LCD_data->LCD_control.bits.BG_tile_map_area == map_area_t::AREA_9800) {
        tile_map = vram_data + 0x1800; // 0x9800 - 0x8000 (VRAM starts at 0x8000 in memory)
     } else {
@@ -129,27 +284,108 @@ void PPU::render_current_screen_line() {
 
     for (int tile_col = 0; tile_col < 32; ++tile_col) {
         if (LCD_data->LCD_control.bits.BG_and_window_tile_data_area == data_area_t::AREA_8000) {
-            tile_addr = 16 * tile_map[32 * tile_row + tile_col]; // implicit 0x8000 - 0x8000 (VRAM starts at 0x8000 in memory)
+            tile_no = tile_map[32 * tile_row + tile_col];
         } else {
             // Offset should be interpreted as a signed number
             memcpy(&signed_offset, &tile_map[32 * tile_row + tile_col], 1);
             // This area of tile data starts at 0x800 (from the beginning of VRAM)
             // The first tile has index = -128
-            // So the address of tile with index 0 would be 0x800 + 128 * (tile size=16) = 0x800 + 0x800 = 0x1000
-            tile_addr =  0x1000 + 16 * signed_offset;
+            // So the tile with index 0 is the 256th one (0x1000 / (tile size=16))
+            tile_no = 256 + signed_offset;
+        }
+
+        // Tile lines are decoded by VRAM when written, so here only the palette has to be applied
+        const uint8_t *color_ids = bus.vram.get_decoded_tile_line(tile_no, tile_line_no);
+        memcpy(line_BG_color_ids + 8 * tile_col, color_ids, 8);
+        apply_palette(color_ids, line_pixels + 8 * tile_col, BG_palette_lut);
+    }
+
+    if (LCD_data->LCD_control.bits.OBJ_enabled) {
+        render_line_OBJs(line_pixels);
+    }
+}
+
+/**
+ * Draws objects selected by the OAM search on top of the current line
+ */
+inline void PPU::render_line_OBJs(uint8_t *line_pixels) {
+    // Set for pixels already taken by an object with higher priority
+    bool is_pixel_taken[VISIBLE_SCREEN_WIDTH] = {};
+    bool is_8x16 = (LCD_data->LCD_control.bits.OBJ_size == OBJ_size_t::SIZE_16x16);
+    int OBJ_height = is_8x16 ? 16 : 8;
+
+    for (unsigned i = 0; i < line_OBJ_count; ++i) {
+        const OBJ_t &OBJ = line_OBJs[i];
+        int OBJ_line = LCD_data->LY - (OBJ.y - 16);
+        if (OBJ.attributes.bits.y_flip) {
+            OBJ_line = OBJ_height - 1 - OBJ_line;
         }
+        // In 8x16 mode the lowest bit of tile number is ignored, the lower half is the next tile
+        unsigned tile_no = is_8x16 ? ((OBJ.tile_no & 0xFE) + OBJ_line / 8) : OBJ.tile_no;
+        const uint8_t *color_ids = bus.vram.get_decoded_tile_line(tile_no, OBJ_line % 8);
+        const palette_lut_t &lut = OBJ_palette_luts[OBJ.attributes.bits.palette_no];
 
-        low_byte = vram_data[tile_addr + 2 * tile_line_no];
-        high_byte = vram_data[tile_addr + 2 * tile_line_no + 1];
-        for (int bit_no = 7; bit_no >= 0; --bit_no) {
-            color = ((high_byte >> bit_no) & 1) << 1 | ((low_byte >> bit_no) & 1);
-            row = 8 * tile_row + tile_line_no;
-            col = 8 * tile_col + (7 - bit_no);
-            screen_pixels[(row * SCREEN_WIDTH) + col] = color_palette[color];
+        for (int pixel = 0; pixel < 8; ++pixel) {
+            int x = OBJ.x - 8 + pixel;
+            if (x < 0 || x >= (int)VISIBLE_SCREEN_WIDTH || is_pixel_taken[x]) {
+                continue;
+            }
+            uint8_t color_id = color_ids[OBJ.attributes.bits.x_flip ? (7 - pixel) : pixel];
+            // Color 0 is transparent
+            if (color_id == 0) {
+                continue;
+            }
+            // An opaque pixel hides objects with lower priority even if the background is drawn over it
+            is_pixel_taken[x] = true;
+            if (OBJ.attributes.bits.BG_over_OBJ && line_BG_color_ids[x] != 0) {
+                continue;
+            }
+            line_pixels[x] = lut.shades[color_id];
         }
     }
 }
 
-uint32_t *PPU::get_screen_pixels() {
+uint8_t *PPU::get_screen_pixels() {
     return screen_pixels;
 }
+
+void PPU::attach_observation(ObservationStage *observation) {
+    this->observation = observation;
+}
+
+void PPU::save_state(state_t &state) {
+    state.next_event_cycle = next_event_cycle;
+    state.frame_count = frame_count;
+    state.is_current_frame_rendered = is_current_frame_rendered;
+    state.line_OBJ_count = line_OBJ_count;
+    memcpy(state.line_OBJs, line_OBJs, sizeof(line_OBJs));
+    memcpy(state.line_BG_color_ids, line_BG_color_ids, sizeof(line_BG_color_ids));
+}
+
+void PPU::load_state(const state_t &state) {
+    next_event_cycle = state.next_event_cycle;
+    frame_count = state.frame_count;
+    is_current_frame_rendered = state.is_current_frame_rendered;
+    line_OBJ_count = state.line_OBJ_count;
+    memcpy(line_OBJs, state.line_OBJs, sizeof(line_OBJs));
+    memcpy(line_BG_color_ids, state.line_BG_color_ids, sizeof(line_BG_color_ids));
+    build_palette_lut(LCD_data->BGP, BG_palette_lut);
+    build_palette_lut(LCD_data->OBP0, OBJ_palette_luts[0]);
+    build_palette_lut(LCD_data->OBP1, OBJ_palette_luts[1]);
+}
+
+const PPU::frame_t &PPU::get_latest_frame() {
+    return frames.acquire();
+}
+
+bool PPU::has_new_frame() {
+    return frames.has_fresh();
+}
+
+void PPU::convert_to_RGBA(const uint8_t *pixels, uint32_t *rgba_pixels, unsigned pixel_count) {
+    // 0 - 0xFFFFFFFF, 1 - 0xFFAAAAAA, 2 - 0xFF555555, 3 - 0xFF000000
+    // Arithmetic instead of a lookup table lets the compiler vectorize this loop
+    for (unsigned i = 0; i < pixel_count; ++i) {
+        rgba_pixels[i] = 0xFFFFFFFF - (pixels[i] * 0x00555555u);
+    }
+}
@@ -0,0 +1,239 @@
+#include <cstring>
+#include <stdexcept>
+#include "rewind_buffer.h"
+
+// Shorter runs of zeros stay inside literals, a run costs at least two bytes of lengths
+static const size_t MIN_ZERO_RUN = 4;
+static const size_t MAX_VARINT_SIZE = 10;
+
+static inline uint8_t *write_varint(uint8_t *output, size_t value) {
+    while (value >= 0x80) {
+        *output++ = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    *output++ = static_cast<uint8_t>(value);
+    return output;
+}
+
+static inline size_t read_varint(const uint8_t *&input) {
+    size_t value = 0;
+    unsigned shift = 0;
+    while (*input & 0x80) {
+        value |= static_cast<size_t>(*input++ & 0x7F) << shift;
+        shift += 7;
+    }
+    value |= static_cast<size_t>(*input++) << shift;
+    return value;
+}
+
+RewindBuffer::RewindBuffer(const config_t &config):
+    capacity(config.memory_budget), keyframe_interval(config.keyframe_interval), ring(new uint8_t[config.memory_budget]) {
+    if (keyframe_interval == 0) {
+        keyframe_interval = 1;
+    }
+    clear();
+}
+
+RewindBuffer::~RewindBuffer() {
+
+}
+
+void RewindBuffer::capture(GameBoy &game_boy) {
+    game_boy.save_state(captured_state);
+    size_t size = captured_state.size();
+    if (size != newest_state.size()) {
+        // Another cartridge, states can't be made from each other
+        clear();
+    }
+    bool is_keyframe = entries.empty() || deltas_since_keyframe + 1 >= keyframe_interval;
+    const uint8_t *data = captured_state.data();
+    if (!is_keyframe) {
+        delta.resize(size);
+        const uint8_t *newest = newest_state.data();
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word, newest_word;
+            memcpy(&word, data + i, sizeof(word));
+            memcpy(&newest_word, newest + i, sizeof(newest_word));
+            word ^= newest_word;
+            memcpy(&delta[i], &word, sizeof(word));
+        }
+        for (; i < size; ++i) {
+            delta[i] = data[i] ^ newest[i];
+        }
+        data = delta.data();
+    }
+    if (!store(data, size, game_boy.get_frame_count(), is_keyframe)) {
+        // The keyframe this delta was made against had to be dropped to make space
+        is_keyframe = true;
+        store(captured_state.data(), size, game_boy.get_frame_count(), is_keyframe);
+    }
+    deltas_since_keyframe = is_keyframe ? 0 : deltas_since_keyframe + 1;
+    newest_state.swap(captured_state);
+}
+
+bool RewindBuffer::rewind(GameBoy &game_boy, unsigned frames) {
+    if (frames >= entries.size()) {
+        return false;
+    }
+    size_t index = get_index(frames);
+    decode(index, captured_state);
+    game_boy.load_state(captured_state);
+
+    while (entries.size() > index + 1) {
+        used_memory -= entries.back().size;
+        keyframe_count -= entries.back().is_keyframe ? 1 : 0;
+        entries.pop_back();
+    }
+    write_offset = entries.back().offset + entries.back().size;
+    deltas_since_keyframe = 0;
+    for (size_t i = index; !entries[i].is_keyframe; --i) {
+        ++deltas_since_keyframe;
+    }
+    newest_state.swap(captured_state);
+    return true;
+}
+
+void RewindBuffer::get_state(unsigned age, std::vector<uint8_t> &state) {
+    decode(get_index(age), state);
+}
+
+uint64_t RewindBuffer::get_frame_no(unsigned age) {
+    return entries[get_index(age)].frame_no;
+}
+
+void RewindBuffer::clear() {
+    entries.clear();
+    write_offset = 0;
+    used_memory = 0;
+    keyframe_count = 0;
+    deltas_since_keyframe = 0;
+    newest_state.clear();
+}
+
+void RewindBuffer::drop_oldest_keyframe() {
+    do {
+        used_memory -= entries.front().size;
+        entries.pop_front();
+    } while (!entries.empty() && !entries.front().is_keyframe);
+    --keyframe_count;
+    if (entries.empty()) {
+        write_offset = 0;
+    }
+}
+
+size_t RewindBuffer::allocate(size_t size) {
+    if (size > capacity) {
+        throw std::runtime_error("Rewind buffer budget is too small for a single state");
+    }
+    while (!entries.empty()) {
+        size_t oldest_offset = entries.front().offset;
+        if (write_offset > oldest_offset) {
+            // Entries are in [oldest_offset, write_offset)
+            if (write_offset + size <= capacity) {
+                return write_offset;
+            }
+            if (size <= oldest_offset) {
+                return 0;
+            }
+        } else if (write_offset + size <= oldest_offset) {
+            // Entries wrapped around, only [write_offset, oldest_offset) is free
+            return write_offset;
+        }
+        drop_oldest_keyframe();
+    }
+    return 0;
+}
+
+bool RewindBuffer::store(const uint8_t *data, size_t size, uint64_t frame_no, bool is_keyframe) {
+    encoded.resize(size + (size / (MIN_ZERO_RUN + 1) + 2) * 2 * MAX_VARINT_SIZE);
+    size_t encoded_size = encode(data, size, encoded.data());
+    size_t offset = allocate(encoded_size);
+    if (!is_keyframe && entries.empty()) {
+        return false;
+    }
+    memcpy(&ring[offset], encoded.data(), encoded_size);
+    entries.push_back({offset, encoded_size, frame_no, is_keyframe});
+    write_offset = offset + encoded_size;
+    used_memory += encoded_size;
+    keyframe_count += is_keyframe ? 1 : 0;
+    return true;
+}
+
+void RewindBuffer::decode(size_t index, std::vector<uint8_t> &state) {
+    if (index == entries.size() - 1) {
+        state = newest_state;
+        return;
+    }
+    size_t keyframe_index = index;
+    while (!entries[keyframe_index].is_keyframe) {
+        --keyframe_index;
+    }
+    state.resize(newest_state.size());
+    for (size_t i = keyframe_index; i <= index; ++i) {
+        apply(&ring[entries[i].offset], entries[i].size, state.data(), state.size(), entries[i].is_keyframe);
+    }
+}
+
+/**
+ * Encoded data is a sequence of (number of zeros, number of literals, literals) with LEB128 lengths
+ */
+size_t RewindBuffer::encode(const uint8_t *data, size_t size, uint8_t *output) {
+    uint8_t *output_start = output;
+    size_t i = 0;
+    while (i < size) {
+        size_t zeros_start = i;
+        uint64_t word;
+        while (i + sizeof(word) <= size) {
+            memcpy(&word, data + i, sizeof(word));
+            if (word != 0) {
+                break;
+            }
+            i += sizeof(word);
+        }
+        while (i < size && data[i] == 0) {
+            ++i;
+        }
+        size_t literals_start = i;
+        size_t zero_run = 0;
+        while (i < size && zero_run < MIN_ZERO_RUN) {
+            zero_run = (data[i] == 0) ? zero_run + 1 : 0;
+            ++i;
+        }
+        // Zeros at the end of the literals are left for the next run
+        i -= zero_run;
+        output = write_varint(output, literals_start - zeros_start);
+        output = write_varint(output, i - literals_start);
+        memcpy(output, data + literals_start, i - literals_start);
+        output += i - literals_start;
+    }
+    return output - output_start;
+}
+
+/**
+ * Keyframe is decoded over the state, delta is XORed with it
+ */
+void RewindBuffer::apply(const uint8_t *encoded, size_t encoded_size, uint8_t *state, size_t size, bool is_keyframe) {
+    const uint8_t *end = encoded + encoded_size;
+    size_t position = 0;
+    while (encoded < end) {
+        size_t zeros = read_varint(encoded);
+        size_t literals = read_varint(encoded);
+        if (is_keyframe) {
+            memset(state + position, 0, zeros);
+        }
+        position += zeros;
+        if (is_keyframe) {
+            memcpy(state + position, encoded, literals);
+        } else {
+            for (size_t i = 0; i < literals; ++i) {
+                state[position + i] ^= encoded[i];
+            }
+        }
+        encoded += literals;
+        position += literals;
+    }
+    if (position != size) {
+        throw std::runtime_error("Rewind buffer entry is corrupted");
+    }
+}
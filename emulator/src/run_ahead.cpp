@@ -0,0 +1,28 @@
+#include "run_ahead.h"
+
+RunAhead::RunAhead(GameBoy &game_boy, unsigned frames): game_boy(game_boy) {
+    this->frames = frames;
+}
+
+RunAhead::~RunAhead() {
+
+}
+
+void RunAhead::run_frame() {
+    if (frames == 0) {
+        game_boy.run_frames(1);
+        return;
+    }
+    PPU &ppu = game_boy.ppu;
+    render_mode_t render_mode = ppu.get_render_mode();
+    unsigned render_frame_interval = ppu.get_render_frame_interval();
+    // Render mode is applied at the start of a frame and run_frames stops right after VBlank,
+    // so only the frame that is displayed gets its pixels rendered
+    ppu.set_render_mode(render_mode_t::RENDER_TIMING_ONLY);
+    game_boy.run_frames(1);
+    game_boy.save_state(state);
+    game_boy.run_frames(frames - 1);
+    ppu.set_render_mode(render_mode, render_frame_interval);
+    game_boy.run_frames(1);
+    game_boy.load_state(state);
+}
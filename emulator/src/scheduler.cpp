@@ -0,0 +1,76 @@
+#include "scheduler.h"
+
+Scheduler::Scheduler() {
+    cycles = 0;
+    for (int type = 0; type < EVENT_TYPES_COUNT; ++type) {
+        event_cycles[type] = NO_EVENT;
+        handlers[type] = nullptr;
+    }
+    find_next_event();
+}
+
+Scheduler::~Scheduler() {
+
+}
+
+void Scheduler::attach_handler(event_type_t type, EventHandlerInterface *handler) {
+    handlers[type] = handler;
+}
+
+void Scheduler::schedule(event_type_t type, uint64_t cycle) {
+    event_cycles[type] = cycle;
+    find_next_event();
+}
+
+void Scheduler::cancel(event_type_t type) {
+    event_cycles[type] = NO_EVENT;
+    find_next_event();
+}
+
+uint64_t Scheduler::get_event_cycle(event_type_t type) {
+    return event_cycles[type];
+}
+
+void Scheduler::save_state(state_t &state) {
+    state.cycles = cycles;
+    for (int type = 0; type < EVENT_TYPES_COUNT; ++type) {
+        state.event_cycles[type] = event_cycles[type];
+    }
+}
+
+void Scheduler::load_state(const state_t &state) {
+    cycles = state.cycles;
+    for (int type = 0; type < EVENT_TYPES_COUNT; ++type) {
+        event_cycles[type] = state.event_cycles[type];
+    }
+    find_next_event();
+}
+
+/**
+ * Calls handlers of all events whose deadline has passed, the earliest first.
+ * An event is removed before its handler is called, so the handler may schedule the next one
+ */
+void Scheduler::dispatch_due_events() {
+    while (next_event_cycle <= cycles) {
+        event_type_t type = next_event_type;
+        event_cycles[type] = NO_EVENT;
+        find_next_event();
+        if (handlers[type] != nullptr) {
+            handlers[type]->handle_event(type);
+        }
+    }
+}
+
+/**
+ * There are only a few event types, so a linear search over them is cheaper than keeping a heap
+ */
+inline void Scheduler::find_next_event() {
+    next_event_cycle = NO_EVENT;
+    next_event_type = static_cast<event_type_t>(0);
+    for (int type = 0; type < EVENT_TYPES_COUNT; ++type) {
+        if (event_cycles[type] < next_event_cycle) {
+            next_event_cycle = event_cycles[type];
+            next_event_type = static_cast<event_type_t>(type);
+        }
+    }
+}
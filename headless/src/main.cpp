@@ -0,0 +1,414 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include "game_boy.h"
+#include "hash.h"
+#include "input_script.h"
+#include "batch/batch_runner.h"
+#include "cpu/differential_checker.h"
+#include "ipc/shm_server.h"
+#include "movie/movie.h"
+#include "movie/movie_player.h"
+#include "movie/movie_recorder.h"
+
+struct options_t {
+    std::string ROM_path;
+    uint64_t frames = 0;
+    uint64_t cycles = 0;
+    std::string input_script_path;
+    bool print_frame_hashes = false;
+    std::string RAM_dump_path;
+    render_mode_t render_mode = render_mode_t::RENDER_ALL_FRAMES;
+    unsigned render_frame_interval = 1;
+    unsigned instances = 1;
+    unsigned threads = 0;
+    std::string server_name;
+    std::string movie_record_path;
+    std::string movie_replay_path;
+    std::string check_engine;
+    uint64_t check_block_cycles = 0;
+    std::string opcode_profile_path;
+};
+
+void print_usage(const char *program_name) {
+    std::cerr << "Usage: " << program_name << " <rom> [options]" << std::endl
+              << "  --frames <n>          Run for n frames (default 60 if --cycles isn't given)" << std::endl
+              << "  --cycles <n>          Run for n clock cycles" << std::endl
+              << "  --input <file>        Apply button changes from an input script" << std::endl
+              << "  --hash-frames         Print a hash of every rendered frame" << std::endl
+              << "  --dump-ram <file>     Write work RAM (0xC000-0xDFFF) to a file at the end (single instance only)" << std::endl
+              << "  --profile-opcodes <file> Write opcode counters to a CSV or .json file (single instance only, needs -DPROFILE_OPCODES=ON)" << std::endl
+              << "  --record <file>       Record the input of the run as a movie (single instance only)" << std::endl
+              << "  --replay <file>       Seek a movie to --frames or --cycles (default: its end) as fast as possible" << std::endl
+              << "  --render <mode>       all (default), none or every:<n>" << std::endl
+              << "  --instances <n>       Run n independent copies of the ROM in parallel" << std::endl
+              << "  --threads <n>         Worker threads for --instances (default: all cores)" << std::endl
+              << "  --check-engine <name> Run the scalar CPU and the given engine (lockstep) side by side and report the first divergence" << std::endl
+              << "  --check-block <n>     With --check-engine, compare after blocks of n cycles instead of every instruction" << std::endl
+              << "  --serve <name>        Run --instances for other processes through shared memory <name> (e.g. /gameboy)" << std::endl;
+}
+
+bool parse_options(int argc, char **argv, options_t &options) {
+    if (argc < 2) {
+        return false;
+    }
+    options.ROM_path = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        std::string option = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (option == "--frames" && has_value) {
+            options.frames = std::stoull(argv[++i]);
+        } else if (option == "--cycles" && has_value) {
+            options.cycles = std::stoull(argv[++i]);
+        } else if (option == "--input" && has_value) {
+            options.input_script_path = argv[++i];
+        } else if (option == "--hash-frames") {
+            options.print_frame_hashes = true;
+        } else if (option == "--dump-ram" && has_value) {
+            options.RAM_dump_path = argv[++i];
+        } else if (option == "--profile-opcodes" && has_value) {
+            options.opcode_profile_path = argv[++i];
+        } else if (option == "--record" && has_value) {
+            options.movie_record_path = argv[++i];
+        } else if (option == "--replay" && has_value) {
+            options.movie_replay_path = argv[++i];
+        } else if (option == "--instances" && has_value) {
+            options.instances = std::stoul(argv[++i]);
+        } else if (option == "--serve" && has_value) {
+            options.server_name = argv[++i];
+        } else if (option == "--threads" && has_value) {
+            options.threads = std::stoul(argv[++i]);
+        } else if (option == "--check-engine" && has_value) {
+            options.check_engine = argv[++i];
+        } else if (option == "--check-block" && has_value) {
+            options.check_block_cycles = std::stoull(argv[++i]);
+        } else if (option == "--render" && has_value) {
+            std::string mode = argv[++i];
+            if (mode == "all") {
+                options.render_mode = render_mode_t::RENDER_ALL_FRAMES;
+            } else if (mode == "none") {
+                options.render_mode = render_mode_t::RENDER_TIMING_ONLY;
+            } else if (mode.rfind("every:", 0) == 0) {
+                options.render_mode = render_mode_t::RENDER_EVERY_NTH_FRAME;
+                options.render_frame_interval = std::stoul(mode.substr(strlen("every:")));
+            } else {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    // Replay goes to the end of the movie by default
+    if (options.frames == 0 && options.cycles == 0 && options.movie_replay_path.empty()) {
+        options.frames = 60;
+    }
+    return options.instances > 0;
+}
+
+void dump_RAM(GameBoy &game_boy, const std::string &file_path) {
+    std::ofstream file(file_path, std::ios::binary);
+    if (!file.good()) {
+        throw std::runtime_error("Cannot open file: " + file_path);
+    }
+    for (uint32_t address = 0xC000; address <= 0xDFFF; ++address) {
+        char value = static_cast<char>(game_boy.bus.read(address));
+        file.write(&value, 1);
+    }
+}
+
+void print_throughput(uint64_t frames, uint64_t cycles, uint64_t instrs, double seconds, unsigned instances) {
+    printf("frames: %llu, cycles: %llu, instructions: %llu, time: %.3f s\n",
+        (unsigned long long)frames, (unsigned long long)cycles, (unsigned long long)instrs, seconds);
+    if (seconds > 0) {
+        printf("%.1f frames/s, %.2f MIPS, %.2fx real time", frames / seconds, instrs / seconds / 1e6,
+            cycles / seconds / GameBoy::CLOCK_SPEED_HZ);
+        if (instances > 1) {
+            printf(" (%u instances)", instances);
+        }
+        printf("\n");
+    }
+}
+
+void run_single(const options_t &options) {
+#if PROFILE_OPCODES != 1
+    if (!options.opcode_profile_path.empty()) {
+        throw std::runtime_error("Opcode profiling needs a build with -DPROFILE_OPCODES=ON");
+    }
+#endif
+    std::unique_ptr<GameBoy> game_boy = std::make_unique<GameBoy>();
+    InputScript input_script;
+    game_boy->load_cartridge_from_file(options.ROM_path);
+    game_boy->ppu.set_render_mode(options.render_mode, options.render_frame_interval);
+    if (!options.input_script_path.empty()) {
+        input_script.load_from_file(options.input_script_path);
+    }
+    std::unique_ptr<MovieRecorder> recorder;
+    if (!options.movie_record_path.empty()) {
+        recorder = std::make_unique<MovieRecorder>(*game_boy);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t start_cycles = game_boy->get_cycles();
+    uint64_t start_frames = game_boy->get_frame_count();
+    uint64_t start_instrs = game_boy->cpu.get_executed_instr_count();
+    if (options.frames > 0) {
+        for (uint64_t frame = 0; frame < options.frames; ++frame) {
+            input_script.apply(*game_boy, frame);
+            if (recorder) {
+                recorder->update();
+            }
+            game_boy->run_frames(1);
+            if (recorder) {
+                recorder->update();
+            }
+            if (options.print_frame_hashes && game_boy->ppu.has_new_frame()) {
+                const PPU::frame_t &rendered = game_boy->ppu.get_latest_frame();
+                printf("frame %llu %016llx\n", (unsigned long long)rendered.frame_no,
+                    (unsigned long long)hash_fnv1a_64(rendered.pixels, sizeof(rendered.pixels)));
+            }
+        }
+    } else {
+        // Input script is applied once per frame worth of cycles
+        uint64_t end_cycle = start_cycles + options.cycles;
+        while (game_boy->get_cycles() < end_cycle) {
+            input_script.apply(*game_boy, game_boy->get_frame_count() - start_frames);
+            if (recorder) {
+                recorder->update();
+            }
+            game_boy->run_cycles(std::min(GameBoy::FRAME_CYCLES, end_cycle - game_boy->get_cycles()));
+            if (recorder) {
+                recorder->update();
+            }
+        }
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    print_throughput(game_boy->get_frame_count() - start_frames, game_boy->get_cycles() - start_cycles,
+        game_boy->cpu.get_executed_instr_count() - start_instrs, std::chrono::duration<double>(stop - start).count(), 1);
+
+    if (!options.RAM_dump_path.empty()) {
+        dump_RAM(*game_boy, options.RAM_dump_path);
+    }
+    if (recorder) {
+        recorder->get_movie().save_to_file(options.movie_record_path);
+    }
+#if PROFILE_OPCODES == 1
+    if (!options.opcode_profile_path.empty()) {
+        game_boy->cpu.get_opcode_profile().save_to_file(options.opcode_profile_path);
+    }
+#endif
+}
+
+/**
+ * Runs two copies of the ROM with the same input, one on the scalar CPU and one on the checked engine.
+ * Returns false if they diverged
+ */
+bool run_check(const options_t &options) {
+    std::unique_ptr<GameBoy> reference_game_boy = std::make_unique<GameBoy>();
+    std::unique_ptr<GameBoy> checked_game_boy = std::make_unique<GameBoy>();
+    reference_game_boy->load_cartridge_from_file(options.ROM_path);
+    checked_game_boy->load_cartridge_from_file(options.ROM_path);
+    std::unique_ptr<CPUEngine> checked_engine;
+    if (options.check_engine == "lockstep") {
+        checked_engine = std::make_unique<LockstepCPUEngine>(*checked_game_boy);
+    } else if (options.check_engine == "scalar") {
+        checked_engine = std::make_unique<ScalarCPUEngine>(*checked_game_boy);
+    } else {
+        throw std::runtime_error("Unknown CPU engine: " + options.check_engine);
+    }
+    ScalarCPUEngine reference_engine(*reference_game_boy);
+    InputScript input_script;
+    if (!options.input_script_path.empty()) {
+        input_script.load_from_file(options.input_script_path);
+    }
+    DifferentialChecker::config_t config;
+    config.block_cycles = options.check_block_cycles;
+    DifferentialChecker checker(reference_engine, *checked_engine, config);
+
+    // Input script is applied to both machines once per frame worth of cycles
+    uint64_t start_cycles = reference_game_boy->get_cycles();
+    uint64_t end_cycle = start_cycles + ((options.frames > 0) ? options.frames * GameBoy::FRAME_CYCLES : options.cycles);
+    for (uint64_t frame = 0; reference_game_boy->get_cycles() < end_cycle; ++frame) {
+        input_script.apply(*reference_game_boy, frame);
+        input_script.apply(*checked_game_boy, frame);
+        if (!checker.run_until(std::min(start_cycles + (frame + 1) * GameBoy::FRAME_CYCLES, end_cycle))) {
+            break;
+        }
+    }
+    printf("%s", checker.get_report().c_str());
+    return !checker.has_diverged();
+}
+
+/**
+ * Brings a machine to a point of a recorded movie as fast as possible and prints where it ended
+ */
+void run_replay(const options_t &options) {
+    std::unique_ptr<GameBoy> game_boy = std::make_unique<GameBoy>();
+    game_boy->load_cartridge_from_file(options.ROM_path);
+    game_boy->ppu.set_render_mode(options.render_mode, options.render_frame_interval);
+    Movie movie;
+    movie.load_from_file(options.movie_replay_path);
+    MoviePlayer player(*game_boy, movie);
+
+    auto start = std::chrono::steady_clock::now();
+    if (options.frames > 0) {
+        player.seek_to_frame(options.frames);
+    } else if (options.cycles > 0) {
+        player.seek_to_cycle(options.cycles);
+    } else {
+        player.seek_to_cycle(movie.get_end_cycle());
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    printf("frame: %llu, cycle: %llu, seek time: %.3f s\n", (unsigned long long)game_boy->get_frame_count(),
+        (unsigned long long)game_boy->get_cycles(), std::chrono::duration<double>(stop - start).count());
+    if (options.print_frame_hashes) {
+        const PPU::frame_t &rendered = game_boy->ppu.get_latest_frame();
+        printf("frame %llu %016llx\n", (unsigned long long)rendered.frame_no,
+            (unsigned long long)hash_fnv1a_64(rendered.pixels, sizeof(rendered.pixels)));
+    }
+    if (!options.RAM_dump_path.empty()) {
+        dump_RAM(*game_boy, options.RAM_dump_path);
+    }
+}
+
+struct scripted_input_t {
+    InputScript script;
+    bool is_started = false;
+    uint64_t start_frame = 0;
+};
+
+/**
+ * Runs copies of the ROM on all cores. For every instance the hash of its last frame is printed
+ */
+void run_batch(const options_t &options) {
+    BatchRunner runner(options.threads);
+    BatchRunner::instance_config_t config;
+    config.ROM_path = options.ROM_path;
+    config.frame_limit = options.frames;
+    config.cycle_limit = options.cycles;
+    config.render_mode = options.render_mode;
+    config.render_frame_interval = options.render_frame_interval;
+    if (options.cycles > 0 && options.frames == 0) {
+        runner.set_slice(BatchRunner::slice_unit_t::SLICE_CYCLES, GameBoy::FRAME_CYCLES);
+    }
+    InputScript input_script;
+    if (!options.input_script_path.empty()) {
+        input_script.load_from_file(options.input_script_path);
+    }
+    for (unsigned i = 0; i < options.instances; ++i) {
+        if (!options.input_script_path.empty()) {
+            // Every instance goes through the script on its own, counting frames from the start of the run
+            // like run_single does
+            std::shared_ptr<scripted_input_t> scripted_input = std::make_shared<scripted_input_t>();
+            scripted_input->script = input_script;
+            config.before_slice = [scripted_input](GameBoy &game_boy) {
+                if (!scripted_input->is_started) {
+                    scripted_input->start_frame = game_boy.get_frame_count();
+                    scripted_input->is_started = true;
+                }
+                scripted_input->script.apply(game_boy, game_boy.get_frame_count() - scripted_input->start_frame);
+            };
+        }
+        runner.add_instance(config);
+    }
+
+    std::mutex results_mutex;
+    uint64_t total_frames = 0, total_cycles = 0, total_instrs = 0;
+    auto start = std::chrono::steady_clock::now();
+    runner.run([&](const BatchRunner::result_t &result, GameBoy &game_boy) {
+        uint64_t frame_hash = 0;
+        if (options.print_frame_hashes) {
+            const PPU::frame_t &rendered = game_boy.ppu.get_latest_frame();
+            frame_hash = hash_fnv1a_64(rendered.pixels, sizeof(rendered.pixels));
+        }
+        std::lock_guard<std::mutex> lock(results_mutex);
+        total_frames += result.frames;
+        total_cycles += result.cycles;
+        total_instrs += result.instructions;
+        if (!result.error.empty()) {
+            printf("instance %zu error: %s\n", result.instance_id, result.error.c_str());
+        } else if (options.print_frame_hashes) {
+            printf("instance %zu frames %llu last frame %016llx\n", result.instance_id,
+                (unsigned long long)result.frames, (unsigned long long)frame_hash);
+        }
+    });
+    auto stop = std::chrono::steady_clock::now();
+
+    printf("threads: %u\n", runner.get_thread_count());
+    print_throughput(total_frames, total_cycles, total_instrs, std::chrono::duration<double>(stop - start).count(), options.instances);
+}
+
+#ifdef __linux__
+static ShmInstanceServer *running_server = nullptr;
+
+void stop_server(int) {
+    if (running_server != nullptr) {
+        running_server->stop();
+    }
+}
+
+/**
+ * Serves the instances until a client shuts the server down or the process is interrupted
+ */
+void run_server(const options_t &options) {
+    ShmInstanceServer server(options.server_name, options.instances, options.ROM_path);
+    for (unsigned i = 0; i < options.instances; ++i) {
+        server.get_instance(i).ppu.set_render_mode(options.render_mode, options.render_frame_interval);
+    }
+    running_server = &server;
+    std::signal(SIGINT, stop_server);
+    std::signal(SIGTERM, stop_server);
+    printf("serving %u instances at %s\n", options.instances, options.server_name.c_str());
+    fflush(stdout);
+    server.serve();
+    running_server = nullptr;
+}
+#endif
+
+int main(int argc, char **argv) {
+    options_t options;
+    try {
+        if (!parse_options(argc, argv, options)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    } catch (std::exception &) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        if (!options.server_name.empty()) {
+#ifdef __linux__
+            run_server(options);
+#else
+            std::cerr << "Instance server is only supported on Linux" << std::endl;
+            return 1;
+#endif
+        } else if (!options.check_engine.empty()) {
+            if (!run_check(options)) {
+                return 1;
+            }
+        } else if (!options.movie_replay_path.empty()) {
+            run_replay(options);
+        } else if (options.instances > 1) {
+            run_batch(options);
+        } else {
+            run_single(options);
+        }
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
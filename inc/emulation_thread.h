@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <string>
+#include <memory>
+#include <vector>
+#include "bus.h"
+#include "cpu/cpu.h"
+#include "game_boy.h"
+#include "ppu/ppu.h"
+#include "io/joypad.h"
+#include "logger.h"
+#include "movie/movie_recorder.h"
+#include "run_ahead.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+
+/**
+ * Runs the emulated machine on its own thread, so the speed of emulation doesn't depend on the GUI.
+ * GUI talks to it only through commands (lock-free queue), frames published by PPU and debug snapshots
+ */
+class EmulationThread {
+public:
+    enum command_type_t {
+        BUTTON_CHANGE,
+        LOAD_CARTRIDGE,
+        RESET,
+        PAUSE,
+        RESUME,
+        START_RECORDING,
+        STOP_RECORDING,
+        SET_RUN_AHEAD
+    };
+
+    struct command_t {
+        command_type_t type;
+        Joypad::btn_type_t button;
+        Joypad::btn_state_t button_state;
+        std::string file_path;
+        unsigned run_ahead_frames;
+    };
+
+    /**
+     * Copy of the machine state shown by the debug windows, published once per emulation step
+     */
+    struct debug_snapshot_t {
+        uint8_t regA, regB, regC, regD, regE, regH, regL;
+        uint16_t regBC, regDE, regHL, regPC, regSP;
+        flags_reg_t flags_reg;
+        uint8_t DIV, TIMA, TMA;
+        bool TAC_is_enabled;
+        unsigned TAC_clock_divider;
+        uint8_t VRAM[0x2000];
+        uint8_t decoded_tiles[VideoRAM::TILE_COUNT * 8 * 8];
+        uint8_t IO[0x80];
+        // Copied once per loaded cartridge, snapshots only share it
+        std::shared_ptr<const std::vector<uint8_t>> cart_ROM;
+        bool is_paused;
+        bool is_recording;
+        unsigned run_ahead_frames;
+    };
+
+public:
+    /**
+     * Errors of commands (e.g. a ROM that can't be loaded) are reported through the logger
+     */
+    EmulationThread(GameBoy &game_boy, Logger &logger);
+    ~EmulationThread();
+    void start();
+    /**
+     * Stops the emulation and waits for the thread to finish
+     */
+    void stop();
+    /**
+     * Called by the GUI thread. Returns false if the command queue is full and the command was dropped
+     */
+    bool send_command(const command_t &command);
+    bool send_command(command_type_t type);
+    bool send_button_change(Joypad::btn_type_t button, Joypad::btn_state_t state);
+    /**
+     * Called by the GUI thread. Returns the most recent debug snapshot
+     */
+    const debug_snapshot_t &get_debug_snapshot();
+
+private:
+    // Run-ahead doubles the emulation work, so it has to be turned on in the menu
+    const static unsigned DEFAULT_RUN_AHEAD_FRAMES = 0;
+    const static size_t COMMAND_QUEUE_SIZE = 64;
+    GameBoy &game_boy;
+    Logger &logger;
+    Bus &bus;
+    CPU &cpu;
+    PPU &ppu;
+    std::thread thread;
+    std::atomic<bool> should_stop;
+    bool is_paused;
+    SPSCQueue<command_t, COMMAND_QUEUE_SIZE> commands;
+    TripleBuffer<debug_snapshot_t> debug_snapshots;
+    std::shared_ptr<const std::vector<uint8_t>> cart_ROM;
+    // Input is recorded as a movie between START_RECORDING and STOP_RECORDING
+    std::unique_ptr<MovieRecorder> recorder;
+    std::string movie_path;
+    RunAhead run_ahead;
+
+private:
+    void run();
+    void exec_command(command_t &command);
+    /**
+     * Saves the movie being recorded (if any)
+     */
+    void stop_recording();
+    void publish_debug_snapshot();
+};
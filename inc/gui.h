@@ -6,23 +6,20 @@
 #include "imgui_impl_opengl3.h"
 #include "imgui_memory_editor.h"
 
-#include "cpu/cpu.h"
-#include "bus.h"
 #include "gui_logger.h"
-#include "io/io.h"
-#include "disassembler.h"
+#include "cpu/disassembler.h"
 #include "renderer.h"
+#include "emulation_thread.h"
 
 class GUI {
 public:
-    GUI(CPU &cpu, Bus &bus, Renderer &renderer, GuiLogger &logger);
+    GUI(EmulationThread &emulation, Renderer &renderer, GuiLogger &logger);
     ~GUI();
-    void display();
+    void display(const EmulationThread::debug_snapshot_t &snapshot);
     bool get_should_close();
 
 private:
-    CPU &cpu;
-    Bus &bus;
+    EmulationThread &emulation;
     Renderer &renderer;
     GuiLogger &gui_logger;
     Disassembler diss;
@@ -35,10 +32,11 @@ private:
 
 private:
     void handle_events();
-    void display_main_menu();
-    void display_cpu();
+    void send_button_change(SDL_Keycode key, Joypad::btn_state_t state);
+    void display_main_menu(const EmulationThread::debug_snapshot_t &snapshot);
+    void display_cpu(const EmulationThread::debug_snapshot_t &snapshot);
     void display_tile_data();
     void display_screen();
-    void display_timer();
+    void display_timer(const EmulationThread::debug_snapshot_t &snapshot);
     void display_disassembly();
 };
@@ -1,13 +1,16 @@
 #pragma once
 #include "logger.h"
 #include <vector>
+#include <mutex>
 
 class GuiLogger: public Logger {
 public:
     void log(std::string message);
     void log_instruction(instruction_t const& instruction);
-    void display() const;
+    void display();
 
 private:
     std::vector<std::string> messages;
+    // Messages are logged by the emulation thread and displayed by the GUI thread
+    std::mutex messages_mutex;
 };
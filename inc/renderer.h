@@ -13,17 +13,20 @@ public:
     };
 
 public:
-    Renderer(VideoRAM &vram, PPU &ppu);
+    Renderer(PPU &ppu);
     ~Renderer();
-    void render_tile_data();
+    /**
+     * Draws all tiles, expects them decoded the same way VideoRAM keeps them (TILE_COUNT x 8 x 8 color ids)
+     */
+    void render_tile_data(const uint8_t *decoded_tiles);
     void render_screen();
     render_t &get_tile_data_render();
     render_t &get_screen_render();
 
 private:
     const static int TILE_DATA_TILES_IN_ROW = 16;
-    VideoRAM &vram;
     PPU &ppu;
     render_t tile_data_render, screen_render;
     SDL_Surface *tile_data_surface;
+    SDL_Surface *screen_surface;
 };
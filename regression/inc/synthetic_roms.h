@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Built-in test programs, referenced in golden suites as synthetic:<name>, so the suite doesn't depend on external ROMs:
+ * background - tile map rewritten and background palette rotated every few frames
+ * sprites - 40 objects with different flags and palettes moved every frame through OAM DMA
+ * joypad - pressed buttons shown as tiles and in the background palette
+ * Throws std::runtime_error for an unknown name
+ */
+std::vector<uint8_t> make_synthetic_ROM(const std::string &name);
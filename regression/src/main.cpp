@@ -0,0 +1,177 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "game_boy.h"
+#include "golden_suite.h"
+#include "hash.h"
+#include "input_script.h"
+#include "synthetic_roms.h"
+#include "batch/batch_runner.h"
+
+// ROM names with this prefix are built-in programs (see synthetic_roms.h)
+static const std::string SYNTHETIC_ROM_PREFIX = "synthetic:";
+
+struct options_t {
+    std::string suite_path = DEFAULT_SUITE_PATH;
+    bool update = false;
+    unsigned threads = 0;
+};
+
+/**
+ * Progress of one suite entry, touched only by the worker running its instance
+ */
+struct entry_run_t {
+    GoldenSuite::entry_t *entry;
+    InputScript input_script;
+    uint64_t frames_run = 0;
+    // Hashes of the checkpoints reached so far
+    std::vector<uint64_t> hashes;
+    std::string error;
+};
+
+void print_usage(const char *program_name) {
+    std::cerr << "Usage: " << program_name << " [<suite file>] [options]" << std::endl
+              << "  Runs the ROMs of a golden suite (default: the suite of the built-in synthetic ROMs) in parallel" << std::endl
+              << "  and compares frame hashes at the checkpoints with the recorded ones" << std::endl
+              << "  --update              Record the hashes of all checkpoints in the suite file" << std::endl
+              << "  --threads <n>         Worker threads (default: all cores)" << std::endl;
+}
+
+bool parse_options(int argc, char **argv, options_t &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (option == "--update") {
+            options.update = true;
+        } else if (option == "--threads" && has_value) {
+            options.threads = std::stoul(argv[++i]);
+        } else if (option.rfind("--", 0) == 0) {
+            return false;
+        } else {
+            options.suite_path = option;
+        }
+    }
+    return true;
+}
+
+/**
+ * Hashes the latest frame for every checkpoint placed after the frames run so far
+ */
+void record_checkpoints(entry_run_t &run, GameBoy &game_boy) {
+    const std::vector<GoldenSuite::checkpoint_t> &checkpoints = run.entry->checkpoints;
+    while (run.hashes.size() < checkpoints.size() && checkpoints[run.hashes.size()].frame == run.frames_run) {
+        const PPU::frame_t &frame = game_boy.ppu.get_latest_frame();
+        run.hashes.push_back(hash_fnv1a_64(frame.pixels, sizeof(frame.pixels)));
+    }
+}
+
+int main(int argc, char **argv) {
+    options_t options;
+    try {
+        if (!parse_options(argc, argv, options)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    } catch (std::exception &e) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    GoldenSuite suite;
+    try {
+        suite.load_from_file(options.suite_path);
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    BatchRunner runner(options.threads);
+    std::vector<std::unique_ptr<entry_run_t>> runs;
+    for (GoldenSuite::entry_t &entry: suite.get_entries()) {
+        runs.push_back(std::make_unique<entry_run_t>());
+        entry_run_t *run = runs.back().get();
+        run->entry = &entry;
+        BatchRunner::instance_config_t config;
+        config.ROM_path = entry.ROM_path;
+        config.frame_limit = entry.checkpoints.back().frame;
+        try {
+            if (entry.ROM_name.rfind(SYNTHETIC_ROM_PREFIX, 0) == 0) {
+                config.ROM_image = make_synthetic_ROM(entry.ROM_name.substr(SYNTHETIC_ROM_PREFIX.size()));
+            }
+            if (!entry.input_script_path.empty()) {
+                run->input_script.load_from_file(entry.input_script_path);
+            }
+        } catch (std::exception &e) {
+            run->error = e.what();
+            // Limit 0 would mean no limit, the error is reported once this single frame finishes
+            config.ROM_path = "";
+            config.ROM_image.clear();
+            config.frame_limit = 1;
+        }
+        // Slices are one frame long, so this is called after every frame
+        config.before_slice = [run](GameBoy &game_boy) {
+            record_checkpoints(*run, game_boy);
+            run->input_script.apply(game_boy, run->frames_run);
+            ++run->frames_run;
+        };
+        runner.add_instance(config);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    runner.run([&runs](const BatchRunner::result_t &result, GameBoy &game_boy) {
+        entry_run_t &run = *runs[result.instance_id];
+        if (run.error.empty()) {
+            run.error = result.error;
+        }
+        if (run.error.empty()) {
+            record_checkpoints(run, game_boy);
+        }
+    });
+    double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    unsigned matched = 0, mismatched = 0, new_count = 0, errors = 0;
+    for (auto &run: runs) {
+        GoldenSuite::entry_t &entry = *run->entry;
+        if (!run->error.empty() || run->hashes.size() != entry.checkpoints.size()) {
+            printf("ERROR    %s: %s\n", entry.ROM_name.c_str(), run->error.empty() ? "not all checkpoints reached" : run->error.c_str());
+            ++errors;
+            continue;
+        }
+        for (size_t i = 0; i < entry.checkpoints.size(); ++i) {
+            GoldenSuite::checkpoint_t &checkpoint = entry.checkpoints[i];
+            uint64_t hash = run->hashes[i];
+            if (!checkpoint.has_hash) {
+                printf("NEW      %s frame %llu: %016llx\n", entry.ROM_name.c_str(), (unsigned long long)checkpoint.frame,
+                    (unsigned long long)hash);
+                ++new_count;
+            } else if (checkpoint.hash != hash) {
+                printf("MISMATCH %s frame %llu: expected %016llx, got %016llx\n", entry.ROM_name.c_str(),
+                    (unsigned long long)checkpoint.frame, (unsigned long long)checkpoint.hash, (unsigned long long)hash);
+                ++mismatched;
+            } else {
+                ++matched;
+            }
+            if (options.update) {
+                checkpoint.has_hash = true;
+                checkpoint.hash = hash;
+            }
+        }
+    }
+    printf("%u matched, %u mismatched, %u new, %u errors in %.2f s on %u threads\n", matched, mismatched, new_count,
+        errors, wall_seconds, runner.get_thread_count());
+
+    if (options.update) {
+        try {
+            suite.save_to_file(options.suite_path);
+        } catch (std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        printf("Hashes recorded in %s\n", options.suite_path.c_str());
+        return (errors == 0) ? 0 : 1;
+    }
+    return (mismatched == 0 && new_count == 0 && errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+#include <cstring>
+#include <stdexcept>
+#include "synthetic_roms.h"
+
+// Shared beginning of the programs: tile data from address bits, tile map with increasing tile numbers,
+// VBlank as the only interrupt source (IME stays off, HALT is used to wait for the next frame)
+static const uint8_t SETUP[] = {
+    0x21, 0x00, 0x80, // 0x150: LD HL,0x8000
+    0x7D,             // 0x153: LD A,L
+    0xAC,             // 0x154: XOR H
+    0x22,             // 0x155: LD (HL+),A
+    0x7C,             // 0x156: LD A,H
+    0xFE, 0x90,       // 0x157: CP 0x90
+    0x20, 0xF8,       // 0x159: JR NZ,0x153
+    0x21, 0x00, 0x98, // 0x15B: LD HL,0x9800
+    0x7D,             // 0x15E: LD A,L
+    0x22,             // 0x15F: LD (HL+),A
+    0x7C,             // 0x160: LD A,H
+    0xFE, 0x9C,       // 0x161: CP 0x9C
+    0x20, 0xF9,       // 0x163: JR NZ,0x15E
+    0x3E, 0x01,       // 0x165: LD A,0x01
+    0xE0, 0xFF        // 0x167: LDH (IE),A
+};
+
+static const uint8_t BACKGROUND_PROGRAM[] = {
+    0x21, 0x00, 0x98, // 0x169: LD HL,0x9800
+    0x16, 0x00,       // 0x16C: LD D,0x00
+    0xAF,             // 0x16E: XOR A
+    0xE0, 0x0F,       // 0x16F: LDH (IF),A
+    0x76,             // 0x171: HALT
+    0x00,             // 0x172: NOP
+    0x14,             // 0x173: INC D
+    0x0E, 0x10,       // 0x174: LD C,0x10
+    0x7A,             // 0x176: LD A,D - next 16 tile map entries get the frame number
+    0x22,             // 0x177: LD (HL+),A
+    0x0D,             // 0x178: DEC C
+    0x20, 0xFB,       // 0x179: JR NZ,0x176
+    0x7C,             // 0x17B: LD A,H
+    0xFE, 0x9C,       // 0x17C: CP 0x9C
+    0x20, 0x02,       // 0x17E: JR NZ,0x182
+    0x26, 0x98,       // 0x180: LD H,0x98
+    0x7A,             // 0x182: LD A,D
+    0xE6, 0x07,       // 0x183: AND 0x07
+    0x20, 0xE7,       // 0x185: JR NZ,0x16E
+    0xF0, 0x47,       // 0x187: LDH A,(BGP) - every 8 frames
+    0x07,             // 0x189: RLCA
+    0x07,             // 0x18A: RLCA
+    0xE0, 0x47,       // 0x18B: LDH (BGP),A
+    0x18, 0xDF        // 0x18D: JR 0x16E
+};
+
+static const uint8_t SPRITES_PROGRAM[] = {
+    0x3E, 0xE4,       // 0x169: LD A,0xE4
+    0xE0, 0x48,       // 0x16B: LDH (OBP0),A
+    0x3E, 0x1B,       // 0x16D: LD A,0x1B
+    0xE0, 0x49,       // 0x16F: LDH (OBP1),A
+    0x3E, 0x93,       // 0x171: LD A,0x93 - objects on
+    0xE0, 0x40,       // 0x173: LDH (LCDC),A
+    0x21, 0x00, 0xC0, // 0x175: LD HL,0xC000 - object table in work RAM
+    0x06, 0x28,       // 0x178: LD B,40
+    0x0E, 0x10,       // 0x17A: LD C,0x10
+    0x1E, 0x08,       // 0x17C: LD E,0x08
+    0x79,             // 0x17E: LD A,C
+    0x22,             // 0x17F: LD (HL+),A - y
+    0xC6, 0x03,       // 0x180: ADD A,0x03
+    0x4F,             // 0x182: LD C,A
+    0x7B,             // 0x183: LD A,E
+    0x22,             // 0x184: LD (HL+),A - x
+    0xC6, 0x04,       // 0x185: ADD A,0x04
+    0x5F,             // 0x187: LD E,A
+    0x78,             // 0x188: LD A,B
+    0x22,             // 0x189: LD (HL+),A - tile
+    0xE6, 0x0F,       // 0x18A: AND 0x0F
+    0xCB, 0x37,       // 0x18C: SWAP A
+    0x22,             // 0x18E: LD (HL+),A - palette, x flip, y flip and priority from the object number
+    0x05,             // 0x18F: DEC B
+    0x20, 0xEC,       // 0x190: JR NZ,0x17E
+    0xAF,             // 0x192: XOR A
+    0xE0, 0x0F,       // 0x193: LDH (IF),A
+    0x76,             // 0x195: HALT
+    0x00,             // 0x196: NOP
+    0x3E, 0xC0,       // 0x197: LD A,0xC0
+    0xE0, 0x46,       // 0x199: LDH (DMA),A
+    0x21, 0x01, 0xC0, // 0x19B: LD HL,0xC001
+    0x06, 0x28,       // 0x19E: LD B,40
+    0x34,             // 0x1A0: INC (HL) - every object moves right
+    0x2B,             // 0x1A1: DEC HL
+    0x78,             // 0x1A2: LD A,B
+    0xE6, 0x01,       // 0x1A3: AND 0x01
+    0x28, 0x01,       // 0x1A5: JR Z,0x1A8
+    0x34,             // 0x1A7: INC (HL) - every other one moves down too
+    0x23,             // 0x1A8: INC HL
+    0x23,             // 0x1A9: INC HL
+    0x23,             // 0x1AA: INC HL
+    0x23,             // 0x1AB: INC HL
+    0x23,             // 0x1AC: INC HL
+    0x05,             // 0x1AD: DEC B
+    0x20, 0xF0,       // 0x1AE: JR NZ,0x1A0
+    0x18, 0xE0        // 0x1B0: JR 0x192
+};
+
+static const uint8_t JOYPAD_PROGRAM[] = {
+    0xAF,             // 0x169: XOR A
+    0xE0, 0x0F,       // 0x16A: LDH (IF),A
+    0x76,             // 0x16C: HALT
+    0x00,             // 0x16D: NOP
+    0x3E, 0x10,       // 0x16E: LD A,0x10 - action buttons
+    0xE0, 0x00,       // 0x170: LDH (P1),A
+    0xF0, 0x00,       // 0x172: LDH A,(P1)
+    0x2F,             // 0x174: CPL
+    0xE6, 0x0F,       // 0x175: AND 0x0F
+    0x47,             // 0x177: LD B,A
+    0x3E, 0x20,       // 0x178: LD A,0x20 - directions
+    0xE0, 0x00,       // 0x17A: LDH (P1),A
+    0xF0, 0x00,       // 0x17C: LDH A,(P1)
+    0x2F,             // 0x17E: CPL
+    0xE6, 0x0F,       // 0x17F: AND 0x0F
+    0xCB, 0x37,       // 0x181: SWAP A
+    0xB0,             // 0x183: OR B
+    0x47,             // 0x184: LD B,A
+    0xEE, 0xE4,       // 0x185: XOR 0xE4
+    0xE0, 0x47,       // 0x187: LDH (BGP),A
+    0x21, 0x00, 0x98, // 0x189: LD HL,0x9800
+    0x0E, 0x40,       // 0x18C: LD C,0x40 - two rows of tiles
+    0x78,             // 0x18E: LD A,B
+    0x22,             // 0x18F: LD (HL+),A
+    0x0D,             // 0x190: DEC C
+    0x20, 0xFB,       // 0x191: JR NZ,0x18E
+    0x18, 0xD4        // 0x193: JR 0x169
+};
+
+/**
+ * 32kB ROM only cartridge, jumping over the header to the setup followed by the program
+ */
+static std::vector<uint8_t> make_ROM(const uint8_t *program, size_t program_size) {
+    std::vector<uint8_t> ROM(0x8000, 0x00);
+    const uint8_t entry_point[] = {0xC3, 0x50, 0x01}; // 0x100: JP 0x150
+    memcpy(&ROM[0x100], entry_point, sizeof(entry_point));
+    memcpy(&ROM[0x150], SETUP, sizeof(SETUP));
+    memcpy(&ROM[0x150 + sizeof(SETUP)], program, program_size);
+    return ROM;
+}
+
+std::vector<uint8_t> make_synthetic_ROM(const std::string &name) {
+    if (name == "background") {
+        return make_ROM(BACKGROUND_PROGRAM, sizeof(BACKGROUND_PROGRAM));
+    } else if (name == "sprites") {
+        return make_ROM(SPRITES_PROGRAM, sizeof(SPRITES_PROGRAM));
+    } else if (name == "joypad") {
+        return make_ROM(JOYPAD_PROGRAM, sizeof(JOYPAD_PROGRAM));
+    }
+    throw std::runtime_error("Unknown synthetic ROM: " + name);
+}
@@ -0,0 +1,169 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include "emulation_thread.h"
+
+EmulationThread::EmulationThread(GameBoy &game_boy, Logger &logger):
+    game_boy(game_boy), logger(logger), bus(game_boy.bus), cpu(game_boy.cpu), ppu(game_boy.ppu), run_ahead(game_boy, DEFAULT_RUN_AHEAD_FRAMES) {
+    should_stop = false;
+    is_paused = false;
+}
+
+EmulationThread::~EmulationThread() {
+    stop();
+}
+
+void EmulationThread::start() {
+    should_stop = false;
+    thread = std::thread(&EmulationThread::run, this);
+}
+
+void EmulationThread::stop() {
+    should_stop = true;
+    if (thread.joinable()) {
+        thread.join();
+    }
+    // Thread is gone, so the movie can be finished from here
+    stop_recording();
+}
+
+bool EmulationThread::send_command(const command_t &command) {
+    return commands.push(command);
+}
+
+bool EmulationThread::send_command(command_type_t type) {
+    command_t command;
+    command.type = type;
+    return commands.push(command);
+}
+
+bool EmulationThread::send_button_change(Joypad::btn_type_t button, Joypad::btn_state_t state) {
+    command_t command;
+    command.type = command_type_t::BUTTON_CHANGE;
+    command.button = button;
+    command.button_state = state;
+    return commands.push(command);
+}
+
+const EmulationThread::debug_snapshot_t &EmulationThread::get_debug_snapshot() {
+    return debug_snapshots.acquire();
+}
+
+void EmulationThread::run() {
+    // One step is one emulated frame (~59.7 Hz). Steps are paced by absolute deadlines, so the time
+    // spent emulating doesn't add up to drift
+    const auto step_duration = std::chrono::nanoseconds(GameBoy::FRAME_CYCLES * 1000000000ull / GameBoy::CLOCK_SPEED_HZ);
+    auto next_step = std::chrono::steady_clock::now();
+    command_t command;
+
+    while (!should_stop) {
+        while (commands.pop(command)) {
+            exec_command(command);
+        }
+        if (recorder) {
+            recorder->update();
+        }
+        if (bus.get_is_cart_inserted() && !is_paused) {
+            // Steps end right after VBlank, so input sent during a step is seen by the whole next frame
+            run_ahead.run_frame();
+            if (recorder) {
+                recorder->update();
+            }
+        }
+        publish_debug_snapshot();
+        next_step += step_duration;
+        auto now = std::chrono::steady_clock::now();
+        if (next_step < now) {
+            // Emulation fell behind, it doesn't try to catch up
+            next_step = now;
+        }
+        std::this_thread::sleep_until(next_step);
+    }
+}
+
+void EmulationThread::exec_command(command_t &command) {
+    switch (command.type) {
+        case command_type_t::BUTTON_CHANGE:
+            game_boy.set_button(command.button, command.button_state);
+            break;
+        case command_type_t::LOAD_CARTRIDGE:
+            // Movie can't go on past a restart
+            stop_recording();
+            try {
+                game_boy.load_cartridge_from_file(command.file_path);
+            } catch (std::exception &e) {
+                // Previous cartridge (if any) stays inserted and keeps running
+                logger.log(std::string("Cannot load cartridge: ") + e.what());
+                break;
+            }
+            if (bus.get_is_cart_inserted()) {
+                uint8_t *ROM_data = bus.cartridge->get_raw_ROM_data();
+                cart_ROM = std::make_shared<const std::vector<uint8_t>>(ROM_data, ROM_data + bus.cartridge->get_raw_ROM_size());
+            }
+            break;
+        case command_type_t::RESET:
+            stop_recording();
+            game_boy.restart();
+            break;
+        case command_type_t::PAUSE:
+            is_paused = true;
+            break;
+        case command_type_t::RESUME:
+            is_paused = false;
+            break;
+        case command_type_t::START_RECORDING:
+            stop_recording();
+            recorder = std::make_unique<MovieRecorder>(game_boy);
+            movie_path = command.file_path;
+            break;
+        case command_type_t::STOP_RECORDING:
+            stop_recording();
+            break;
+        case command_type_t::SET_RUN_AHEAD:
+            run_ahead.set_frames(command.run_ahead_frames);
+            break;
+    }
+}
+
+void EmulationThread::stop_recording() {
+    if (!recorder) {
+        return;
+    }
+    try {
+        recorder->get_movie().save_to_file(movie_path);
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+    }
+    recorder.reset();
+}
+
+void EmulationThread::publish_debug_snapshot() {
+    debug_snapshot_t &snapshot = debug_snapshots.get_back();
+    snapshot.regA = cpu.get_regA();
+    snapshot.regB = cpu.get_regB();
+    snapshot.regC = cpu.get_regC();
+    snapshot.regD = cpu.get_regD();
+    snapshot.regE = cpu.get_regE();
+    snapshot.regH = cpu.get_regH();
+    snapshot.regL = cpu.get_regL();
+    snapshot.regBC = cpu.get_regBC();
+    snapshot.regDE = cpu.get_regDE();
+    snapshot.regHL = cpu.get_regHL();
+    snapshot.regPC = cpu.get_regPC();
+    snapshot.regSP = cpu.get_regSP();
+    snapshot.flags_reg = cpu.get_flags_reg();
+    snapshot.DIV = bus.io.timer.get_DIV();
+    snapshot.TIMA = bus.io.timer.get_TIMA();
+    snapshot.TMA = bus.io.timer.get_TMA();
+    snapshot.TAC_is_enabled = bus.io.timer.get_TAC_is_enabled();
+    snapshot.TAC_clock_divider = bus.io.timer.get_TAC_clock_divider();
+    memcpy(snapshot.VRAM, bus.vram.get_raw_data(), sizeof(snapshot.VRAM));
+    memcpy(snapshot.decoded_tiles, bus.vram.get_decoded_tile(0), sizeof(snapshot.decoded_tiles));
+    memcpy(snapshot.IO, bus.io.data, sizeof(snapshot.IO));
+    snapshot.cart_ROM = cart_ROM;
+    snapshot.is_paused = is_paused;
+    snapshot.is_recording = (recorder != nullptr);
+    snapshot.run_ahead_frames = run_ahead.get_frames();
+    debug_snapshots.publish();
+}
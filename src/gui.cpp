@@ -5,7 +5,7 @@
 #include "ImGuiFileDialog.h"
 #include "gui.h"
 
-GUI::GUI(CPU &cpu, Bus &bus, Renderer &renderer, GuiLogger &gui_logger): cpu(cpu), bus(bus), renderer(renderer), gui_logger(gui_logger) {
+GUI::GUI(EmulationThread &emulation, Renderer &renderer, GuiLogger &gui_logger): emulation(emulation), renderer(renderer), gui_logger(gui_logger) {
     // From https://github.com/ocornut/imgui/blob/master/examples/example_sdl_opengl3/main.cpp
     // Setup SDL
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER) != 0)
@@ -61,8 +61,9 @@ GUI::~GUI() {
     SDL_Quit();
 }
 
-void GUI::display() {
+void GUI::display(const EmulationThread::debug_snapshot_t &snapshot) {
     std::string filePathName;
+    EmulationThread::command_t command;
 
     handle_events();
     // Start the Dear ImGui frame
@@ -70,24 +71,34 @@ void GUI::display() {
     ImGui_ImplSDL2_NewFrame();
     ImGui::NewFrame();
 
-    display_main_menu();
-    display_cpu();
+    display_main_menu(snapshot);
+    display_cpu(snapshot);
     display_tile_data();
     display_screen();
-    display_timer();
+    display_timer(snapshot);
     // display_disassembly();
     gui_logger.display();
-    mem_edit.DrawWindow("VRAM", bus.vram.get_raw_data(), 0x2000);
-    mem_edit.DrawWindow("IO", &(bus.io.data), 0x80);
-    if (bus.get_is_cart_inserted()) {
-        mem_edit.DrawWindow("Cartridge", bus.cartridge->get_raw_ROM_data(), bus.cartridge->get_raw_ROM_size());
+    // Memory editors are read only, so it's safe to cast away const
+    mem_edit.DrawWindow("VRAM", const_cast<uint8_t *>(snapshot.VRAM), sizeof(snapshot.VRAM));
+    mem_edit.DrawWindow("IO", const_cast<uint8_t *>(snapshot.IO), sizeof(snapshot.IO));
+    if (snapshot.cart_ROM) {
+        mem_edit.DrawWindow("Cartridge", const_cast<uint8_t *>(snapshot.cart_ROM->data()), snapshot.cart_ROM->size());
     }
 
     if (ImGuiFileDialog::Instance()->Display("ChCartKey")) {
         if (ImGuiFileDialog::Instance()->IsOk()) {
             filePathName = ImGuiFileDialog::Instance()->GetFilePathName();
-            bus.load_cartridge_from_file(filePathName);
-            cpu.restart();
+            command.type = EmulationThread::command_type_t::LOAD_CARTRIDGE;
+            command.file_path = filePathName;
+            emulation.send_command(command);
+        }
+        ImGuiFileDialog::Instance()->Close();
+    }
+    if (ImGuiFileDialog::Instance()->Display("RecordMovieKey")) {
+        if (ImGuiFileDialog::Instance()->IsOk()) {
+            command.type = EmulationThread::command_type_t::START_RECORDING;
+            command.file_path = ImGuiFileDialog::Instance()->GetFilePathName();
+            emulation.send_command(command);
         }
         ImGuiFileDialog::Instance()->Close();
     }
@@ -114,70 +125,47 @@ void GUI::handle_events() {
             should_close = true;
         if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE && event.window.windowID == SDL_GetWindowID(window))
             should_close = true;
-        if (event.type == SDL_KEYDOWN) {
-            switch (event.key.keysym.sym) {
-                case SDLK_w:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::UP, Joypad::btn_state_t::PRESSED);
-                    break;
-                case SDLK_a:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::LEFT, Joypad::btn_state_t::PRESSED);
-                    break;
-                case SDLK_s:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::DOWN, Joypad::btn_state_t::PRESSED);
-                    break;
-                case SDLK_d:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::RIGHT, Joypad::btn_state_t::PRESSED);
-                    break;
-                case SDLK_j:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::A, Joypad::btn_state_t::PRESSED);
-                    break;
-                case SDLK_k:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::B, Joypad::btn_state_t::PRESSED);
-                    break;
-                case SDLK_SPACE:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::SELECT, Joypad::btn_state_t::PRESSED);
-                    break;
-                case SDLK_RETURN:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::START, Joypad::btn_state_t::PRESSED);
-                    break;
-                default:
-                    break;
-            }
+        if (event.type == SDL_KEYDOWN && !event.key.repeat) {
+            send_button_change(event.key.keysym.sym, Joypad::btn_state_t::PRESSED);
         }
         if (event.type == SDL_KEYUP) {
-            switch (event.key.keysym.sym) {
-                case SDLK_w:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::UP, Joypad::btn_state_t::NOT_PRESSED);
-                    break;
-                case SDLK_a:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::LEFT, Joypad::btn_state_t::NOT_PRESSED);
-                    break;
-                case SDLK_s:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::DOWN, Joypad::btn_state_t::NOT_PRESSED);
-                    break;
-                case SDLK_d:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::RIGHT, Joypad::btn_state_t::NOT_PRESSED);
-                    break;
-                case SDLK_j:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::A, Joypad::btn_state_t::NOT_PRESSED);
-                    break;
-                case SDLK_k:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::B, Joypad::btn_state_t::NOT_PRESSED);
-                    break;
-                case SDLK_SPACE:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::SELECT, Joypad::btn_state_t::NOT_PRESSED);
-                    break;
-                case SDLK_RETURN:
-                    bus.io.joypad.btn_change_state(Joypad::btn_type_t::START, Joypad::btn_state_t::NOT_PRESSED);
-                    break;
-                default:
-                    break;
-            }
+            send_button_change(event.key.keysym.sym, Joypad::btn_state_t::NOT_PRESSED);
         }
     }
 }
 
-void GUI::display_main_menu() {
+void GUI::send_button_change(SDL_Keycode key, Joypad::btn_state_t state) {
+    switch (key) {
+        case SDLK_w:
+            emulation.send_button_change(Joypad::btn_type_t::UP, state);
+            break;
+        case SDLK_a:
+            emulation.send_button_change(Joypad::btn_type_t::LEFT, state);
+            break;
+        case SDLK_s:
+            emulation.send_button_change(Joypad::btn_type_t::DOWN, state);
+            break;
+        case SDLK_d:
+            emulation.send_button_change(Joypad::btn_type_t::RIGHT, state);
+            break;
+        case SDLK_j:
+            emulation.send_button_change(Joypad::btn_type_t::A, state);
+            break;
+        case SDLK_k:
+            emulation.send_button_change(Joypad::btn_type_t::B, state);
+            break;
+        case SDLK_SPACE:
+            emulation.send_button_change(Joypad::btn_type_t::SELECT, state);
+            break;
+        case SDLK_RETURN:
+            emulation.send_button_change(Joypad::btn_type_t::START, state);
+            break;
+        default:
+            break;
+    }
+}
+
+void GUI::display_main_menu(const EmulationThread::debug_snapshot_t &snapshot) {
     if (ImGui::BeginMainMenuBar()) {
         if (ImGui::BeginMenu("Cartridge")) {
             if (ImGui::MenuItem("Open..", "Ctrl+O")) {
@@ -185,12 +173,41 @@ void GUI::display_main_menu() {
             }
             ImGui::EndMenu();
         }
+        if (ImGui::BeginMenu("Emulation")) {
+            if (ImGui::MenuItem(snapshot.is_paused ? "Resume" : "Pause")) {
+                emulation.send_command(snapshot.is_paused ? EmulationThread::command_type_t::RESUME : EmulationThread::command_type_t::PAUSE);
+            }
+            if (ImGui::MenuItem("Reset")) {
+                emulation.send_command(EmulationThread::command_type_t::RESET);
+            }
+            if (snapshot.is_recording) {
+                if (ImGui::MenuItem("Stop recording")) {
+                    emulation.send_command(EmulationThread::command_type_t::STOP_RECORDING);
+                }
+            } else if (ImGui::MenuItem("Record movie..")) {
+                ImGuiFileDialog::Instance()->OpenDialog("RecordMovieKey", "Save the movie as", ".gbm", ".");
+            }
+            // Shows a frame from the future to hide the input lag of games
+            if (ImGui::BeginMenu("Run-ahead")) {
+                const char *labels[] = {"Off", "1 frame", "2 frames", "3 frames"};
+                for (unsigned frames = 0; frames < 4; ++frames) {
+                    if (ImGui::MenuItem(labels[frames], NULL, snapshot.run_ahead_frames == frames)) {
+                        EmulationThread::command_t command;
+                        command.type = EmulationThread::command_type_t::SET_RUN_AHEAD;
+                        command.run_ahead_frames = frames;
+                        emulation.send_command(command);
+                    }
+                }
+                ImGui::EndMenu();
+            }
+            ImGui::EndMenu();
+        }
         ImGui::EndMainMenuBar();
     }
 }
 
-void GUI::display_cpu() {
-    flags_reg_t cpu_flags_reg = cpu.get_flags_reg();
+void GUI::display_cpu(const EmulationThread::debug_snapshot_t &snapshot) {
+    flags_reg_t cpu_flags_reg = snapshot.flags_reg;
 
     ImGui::Begin("CPU", NULL);
     // Registers
@@ -198,35 +215,35 @@ void GUI::display_cpu() {
     ImGui::BeginTable("#cpu_registers_table", 3);
     ImGui::TableNextRow();
     ImGui::TableNextColumn();
-    ImGui::Text("A: 0x%02X", cpu.get_regA());
+    ImGui::Text("A: 0x%02X", snapshot.regA);
     ImGui::TableNextColumn();
     ImGui::Text("F: 0x%02X", cpu_flags_reg.value);
     ImGui::TableNextColumn();
-    ImGui::Text("AF: 0x%04X", (cpu.get_regA() << 8) | cpu_flags_reg.value);
+    ImGui::Text("AF: 0x%04X", (snapshot.regA << 8) | cpu_flags_reg.value);
 
     ImGui::TableNextRow();
     ImGui::TableNextColumn();
-    ImGui::Text("B: 0x%02X", cpu.get_regB());
+    ImGui::Text("B: 0x%02X", snapshot.regB);
     ImGui::TableNextColumn();
-    ImGui::Text("C: 0x%02X", cpu.get_regC());
+    ImGui::Text("C: 0x%02X", snapshot.regC);
     ImGui::TableNextColumn();
-    ImGui::Text("BC: 0x%04X", cpu.get_regBC());
+    ImGui::Text("BC: 0x%04X", snapshot.regBC);
 
     ImGui::TableNextRow();
     ImGui::TableNextColumn();
-    ImGui::Text("D: 0x%02X", cpu.get_regD());
+    ImGui::Text("D: 0x%02X", snapshot.regD);
     ImGui::TableNextColumn();
-    ImGui::Text("E: 0x%02X", cpu.get_regE());
+    ImGui::Text("E: 0x%02X", snapshot.regE);
     ImGui::TableNextColumn();
-    ImGui::Text("DE: 0x%04X", cpu.get_regDE());
+    ImGui::Text("DE: 0x%04X", snapshot.regDE);
 
     ImGui::TableNextRow();
     ImGui::TableNextColumn();
-    ImGui::Text("H: 0x%02X", cpu.get_regH());
+    ImGui::Text("H: 0x%02X", snapshot.regH);
     ImGui::TableNextColumn();
-    ImGui::Text("L: 0x%02X", cpu.get_regL());
+    ImGui::Text("L: 0x%02X", snapshot.regL);
     ImGui::TableNextColumn();
-    ImGui::Text("HL: 0x%04X", cpu.get_regHL());
+    ImGui::Text("HL: 0x%04X", snapshot.regHL);
 
     ImGui::EndTable();
 
@@ -234,9 +251,9 @@ void GUI::display_cpu() {
     ImGui::BeginTable("#flags_and_regs_table", 2);
     ImGui::TableNextRow();
     ImGui::TableNextColumn();
-    ImGui::Text("PC: 0x%04X", cpu.get_regPC());
+    ImGui::Text("PC: 0x%04X", snapshot.regPC);
     ImGui::TableNextColumn();
-    ImGui::Text("SP: 0x%04X", cpu.get_regSP());
+    ImGui::Text("SP: 0x%04X", snapshot.regSP);
     ImGui::TableNextRow();
     ImGui::TableNextColumn();
     ImGui::TextColored(ImVec4(1,1,0,1), "Flags");
@@ -268,13 +285,13 @@ void GUI::display_screen() {
     ImGui::End();
 }
 
-void GUI::display_timer() {
+void GUI::display_timer(const EmulationThread::debug_snapshot_t &snapshot) {
     ImGui::Begin("Timer", NULL);
-    ImGui::Text("DIV: 0x%02X", bus.io.timer.get_DIV());
-    ImGui::Text("TIMA: 0x%02X", bus.io.timer.get_TIMA());
-    ImGui::Text("TMA: %02X", bus.io.timer.get_TMA());
-    ImGui::Text("Enabled: %d", bus.io.timer.get_TAC_is_enabled());
-    ImGui::Text("Divider: %d", bus.io.timer.get_TAC_clock_divider());
+    ImGui::Text("DIV: 0x%02X", snapshot.DIV);
+    ImGui::Text("TIMA: 0x%02X", snapshot.TIMA);
+    ImGui::Text("TMA: %02X", snapshot.TMA);
+    ImGui::Text("Enabled: %d", snapshot.TAC_is_enabled);
+    ImGui::Text("Divider: %d", snapshot.TAC_clock_divider);
     ImGui::End();
 }
 
@@ -286,7 +303,7 @@ void GUI::display_timer() {
 //     auto disassembled = diss.get_disassembled_code();
 //     for (auto const &instr: disassembled) {
 //         sprintf(buf, "%04X %s", instr.address, instr.text);
-//         ImGui::Selectable(buf, cpu.get_regPC() == instr.address);
+//         ImGui::Selectable(buf, snapshot.regPC == instr.address);
 //     }
 
 //     ImGui::EndChild();
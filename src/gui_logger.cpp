@@ -1,9 +1,10 @@
 #include "gui_logger.h"
 #include <fstream>
 #include "imgui.h"
-#include "disassembler.h"
+#include "cpu/disassembler.h"
 
 void GuiLogger::log(std::string message) {
+    std::lock_guard<std::mutex> lock(messages_mutex);
     messages.push_back(message);
 }
 
@@ -11,10 +12,12 @@ void GuiLogger::log_instruction(instruction_t const& instruction) {
     char buffer[50];
     memset(buffer, 0, 50);
     Disassembler::disassemble_instr(instruction, buffer);
+    std::lock_guard<std::mutex> lock(messages_mutex);
     messages.push_back(buffer);
 }
 
-void GuiLogger::display() const {
+void GuiLogger::display() {
+    std::lock_guard<std::mutex> lock(messages_mutex);
     ImGui::Begin("Log", NULL);
     if (ImGui::Button("Save to file")) {
         std::fstream fs;
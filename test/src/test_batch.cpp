@@ -0,0 +1,171 @@
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "doctest/doctest.h"
+#include "batch/work_stealing_pool.h"
+#include "batch/batch_runner.h"
+
+TEST_SUITE("BATCH_TESTS") {
+    TEST_CASE("Work stealing pool") {
+        WorkStealingPool pool(4);
+        std::atomic<int> counter(0);
+
+        SUBCASE("All tasks are executed") {
+            for (int i = 0; i < 1000; ++i) {
+                pool.submit([&counter]() {++counter;});
+            }
+            pool.wait_idle();
+            CHECK(counter == 1000);
+        }
+
+        SUBCASE("Tasks submitted by tasks are waited for") {
+            for (int i = 0; i < 10; ++i) {
+                pool.submit([&pool, &counter]() {
+                    for (int j = 0; j < 100; ++j) {
+                        pool.submit([&counter]() {++counter;});
+                    }
+                });
+            }
+            pool.wait_idle();
+            CHECK(counter == 1000);
+        }
+
+        SUBCASE("Work is spread over threads") {
+            std::mutex mutex;
+            std::set<std::thread::id> thread_ids;
+            // All tasks land in the queue of one worker, others have to steal them
+            pool.submit([&]() {
+                for (int i = 0; i < 64; ++i) {
+                    pool.submit([&]() {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                        std::lock_guard<std::mutex> lock(mutex);
+                        thread_ids.insert(std::this_thread::get_id());
+                    });
+                }
+            });
+            pool.wait_idle();
+            CHECK(thread_ids.size() > 1);
+        }
+    }
+
+    TEST_CASE("Work stealing pool task order") {
+        // With one worker there is nobody to steal, so the order is only up to the worker's queue
+        WorkStealingPool pool(1);
+        std::vector<int> order;
+        pool.submit([&]() {
+            pool.submit([&order]() {order.push_back(1);});
+            pool.submit_behind([&order]() {order.push_back(3);});
+            pool.submit([&order]() {order.push_back(2);});
+        });
+        pool.wait_idle();
+        // Newest task first, the one submitted behind after all the others
+        REQUIRE(order.size() == 3);
+        CHECK(order[0] == 2);
+        CHECK(order[1] == 1);
+        CHECK(order[2] == 3);
+    }
+
+    TEST_CASE("Batch runner") {
+        BatchRunner runner(3);
+        BatchRunner::instance_config_t config;
+        std::mutex mutex;
+        std::vector<BatchRunner::result_t> results;
+        // Without a cartridge, ROM area is writable. JR -2 keeps the CPU in a loop at 0x100
+        auto add_looping_instance = [&runner](const BatchRunner::instance_config_t &config) {
+            size_t id = runner.add_instance(config);
+            runner.get_instance(id).bus.write(0x100, 0x18);
+            runner.get_instance(id).bus.write(0x101, 0xFE);
+            return id;
+        };
+        auto on_finished = [&](const BatchRunner::result_t &result, GameBoy &) {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(result);
+        };
+
+        SUBCASE("Every instance runs to its own limit") {
+            for (int i = 1; i <= 8; ++i) {
+                config.frame_limit = i;
+                add_looping_instance(config);
+            }
+            runner.run(on_finished);
+            REQUIRE(results.size() == 8);
+            for (auto &result: results) {
+                CHECK(result.error.empty());
+                CHECK(result.frames == result.instance_id + 1);
+                CHECK(runner.get_instance(result.instance_id).get_frame_count() == result.instance_id + 1);
+            }
+        }
+
+        SUBCASE("Cycle slices") {
+            runner.set_slice(BatchRunner::slice_unit_t::SLICE_CYCLES, 10000);
+            config.cycle_limit = 100000;
+            add_looping_instance(config);
+            add_looping_instance(config);
+            int slices = 0;
+            config.before_slice = [&slices](GameBoy &) {++slices;};
+            add_looping_instance(config);
+            runner.run(on_finished);
+            REQUIRE(results.size() == 3);
+            for (auto &result: results) {
+                CHECK(result.cycles >= 100000);
+                CHECK(result.cycles < 100000 + 24);
+            }
+            CHECK(slices == 10);
+        }
+
+        SUBCASE("Render mode") {
+            config.render_mode = render_mode_t::RENDER_EVERY_NTH_FRAME;
+            config.render_frame_interval = 4;
+            size_t id = add_looping_instance(config);
+            CHECK(runner.get_instance(id).ppu.get_render_mode() == render_mode_t::RENDER_EVERY_NTH_FRAME);
+            CHECK(runner.get_instance(id).ppu.get_render_frame_interval() == 4);
+        }
+
+        SUBCASE("Frame limit with LCD off") {
+            add_looping_instance(config);
+            config.frame_limit = 3;
+            add_looping_instance(config);
+            runner.get_instance(1).bus.write(0xFF40, 0x00);
+            runner.run(on_finished);
+            REQUIRE(results.size() == 2);
+            CHECK(runner.get_instance(1).get_cycles() == 3 * GameBoy::FRAME_CYCLES);
+        }
+
+        SUBCASE("Instances can finish early") {
+            struct serial_log_t: public SerialListenerInterface {
+                std::string text;
+                void serial_byte_sent(uint8_t value) {text += static_cast<char>(value);};
+            } serial_log;
+            runner.set_slice(BatchRunner::slice_unit_t::SLICE_CYCLES, 1000);
+            config.cycle_limit = 1000000;
+            config.is_done = [&serial_log](GameBoy &) {return !serial_log.text.empty();};
+            size_t id = runner.add_instance(config);
+            GameBoy &game_boy = runner.get_instance(id);
+            game_boy.bus.io.attach_serial_listener(&serial_log);
+            // LD A,'P'; LDH (SB),A; LD A,0x81; LDH (SC),A; JR -2
+            const uint8_t program[] = {0x3E, 'P', 0xE0, 0x01, 0x3E, 0x81, 0xE0, 0x02, 0x18, 0xFE};
+            for (unsigned i = 0; i < sizeof(program); ++i) {
+                game_boy.bus.write(0x100 + i, program[i]);
+            }
+            runner.run(on_finished);
+            REQUIRE(results.size() == 1);
+            CHECK(serial_log.text == "P");
+            CHECK(results[0].cycles < 2000);
+            // Transfer is finished at once
+            CHECK(game_boy.bus.read(0xFF02) == 0x01);
+            CHECK(results[0].seconds > 0);
+        }
+
+        SUBCASE("Errors are reported") {
+            config.ROM_path = "this_file_does_not_exist.gb";
+            config.frame_limit = 1;
+            runner.add_instance(config);
+            runner.run(on_finished);
+            REQUIRE(results.size() == 1);
+            CHECK_FALSE(results[0].error.empty());
+            CHECK(results[0].frames == 0);
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#include "doctest/doctest.h"
+#include "c_api.h"
+
+// ROM-only cartridge that stores 0x42 at 0xC010 and keeps copying 0xC020 to 0xC011
+static std::vector<uint8_t> make_test_ROM() {
+    std::vector<uint8_t> ROM(0x8000, 0x00);
+    const uint8_t program[] = {
+        0x3E, 0x42,       // 0x100: LD A,0x42
+        0xEA, 0x10, 0xC0, // 0x102: LD (0xC010),A
+        0xFA, 0x20, 0xC0, // 0x105: LD A,(0xC020)
+        0xEA, 0x11, 0xC0, // 0x108: LD (0xC011),A
+        0x18, 0xF8        // 0x10B: JR 0x105
+    };
+    memcpy(&ROM[0x100], program, sizeof(program));
+    return ROM;
+}
+
+TEST_SUITE("C_API_TESTS") {
+    TEST_CASE("Running a ROM from memory") {
+        gb_t *gb = gb_create();
+        REQUIRE(gb != nullptr);
+        std::vector<uint8_t> ROM = make_test_ROM();
+        REQUIRE(gb_load_rom_mem(gb, ROM.data(), ROM.size()) == GB_OK);
+
+        SUBCASE("Memory is shared, not copied") {
+            size_t size = 0;
+            uint8_t *WRAM = gb_memory_ptr(gb, GB_MEMORY_WRAM, &size);
+            CHECK(size == 0x2000);
+            REQUIRE(gb_step_frames(gb, 1) == GB_OK);
+            CHECK(WRAM[0x10] == 0x42);
+            WRAM[0x20] = 0x77;
+            REQUIRE(gb_step_frames(gb, 1) == GB_OK);
+            CHECK(WRAM[0x11] == 0x77);
+            CHECK(gb_memory_ptr(gb, GB_MEMORY_WRAM, nullptr) == WRAM);
+            CHECK(gb_memory_ptr(gb, GB_MEMORY_OAM, &size) != nullptr);
+            CHECK(size == 0xA0);
+        }
+
+        SUBCASE("VRAM writes update decoded tiles") {
+            // Tile 0, which fills the whole background, gets color 3 in every pixel
+            std::vector<uint8_t> tile(16, 0xFF);
+            REQUIRE(gb_vram_write(gb, 0x0000, tile.data(), tile.size()) == GB_OK);
+            size_t size = 0;
+            const uint8_t *VRAM = gb_memory_ptr(gb, GB_MEMORY_VRAM, &size);
+            CHECK(size == 0x2000);
+            CHECK(VRAM[0x0F] == 0xFF);
+            REQUIRE(gb_step_frames(gb, 2) == GB_OK);
+            const uint8_t *frame = gb_framebuffer_ptr(gb);
+            CHECK(frame[0] == 3);
+            CHECK(frame[143 * GB_FRAMEBUFFER_WIDTH + 159] == 3);
+            CHECK(gb_vram_write(gb, 0x1FFF, tile.data(), 2) == GB_ERROR);
+            CHECK(gb_vram_write(gb, 0x1FFE, tile.data(), 2) == GB_OK);
+        }
+
+        SUBCASE("Frames") {
+            REQUIRE(gb_step_frames(gb, 2) == GB_OK);
+            const uint8_t *frame = gb_framebuffer_ptr(gb);
+            REQUIRE(frame != nullptr);
+            // Without any tiles the whole frame has the shade of color 0
+            CHECK(frame[0] == frame[GB_FRAMEBUFFER_WIDTH * GB_FRAMEBUFFER_HEIGHT - 1]);
+            gb_set_input(gb, GB_BUTTON_A | GB_BUTTON_START);
+            gb_set_input(gb, GB_BUTTON_START);
+            CHECK(gb_step_frames(gb, 1) == GB_OK);
+        }
+
+        SUBCASE("Observations") {
+            size_t size = 0;
+            CHECK(gb_observation_ptr(gb, 0, &size) == nullptr);
+            CHECK(gb_configure_observation(gb, GB_OBSERVATION_GRAYSCALE_RESIZED, 200, 84, 4) == GB_ERROR);
+            REQUIRE(gb_configure_observation(gb, GB_OBSERVATION_GRAYSCALE_RESIZED, 84, 84, 4) == GB_OK);
+            REQUIRE(gb_step_frames(gb, 2) == GB_OK);
+            CHECK(gb_observation_ptr(gb, 3, &size) != nullptr);
+            CHECK(size == 84 * 84);
+            CHECK(gb_observation_ptr(gb, 4, &size) == nullptr);
+        }
+
+        SUBCASE("Errors are reported") {
+            CHECK(gb_load_rom_mem(gb, ROM.data(), 0x10) == GB_ERROR);
+            CHECK(std::string(gb_last_error(gb)).size() > 0);
+            // The cartridge that was inserted before is still there
+            CHECK(gb_step_frames(gb, 1) == GB_OK);
+            CHECK(std::string(gb_last_error(gb)).empty());
+            CHECK(gb_memory_ptr(gb, GB_MEMORY_WRAM, nullptr)[0x10] == 0x42);
+        }
+
+        gb_destroy(gb);
+    }
+}
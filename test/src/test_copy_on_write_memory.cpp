@@ -0,0 +1,31 @@
+#include "doctest/doctest.h"
+#include "memory/copy_on_write_memory.h"
+
+TEST_SUITE("COPY_ON_WRITE_MEMORY_TESTS") {
+    TEST_CASE("Copies share pages until written") {
+        CopyOnWriteMemory original(4 * CopyOnWriteMemory::PAGE_SIZE);
+        original.write(0x0010, 0x12);
+        CHECK(original.get_shared_page_count() == 0);
+
+        CopyOnWriteMemory copy(original);
+        CHECK(copy.read(0x0010) == 0x12);
+        CHECK(copy.get_shared_page_count() == 4);
+        CHECK(original.get_shared_page_count() == 4);
+
+        copy.write(0x1000, 0x34);
+        CHECK(copy.get_shared_page_count() == 3);
+        CHECK(original.read(0x1000) == 0x00);
+        original.write(0x0010, 0x56);
+        CHECK(copy.read(0x0010) == 0x12);
+
+        SUBCASE("Loading leaves unchanged pages shared") {
+            uint8_t data[4 * CopyOnWriteMemory::PAGE_SIZE];
+            copy.copy_to(data);
+            data[0x3000] = 0x78;
+            copy.copy_from(data);
+            CHECK(copy.get_shared_page_count() == 2);
+            CHECK(copy.read(0x3000) == 0x78);
+            CHECK(original.read(0x3000) == 0x00);
+        }
+    }
+}
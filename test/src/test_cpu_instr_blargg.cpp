@@ -21,7 +21,7 @@ const std::string BLARGG_CPU_TESTS_DIR = "../../test/test_roms/gb-test-roms/cpu_
     const char *passed_str_pos; \
     while (test_running) { \
         cycles = cpu.exec_next_instr(); \
-        bus.io.timer.tick(cycles); \
+        bus.scheduler.advance(cycles); \
         total_cycles += cycles; \
         if (bus.get_serial_data_newline_count() >= expected_new_line_count) { \
             test_running = false; \
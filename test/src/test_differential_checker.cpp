@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <memory>
+#include "doctest/doctest.h"
+#include "cpu/differential_checker.h"
+
+// A loop with a conditional jump, memory accesses and VBlank interrupts returning through NOPs to 0x100
+static const uint8_t TEST_PROGRAM[] = {
+    0xFB,             // 0x100: EI
+    0x3E, 0x10,       // 0x101: LD A,0x10
+    0x06, 0x05,       // 0x103: LD B,0x05
+    0x21, 0x00, 0xC0, // 0x105: LD HL,0xC000
+    0x80,             // 0x108: ADD A,B
+    0x77,             // 0x109: LD (HL),A
+    0x23,             // 0x10A: INC HL
+    0xCB, 0x37,       // 0x10B: SWAP A
+    0x05,             // 0x10D: DEC B
+    0x20, 0xF8,       // 0x10E: JR NZ,-8
+    0xC3, 0x03, 0x01  // 0x110: JP 0x103
+};
+
+static std::unique_ptr<GameBoy> make_machine() {
+    // Without a cartridge, ROM area is writable
+    std::unique_ptr<GameBoy> game_boy = std::make_unique<GameBoy>();
+    for (unsigned i = 0; i < sizeof(TEST_PROGRAM); ++i) {
+        game_boy->bus.write(0x100 + i, TEST_PROGRAM[i]);
+    }
+    game_boy->bus.write(0xFFFF, 0x01);
+    return game_boy;
+}
+
+/**
+ * The scalar interpreter with a bug: A gets corrupted after executing the instruction at the given address
+ */
+class BrokenCPUEngine: public ScalarCPUEngine {
+public:
+    BrokenCPUEngine(GameBoy &game_boy, uint16_t broken_address): ScalarCPUEngine(game_boy), broken_address(broken_address) {
+
+    }
+
+    std::string get_name() {
+        return "broken";
+    }
+
+    void run_until(uint64_t target_cycle) {
+        GameBoy &game_boy = get_game_boy();
+        while (game_boy.get_cycles() < target_cycle) {
+            uint16_t address = game_boy.cpu.get_regPC();
+            game_boy.cpu.run_until(game_boy.get_cycles() + 1);
+            if (address == broken_address) {
+                CPU::state_t state;
+                game_boy.cpu.save_state(state);
+                state.A ^= 0x01;
+                game_boy.cpu.load_state(state);
+            }
+        }
+    }
+
+private:
+    uint16_t broken_address;
+};
+
+TEST_SUITE("DIFFERENTIAL_CHECKER_TESTS") {
+    TEST_CASE("Scalar and lockstep engines do not diverge") {
+        const uint64_t TARGET_CYCLE = 300000;
+        DifferentialChecker::config_t config;
+        SUBCASE("After every instruction") {
+            config.block_cycles = 0;
+        }
+        SUBCASE("After blocks of cycles") {
+            config.block_cycles = 1000;
+        }
+        std::unique_ptr<GameBoy> reference_game_boy = make_machine();
+        std::unique_ptr<GameBoy> checked_game_boy = make_machine();
+        ScalarCPUEngine reference(*reference_game_boy);
+        LockstepCPUEngine checked(*checked_game_boy);
+        DifferentialChecker checker(reference, checked, config);
+        CHECK(checker.run_until(TARGET_CYCLE / 2));
+        CHECK(checker.run_until(TARGET_CYCLE));
+        CHECK_FALSE(checker.has_diverged());
+        CHECK(checker.get_step_count() > 0);
+        CHECK(reference_game_boy->get_cycles() >= TARGET_CYCLE);
+        CHECK(checked_game_boy->get_cycles() == reference_game_boy->get_cycles());
+        CHECK(checked_game_boy->cpu.get_regHL() == reference_game_boy->cpu.get_regHL());
+    }
+
+    TEST_CASE("Finds the instruction that diverged") {
+        std::unique_ptr<GameBoy> reference_game_boy = make_machine();
+        std::unique_ptr<GameBoy> checked_game_boy = make_machine();
+        ScalarCPUEngine reference(*reference_game_boy);
+        BrokenCPUEngine checked(*checked_game_boy, 0x10B);
+        DifferentialChecker::config_t config;
+        config.context_size = 4;
+        DifferentialChecker checker(reference, checked, config);
+        CHECK_FALSE(checker.run_until(100000));
+        REQUIRE(checker.has_diverged());
+        const DifferentialChecker::divergence_t &divergence = checker.get_divergence();
+        CHECK(divergence.step_no > 0);
+        CHECK(divergence.differences.size() == 1);
+        CHECK(divergence.differences[0] == "A");
+        CHECK(divergence.reference_state.cpu.A == (divergence.checked_state.cpu.A ^ 0x01));
+        CHECK(divergence.reference_state.cpu.PC == 0x10D);
+        CHECK(divergence.context.size() == 4);
+        CHECK(divergence.context.back().find("0x010B") == 0);
+        CHECK(divergence.context.back().find("SWAP") != std::string::npos);
+        std::string report = checker.get_report();
+        CHECK(report.find("diverged after " + std::to_string(divergence.step_no)) != std::string::npos);
+        CHECK(report.find("broken") != std::string::npos);
+        // Stops at the divergence
+        uint64_t cycles = reference_game_boy->get_cycles();
+        CHECK_FALSE(checker.run_until(200000));
+        CHECK(reference_game_boy->get_cycles() == cycles);
+    }
+}
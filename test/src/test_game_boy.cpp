@@ -0,0 +1,109 @@
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "doctest/doctest.h"
+#include "game_boy.h"
+
+TEST_SUITE("GAME_BOY_TESTS") {
+    TEST_CASE("Running") {
+        // Without a cartridge, ROM area is writable. JR -2 keeps the CPU in a loop at 0x100
+        std::unique_ptr<GameBoy> game_boy = std::make_unique<GameBoy>();
+        game_boy->bus.write(0x100, 0x18);
+        game_boy->bus.write(0x101, 0xFE);
+
+        SUBCASE("Run frames stops right after VBlank") {
+            game_boy->run_frames(1);
+            CHECK(game_boy->get_frame_count() == 1);
+            CHECK(game_boy->get_cycles() == 144 * 456);
+            game_boy->run_frames(2);
+            CHECK(game_boy->get_frame_count() == 3);
+            CHECK(game_boy->get_cycles() == 144 * 456 + 2 * GameBoy::FRAME_CYCLES);
+        }
+
+        SUBCASE("Frames are counted by cycles when LCD is off") {
+            game_boy->bus.write(0xFF40, 0x00);
+            game_boy->run_frames(2);
+            CHECK(game_boy->get_frame_count() == 0);
+            CHECK(game_boy->get_cycles() == 2 * GameBoy::FRAME_CYCLES);
+        }
+
+        SUBCASE("Run cycles") {
+            game_boy->run_cycles(1000);
+            // Stops at the first instruction boundary at or after the target
+            CHECK(game_boy->get_cycles() >= 1000);
+            CHECK(game_boy->get_cycles() < 1000 + 24);
+            CHECK(game_boy->cpu.get_executed_instr_count() > 0);
+        }
+    }
+
+    TEST_CASE("Instances are independent") {
+        std::unique_ptr<GameBoy> first = std::make_unique<GameBoy>();
+        std::unique_ptr<GameBoy> second = std::make_unique<GameBoy>();
+        first->run_frames(1);
+        first->bus.write(0xC000, 0x12);
+        CHECK(second->get_cycles() == 0);
+        CHECK(second->bus.read(0xC000) == 0x00);
+    }
+
+    TEST_CASE("Fork") {
+        // MBC1 with 32kB of RAM. The program enables the RAM and keeps incrementing its first 256 bytes
+        std::vector<uint8_t> ROM(0x8000, 0x00);
+        const uint8_t program[] = {0x3E, 0x0A, 0xEA, 0x00, 0x00, 0x21, 0x00, 0xA0, 0x34, 0x2C, 0x18, 0xFC};
+        memcpy(&ROM[0x100], program, sizeof(program));
+        ROM[0x147] = 0x03;
+        ROM[0x149] = 0x03;
+        std::unique_ptr<GameBoy> parent = std::make_unique<GameBoy>();
+        parent->load_cartridge_from_memory(ROM.data(), ROM.size());
+        parent->run_frames(3);
+
+        std::unique_ptr<GameBoy> child = parent->fork();
+        std::vector<uint8_t> parent_state, child_state;
+        parent->save_state(parent_state);
+        child->save_state(child_state);
+        CHECK(child_state == parent_state);
+        CHECK(child->bus.get_cartridge()->get_raw_ROM_data() == parent->bus.get_cartridge()->get_raw_ROM_data());
+
+        SUBCASE("Fork runs like the parent") {
+            parent->run_frames(2);
+            child->run_frames(2);
+            parent->save_state(parent_state);
+            child->save_state(child_state);
+            CHECK(child_state == parent_state);
+        }
+
+        SUBCASE("Writes aren't seen by the other machine") {
+            uint8_t value = parent->bus.read(0xA100);
+            child->bus.write(0xA100, value + 1);
+            child->bus.write(0xC000, 0x12);
+            CHECK(parent->bus.read(0xA100) == value);
+            CHECK(parent->bus.read(0xC000) == 0x00);
+            CHECK(child->bus.read(0xA100) == value + 1);
+            parent->bus.write(0xA100, value + 2);
+            CHECK(child->bus.read(0xA100) == value + 1);
+        }
+
+        SUBCASE("Forks of forks") {
+            std::unique_ptr<GameBoy> grandchild = child->fork();
+            child.reset();
+            parent->run_frames(1);
+            grandchild->run_frames(1);
+            parent->save_state(parent_state);
+            grandchild->save_state(child_state);
+            CHECK(child_state == parent_state);
+        }
+    }
+
+    TEST_CASE("Fork without a cartridge") {
+        std::unique_ptr<GameBoy> parent = std::make_unique<GameBoy>();
+        const uint8_t program[] = {0x21, 0x00, 0xC0, 0x34, 0x2C, 0x18, 0xFC};
+        for (unsigned i = 0; i < sizeof(program); ++i) {
+            parent->bus.write(0x100 + i, program[i]);
+        }
+        parent->run_frames(1);
+        std::unique_ptr<GameBoy> child = parent->fork();
+        parent->run_frames(1);
+        child->run_frames(1);
+        CHECK(child->get_cycles() == parent->get_cycles());
+        CHECK(memcmp(child->bus.wram.get_raw_data(), parent->bus.wram.get_raw_data(), WorkRAM::WRAM_SIZE) == 0);
+    }
+}
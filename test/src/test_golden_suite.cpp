@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "doctest/doctest.h"
+#include "golden_suite.h"
+
+static const char *SUITE_PATH = "./test_golden_suite.golden";
+
+static void write_file(const std::string &file_path, const std::string &content) {
+    std::ofstream file(file_path);
+    file << content;
+}
+
+static std::string read_file(const std::string &file_path) {
+    std::ifstream file(file_path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+static bool load_throws_runtime_error(const std::string &content) {
+    write_file(SUITE_PATH, content);
+    GoldenSuite suite;
+    try {
+        suite.load_from_file(SUITE_PATH);
+    } catch (std::runtime_error &) {
+        remove(SUITE_PATH);
+        return true;
+    }
+    remove(SUITE_PATH);
+    return false;
+}
+
+TEST_SUITE("GOLDEN_SUITE_TESTS") {
+    TEST_CASE("Parses entries and keeps comments when saved") {
+        const std::string content =
+            "# Comment before the entries\n"
+            "roms/first.gb 300 60=00000000000000ff\n"
+            "\n"
+            "/abs/second.gb input=inputs/second.txt 10=0123456789abcdef 20\n"
+            "# Trailing comment\n";
+        write_file(SUITE_PATH, content);
+        GoldenSuite suite;
+        suite.load_from_file(SUITE_PATH);
+        std::vector<GoldenSuite::entry_t> &entries = suite.get_entries();
+        REQUIRE(entries.size() == 2);
+
+        CHECK(entries[0].ROM_name == "roms/first.gb");
+        CHECK(entries[0].ROM_path == "./roms/first.gb");
+        CHECK(entries[0].input_script_name.empty());
+        CHECK(entries[0].input_script_path.empty());
+        // Checkpoints are sorted by frame
+        REQUIRE(entries[0].checkpoints.size() == 2);
+        CHECK(entries[0].checkpoints[0].frame == 60);
+        CHECK(entries[0].checkpoints[0].has_hash);
+        CHECK(entries[0].checkpoints[0].hash == 0xFF);
+        CHECK(entries[0].checkpoints[1].frame == 300);
+        CHECK_FALSE(entries[0].checkpoints[1].has_hash);
+
+        CHECK(entries[1].ROM_path == "/abs/second.gb");
+        CHECK(entries[1].input_script_name == "inputs/second.txt");
+        CHECK(entries[1].input_script_path == "./inputs/second.txt");
+        REQUIRE(entries[1].checkpoints.size() == 2);
+        CHECK(entries[1].checkpoints[0].hash == 0x0123456789ABCDEFull);
+        CHECK_FALSE(entries[1].checkpoints[1].has_hash);
+
+        // Recorded hashes are written back in place, everything else stays as it was
+        entries[0].checkpoints[1].has_hash = true;
+        entries[0].checkpoints[1].hash = 0xABC;
+        entries[1].checkpoints[1].has_hash = true;
+        entries[1].checkpoints[1].hash = 0xFEDCBA9876543210ull;
+        suite.save_to_file(SUITE_PATH);
+        CHECK(read_file(SUITE_PATH) ==
+            "# Comment before the entries\n"
+            "roms/first.gb 60=00000000000000ff 300=0000000000000abc\n"
+            "\n"
+            "/abs/second.gb input=inputs/second.txt 10=0123456789abcdef 20=fedcba9876543210\n"
+            "# Trailing comment\n");
+
+        GoldenSuite reloaded;
+        reloaded.load_from_file(SUITE_PATH);
+        remove(SUITE_PATH);
+        REQUIRE(reloaded.get_entries().size() == 2);
+        CHECK(reloaded.get_entries()[1].checkpoints[1].hash == 0xFEDCBA9876543210ull);
+    }
+
+    TEST_CASE("Refuses invalid lines") {
+        CHECK(load_throws_runtime_error("rom.gb\n"));
+        CHECK(load_throws_runtime_error("rom.gb 0=0000000000000001\n"));
+        CHECK(load_throws_runtime_error("rom.gb sixty\n"));
+        CHECK(load_throws_runtime_error("rom.gb 60=not_a_hash\n"));
+        CHECK_FALSE(load_throws_runtime_error("rom.gb 60\n"));
+        GoldenSuite suite;
+        bool is_missing_file_refused = false;
+        try {
+            suite.load_from_file("./missing.golden");
+        } catch (std::runtime_error &) {
+            is_missing_file_refused = true;
+        }
+        CHECK(is_missing_file_refused);
+    }
+}
@@ -0,0 +1,90 @@
+#include <memory>
+#include <vector>
+#include "doctest/doctest.h"
+#include "cpu/lockstep_cpu.h"
+
+// Every lane loads its own counter from 0xC100, so the lanes split off at JR C and JP NZ and meet again later
+static const uint8_t TEST_PROGRAM[] = {
+    0xFB,             // 0x100: EI
+    0xFA, 0x00, 0xC1, // 0x101: LD A,(0xC100)
+    0x47,             // 0x104: LD B,A
+    0x3E, 0x10,       // 0x105: LD A,0x10
+    0x0E, 0x00,       // 0x107: LD C,0x00
+    0x80,             // 0x109: ADD A,B
+    0x0C,             // 0x10A: INC C
+    0xA9,             // 0x10B: XOR C
+    0x57,             // 0x10C: LD D,A
+    0xD6, 0x03,       // 0x10D: SUB 0x03
+    0x21, 0x00, 0xC0, // 0x10F: LD HL,0xC000
+    0x77,             // 0x112: LD (HL),A
+    0xFE, 0x80,       // 0x113: CP 0x80
+    0x38, 0x01,       // 0x115: JR C,+1
+    0x1C,             // 0x117: INC E
+    0x13,             // 0x118: INC DE
+    0x8F,             // 0x119: ADC A,A
+    0x9A,             // 0x11A: SBC A,D
+    0xE6, 0xF7,       // 0x11B: AND 0xF7
+    0x05,             // 0x11D: DEC B
+    0xC2, 0x09, 0x01, // 0x11E: JP NZ,0x109
+    0x04,             // 0x121: INC B
+    0xC3, 0x09, 0x01  // 0x122: JP 0x109
+};
+
+static std::unique_ptr<GameBoy> make_lane(uint8_t counter, uint8_t interrupt_enable) {
+    // Without a cartridge, ROM area is writable. NOPs from the interrupt vectors lead back to 0x100
+    std::unique_ptr<GameBoy> game_boy = std::make_unique<GameBoy>();
+    for (unsigned i = 0; i < sizeof(TEST_PROGRAM); ++i) {
+        game_boy->bus.write(0x100 + i, TEST_PROGRAM[i]);
+    }
+    game_boy->bus.write(0xC100, counter);
+    game_boy->bus.write(0xFFFF, interrupt_enable);
+    return game_boy;
+}
+
+TEST_SUITE("LOCKSTEP_CPU_TESTS") {
+    TEST_CASE("Matches the scalar CPU") {
+        const unsigned LANES = 8;
+        const uint64_t TARGET_CYCLE = 200000;
+        uint8_t interrupt_enable = 0x00;
+        SUBCASE("Without interrupts") {
+            interrupt_enable = 0x00;
+        }
+        SUBCASE("With VBlank interrupts") {
+            interrupt_enable = 0x01;
+        }
+
+        std::vector<std::unique_ptr<GameBoy>> lockstep_lanes, scalar_lanes;
+        std::vector<GameBoy *> lane_pointers;
+        for (unsigned i = 0; i < LANES; ++i) {
+            // Pairs of lanes get the same counter, so some of them never diverge
+            uint8_t counter = (i / 2) * 37 + 1;
+            lockstep_lanes.push_back(make_lane(counter, interrupt_enable));
+            scalar_lanes.push_back(make_lane(counter, interrupt_enable));
+            lane_pointers.push_back(lockstep_lanes.back().get());
+        }
+
+        LockstepCPU lockstep(lane_pointers);
+        lockstep.run_until(TARGET_CYCLE / 2);
+        lockstep.run_until(TARGET_CYCLE);
+        for (unsigned i = 0; i < LANES; ++i) {
+            scalar_lanes[i]->cpu.run_until(TARGET_CYCLE);
+        }
+
+        CHECK(lockstep.get_lockstep_instr_count() > lockstep.get_scalar_instr_count());
+        for (unsigned i = 0; i < LANES; ++i) {
+            CPU &expected = scalar_lanes[i]->cpu;
+            CPU &actual = lockstep_lanes[i]->cpu;
+            CHECK(actual.get_regA() == expected.get_regA());
+            CHECK(actual.get_flags_reg().value == expected.get_flags_reg().value);
+            CHECK(actual.get_regBC() == expected.get_regBC());
+            CHECK(actual.get_regDE() == expected.get_regDE());
+            CHECK(actual.get_regHL() == expected.get_regHL());
+            CHECK(actual.get_regSP() == expected.get_regSP());
+            CHECK(actual.get_regPC() == expected.get_regPC());
+            CHECK(actual.get_executed_instr_count() == expected.get_executed_instr_count());
+            CHECK(lockstep_lanes[i]->get_cycles() == scalar_lanes[i]->get_cycles());
+            CHECK(lockstep_lanes[i]->get_frame_count() == scalar_lanes[i]->get_frame_count());
+            CHECK(lockstep_lanes[i]->bus.read(0xC000) == scalar_lanes[i]->bus.read(0xC000));
+        }
+    }
+}
@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "doctest/doctest.h"
+#include "game_boy.h"
+#include "movie/movie.h"
+#include "movie/movie_player.h"
+#include "movie/movie_recorder.h"
+
+/**
+ * ROM only cartridge. The program keeps adding the state of the direction buttons to bytes of 0xC000-0xC0FF,
+ * so the RAM depends on the exact cycles input changed at
+ */
+static std::vector<uint8_t> make_test_ROM() {
+    std::vector<uint8_t> ROM(0x8000, 0x00);
+    const uint8_t program[] = {
+        0x3E, 0x20,       // 0x100: LD A,0x20 - select direction buttons
+        0xE0, 0x00,       // 0x102: LDH (P1),A
+        0x21, 0x00, 0xC0, // 0x104: LD HL,0xC000
+        0xF0, 0x00,       // 0x107: LDH A,(P1)
+        0x86,             // 0x109: ADD A,(HL)
+        0x77,             // 0x10A: LD (HL),A
+        0x2C,             // 0x10B: INC L
+        0x18, 0xF9        // 0x10C: JR 0x107
+    };
+    memcpy(&ROM[0x100], program, sizeof(program));
+    return ROM;
+}
+
+TEST_SUITE("MOVIE_TESTS") {
+    TEST_CASE("Replaying a recorded movie") {
+        std::vector<uint8_t> ROM = make_test_ROM();
+        std::unique_ptr<GameBoy> game_boy = std::make_unique<GameBoy>();
+        game_boy->load_cartridge_from_memory(ROM.data(), ROM.size());
+        MovieRecorder recorder(*game_boy, 20);
+
+        // States at the start of every frame, after its input
+        std::map<uint64_t, std::vector<uint8_t>> states;
+        for (unsigned frame = 0; frame < 100; ++frame) {
+            game_boy->set_button(Joypad::RIGHT, (frame % 7 < 3) ? Joypad::PRESSED : Joypad::NOT_PRESSED);
+            recorder.update();
+            game_boy->save_state(states[game_boy->get_frame_count()]);
+            // Input changes in the middle of a frame too
+            game_boy->run_cycles(1000 + 37 * frame);
+            game_boy->set_button(Joypad::UP, (frame % 5 < 2) ? Joypad::PRESSED : Joypad::NOT_PRESSED);
+            recorder.update();
+            game_boy->run_frames(1);
+        }
+        recorder.update();
+        game_boy->save_state(states[game_boy->get_frame_count()]);
+        Movie &movie = recorder.get_movie();
+        CHECK(movie.get_keyframes().size() == 6);
+        CHECK(movie.get_events().size() > 50);
+        CHECK(movie.get_end_frame_no() == 100);
+
+        const char *file_path = "test_movie.gbm";
+        movie.save_to_file(file_path);
+        Movie loaded_movie;
+        loaded_movie.load_from_file(file_path);
+        remove(file_path);
+        CHECK(loaded_movie.get_events().size() == movie.get_events().size());
+        CHECK(loaded_movie.get_keyframes().size() == movie.get_keyframes().size());
+
+        std::unique_ptr<GameBoy> replay = std::make_unique<GameBoy>();
+        replay->load_cartridge_from_memory(ROM.data(), ROM.size());
+        MoviePlayer player(*replay, loaded_movie);
+        std::vector<uint8_t> state;
+
+        SUBCASE("Playing from the start") {
+            player.run_frames(100);
+            CHECK(player.is_finished());
+            replay->save_state(state);
+            CHECK(state == states[100]);
+        }
+
+        SUBCASE("Seeking") {
+            for (uint64_t frame_no: {57, 20, 21, 99, 0, 30, 31, 100}) {
+                player.seek_to_frame(frame_no);
+                CHECK(replay->get_frame_count() == frame_no);
+                replay->save_state(state);
+                CHECK(state == states[frame_no]);
+            }
+        }
+
+        SUBCASE("Movie of another ROM") {
+            ROM[0x150] = 0x01;
+            std::unique_ptr<GameBoy> other = std::make_unique<GameBoy>();
+            other->load_cartridge_from_memory(ROM.data(), ROM.size());
+            bool is_refused = false;
+            try {
+                MoviePlayer other_player(*other, loaded_movie);
+            } catch (std::runtime_error &) {
+                is_refused = true;
+            }
+            CHECK(is_refused);
+        }
+    }
+
+    TEST_CASE("Button held over a keyframe is released on replay") {
+        std::vector<uint8_t> ROM = make_test_ROM();
+        std::unique_ptr<GameBoy> game_boy = std::make_unique<GameBoy>();
+        game_boy->load_cartridge_from_memory(ROM.data(), ROM.size());
+        MovieRecorder recorder(*game_boy, 5);
+        for (unsigned frame = 0; frame < 12; ++frame) {
+            // Pressed before the keyframe at frame 5 and released after it
+            if (frame == 3) {
+                game_boy->set_button(Joypad::RIGHT, Joypad::PRESSED);
+            } else if (frame == 8) {
+                game_boy->set_button(Joypad::RIGHT, Joypad::NOT_PRESSED);
+            }
+            recorder.update();
+            game_boy->run_frames(1);
+        }
+        recorder.update();
+        std::vector<uint8_t> expected_state;
+        game_boy->save_state(expected_state);
+        Movie &movie = recorder.get_movie();
+        REQUIRE(movie.get_keyframes().size() >= 2);
+        CHECK(movie.get_keyframes()[1].frame_no == 5);
+
+        std::unique_ptr<GameBoy> replay = std::make_unique<GameBoy>();
+        replay->load_cartridge_from_memory(ROM.data(), ROM.size());
+        MoviePlayer player(*replay, movie);
+        // Starts from the keyframe, with the button already held
+        player.seek_to_frame(6);
+        CHECK(replay->bus.io.joypad.get_pressed_buttons() == (1 << Joypad::RIGHT));
+        player.seek_to_frame(12);
+        CHECK(replay->bus.io.joypad.get_pressed_buttons() == 0);
+        std::vector<uint8_t> state;
+        replay->save_state(state);
+        CHECK(state == expected_state);
+    }
+}
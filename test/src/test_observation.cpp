@@ -0,0 +1,105 @@
+#include <memory>
+#include <vector>
+#include "doctest/doctest.h"
+#include "observation.h"
+#include "game_boy.h"
+
+static const unsigned STRIDE = 256;
+
+// Shade of every source pixel depends on its position
+static std::vector<uint8_t> make_frame(uint8_t offset) {
+    std::vector<uint8_t> pixels(STRIDE * 256);
+    for (unsigned y = 0; y < 256; ++y) {
+        for (unsigned x = 0; x < STRIDE; ++x) {
+            pixels[y * STRIDE + x] = (x + y + offset) % 4;
+        }
+    }
+    return pixels;
+}
+
+TEST_SUITE("OBSERVATION_TESTS") {
+    TEST_CASE("Formats") {
+        ObservationStage::config_t config;
+        config.stack_size = 1;
+        std::vector<uint8_t> pixels = make_frame(0);
+
+        SUBCASE("Grayscale") {
+            config.format = ObservationStage::GRAYSCALE;
+            ObservationStage stage(config);
+            stage.push_frame(pixels.data(), STRIDE, 0);
+            const uint8_t *observation = stage.get_observation(0);
+            CHECK(stage.get_observation_size() == 160 * 144);
+            CHECK(observation[0] == 255);
+            CHECK(observation[1] == 170);
+            CHECK(observation[2] == 85);
+            CHECK(observation[3] == 0);
+            CHECK(observation[160 + 2] == 0);
+        }
+
+        SUBCASE("Resized") {
+            config.format = ObservationStage::GRAYSCALE_RESIZED;
+            config.width = 80;
+            config.height = 72;
+            ObservationStage stage(config);
+            stage.push_frame(pixels.data(), STRIDE, 0);
+            const uint8_t *observation = stage.get_observation(0);
+            CHECK(stage.get_observation_size() == 80 * 72);
+            // Exactly 2x smaller, so every output pixel takes source pixel (2x + 1, 2y + 1)
+            CHECK(observation[0] == 85);
+            CHECK(observation[1] == 255);
+            CHECK(observation[80] == 255);
+        }
+
+        SUBCASE("Packed") {
+            config.format = ObservationStage::PACKED_2BIT;
+            ObservationStage stage(config);
+            stage.push_frame(pixels.data(), STRIDE, 0);
+            const uint8_t *observation = stage.get_observation(0);
+            CHECK(stage.get_row_size() == 40);
+            CHECK(stage.get_observation_size() == 40 * 144);
+            CHECK(observation[0] == 0b11100100);
+            CHECK(observation[40] == 0b00111001);
+        }
+    }
+
+    TEST_CASE("Stacking") {
+        ObservationStage::config_t config;
+        config.format = ObservationStage::GRAYSCALE;
+        config.stack_size = 3;
+        ObservationStage stage(config);
+        // Not filled slots are zeroed
+        CHECK(stage.get_observation(2)[0] == 0);
+        for (uint8_t i = 0; i < 4; ++i) {
+            std::vector<uint8_t> pixels = make_frame(i);
+            stage.push_frame(pixels.data(), STRIDE, 10 + i);
+        }
+        CHECK(stage.get_pushed_count() == 4);
+        CHECK(stage.get_frame_no(0) == 13);
+        CHECK(stage.get_frame_no(2) == 11);
+        CHECK(stage.get_observation(0)[0] == 0);
+        CHECK(stage.get_observation(2)[0] == 170);
+
+        std::vector<uint8_t> stack(3 * stage.get_observation_size());
+        stage.copy_stack(stack.data());
+        CHECK(stack[0] == 170); // Oldest first
+        CHECK(stack[2 * stage.get_observation_size()] == 0);
+    }
+
+    TEST_CASE("Produced at VBlank") {
+        std::unique_ptr<GameBoy> game_boy = std::make_unique<GameBoy>();
+        game_boy->bus.write(0x100, 0x18);
+        game_boy->bus.write(0x101, 0xFE);
+        ObservationStage::config_t config;
+        ObservationStage stage(config);
+        game_boy->ppu.attach_observation(&stage);
+        game_boy->run_frames(3);
+        CHECK(stage.get_pushed_count() == 3);
+        CHECK(stage.get_frame_no(0) == 2);
+
+        // Only rendered frames are observed
+        game_boy->ppu.set_render_mode(render_mode_t::RENDER_EVERY_NTH_FRAME, 2);
+        game_boy->run_frames(4);
+        CHECK(stage.get_pushed_count() == 5);
+        game_boy->ppu.attach_observation(nullptr);
+    }
+}
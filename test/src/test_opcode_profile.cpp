@@ -0,0 +1,115 @@
+#include <sstream>
+#include "doctest/doctest.h"
+#include "cpu/opcode_profile.h"
+#if PROFILE_OPCODES == 1
+#include "game_boy.h"
+#endif
+
+static instruction_t make_instruction(uint8_t opcode, uint8_t param1 = 0x00) {
+    instruction_t instruction;
+    instruction.fields.operation = opcode;
+    instruction.fields.param1 = param1;
+    instruction.fields.param2 = 0x00;
+    return instruction;
+}
+
+static flags_reg_t make_flags(bool Z, bool C) {
+    flags_reg_t flags;
+    flags.value = 0x00;
+    flags.flags.Z = Z;
+    flags.flags.C = C;
+    return flags;
+}
+
+TEST_SUITE("OPCODE_PROFILE_TESTS") {
+    TEST_CASE("Recognizes conditional branches") {
+        const uint8_t CONDITIONAL[] = {
+            0x20, 0x28, 0x30, 0x38, // JR cc
+            0xC0, 0xC8, 0xD0, 0xD8, // RET cc
+            0xC2, 0xCA, 0xD2, 0xDA, // JP cc
+            0xC4, 0xCC, 0xD4, 0xDC  // CALL cc
+        };
+        unsigned conditional_count = 0;
+        for (unsigned opcode = 0; opcode < 256; ++opcode) {
+            conditional_count += OpcodeProfile::is_conditional(opcode) ? 1 : 0;
+        }
+        CHECK(conditional_count == sizeof(CONDITIONAL));
+        for (uint8_t opcode: CONDITIONAL) {
+            CHECK(OpcodeProfile::is_conditional(opcode));
+        }
+    }
+
+    TEST_CASE("Counts executions, cycles and taken branches") {
+        OpcodeProfile profile;
+        profile.record(make_instruction(0x00), 4, make_flags(false, false));
+        profile.record(make_instruction(0x00), 4, make_flags(false, false));
+        // JR NZ
+        profile.record(make_instruction(0x20, 0xFE), 8, make_flags(false, false));
+        profile.record(make_instruction(0x20, 0xFE), 8, make_flags(true, false));
+        profile.record(make_instruction(0x20, 0xFE), 8, make_flags(false, true));
+        // RET C
+        profile.record(make_instruction(0xD8), 20, make_flags(false, true));
+        // SWAP A
+        profile.record(make_instruction(0xCB, 0x37), 8, make_flags(true, false));
+
+        CHECK(profile.get_counter(0x00).count == 2);
+        CHECK(profile.get_counter(0x00).cycles == 8);
+        CHECK(profile.get_counter(0x00).taken == 0);
+        CHECK(profile.get_counter(0x20).count == 3);
+        CHECK(profile.get_counter(0x20).cycles == 24);
+        CHECK(profile.get_counter(0x20).taken == 2);
+        CHECK(profile.get_counter(0x20).not_taken == 1);
+        CHECK(profile.get_counter(0xD8).taken == 1);
+        CHECK(profile.get_counter(0xD8).not_taken == 0);
+        CHECK(profile.get_counter(0xCB).count == 0);
+        CHECK(profile.get_CB_counter(0x37).count == 1);
+        CHECK(profile.get_CB_counter(0x37).cycles == 8);
+
+        std::ostringstream CSV;
+        profile.write_CSV(CSV);
+        CHECK(CSV.str() == "prefix,opcode,count,cycles,taken,not_taken\n"
+            ",0x00,2,8,0,0\n"
+            ",0x20,3,24,2,1\n"
+            ",0xD8,1,20,1,0\n"
+            "CB,0x37,1,8,0,0\n");
+
+        std::ostringstream JSON;
+        profile.write_JSON(JSON);
+        CHECK(JSON.str().find("{\"opcode\": \"0x20\", \"count\": 3, \"cycles\": 24, \"taken\": 2, \"not_taken\": 1}") != std::string::npos);
+        CHECK(JSON.str().find("\"cb_opcodes\": [\n    {\"opcode\": \"0x37\", \"count\": 1, \"cycles\": 8}\n  ]") != std::string::npos);
+
+        profile.reset();
+        CHECK(profile.get_counter(0x20).count == 0);
+        std::ostringstream empty_JSON;
+        profile.write_JSON(empty_JSON);
+        CHECK(empty_JSON.str() == "{\n  \"opcodes\": [],\n  \"cb_opcodes\": []\n}\n");
+    }
+
+#if PROFILE_OPCODES == 1
+    TEST_CASE("CPU records executed instructions") {
+        // Without a cartridge, ROM area is writable
+        const uint8_t PROGRAM[] = {
+            0x06, 0x03, // 0x100: LD B,0x03
+            0xCB, 0x37, // 0x102: SWAP A
+            0x05,       // 0x104: DEC B
+            0x20, 0xFB, // 0x105: JR NZ,-5
+            0x18, 0xFE  // 0x107: JR -2
+        };
+        GameBoy game_boy;
+        for (unsigned i = 0; i < sizeof(PROGRAM); ++i) {
+            game_boy.bus.write(0x100 + i, PROGRAM[i]);
+        }
+        game_boy.cpu.restart();
+        OpcodeProfile &profile = game_boy.cpu.get_opcode_profile();
+        profile.reset();
+        while (game_boy.cpu.get_regPC() != 0x107) {
+            game_boy.cpu.run_until(game_boy.get_cycles() + 1);
+        }
+        CHECK(profile.get_counter(0x06).count == 1);
+        CHECK(profile.get_CB_counter(0x37).count == 3);
+        CHECK(profile.get_counter(0x05).count == 3);
+        CHECK(profile.get_counter(0x20).taken == 2);
+        CHECK(profile.get_counter(0x20).not_taken == 1);
+    }
+#endif
+}
@@ -0,0 +1,237 @@
+#include "doctest/doctest.h"
+#include "bus.h"
+#include "ppu/ppu.h"
+
+#define ADVANCE_TO(cycle) \
+    bus.scheduler.advance((cycle) - bus.scheduler.get_cycles());
+
+TEST_SUITE("PPU_TESTS") {
+    TEST_CASE("Mode timing") {
+        Bus bus;
+        PPU ppu(bus);
+        STAT_t stat;
+
+        SUBCASE("Modes within a line") {
+            stat.value = bus.read(0xFF41);
+            CHECK(stat.bits.mode_flag == mode_flag_t::SEARCHING_OAM);
+            CHECK(ppu.get_next_event_cycle() == 80);
+            ADVANCE_TO(80);
+            stat.value = bus.read(0xFF41);
+            CHECK(stat.bits.mode_flag == mode_flag_t::RENDERING);
+            ADVANCE_TO(80 + 291);
+            stat.value = bus.read(0xFF41);
+            CHECK(stat.bits.mode_flag == mode_flag_t::IN_HBLANK);
+            CHECK(bus.read(0xFF44) == 0);
+            ADVANCE_TO(456);
+            stat.value = bus.read(0xFF41);
+            CHECK(stat.bits.mode_flag == mode_flag_t::SEARCHING_OAM);
+            CHECK(bus.read(0xFF44) == 1);
+        }
+
+        SUBCASE("LCD register reads catch up with the clock") {
+            bus.scheduler.advance(10 * 456 + 100);
+            CHECK(bus.read(0xFF44) == 10);
+        }
+
+        SUBCASE("LY advances once per line in VBlank") {
+            ADVANCE_TO(144 * 456);
+            stat.value = bus.read(0xFF41);
+            CHECK(stat.bits.mode_flag == mode_flag_t::IN_VBLANK);
+            CHECK(bus.read(0xFF44) == 144);
+            CHECK((bus.read(0xFF0F) & 0x01) != 0);
+            ADVANCE_TO(145 * 456 - 1);
+            CHECK(bus.read(0xFF44) == 144);
+            ADVANCE_TO(145 * 456);
+            CHECK(bus.read(0xFF44) == 145);
+            ADVANCE_TO(153 * 456);
+            CHECK(bus.read(0xFF44) == 153);
+            ADVANCE_TO(154 * 456);
+            CHECK(bus.read(0xFF44) == 0);
+            stat.value = bus.read(0xFF41);
+            CHECK(stat.bits.mode_flag == mode_flag_t::SEARCHING_OAM);
+        }
+
+        SUBCASE("Turning the LCD off stops the PPU") {
+            bus.write(0xFF40, 0x11);
+            bus.scheduler.advance(1000);
+            CHECK(bus.read(0xFF44) == 0);
+            bus.write(0xFF40, 0x91);
+            CHECK(ppu.get_next_event_cycle() == 1000 + 80);
+        }
+    }
+
+    TEST_CASE("Render modes") {
+        Bus bus;
+        PPU ppu(bus);
+        const uint64_t FRAME_CYCLES = 154 * 456;
+        // Make the first tile line non-zero and draw it across the first line of the screen
+        bus.write(0x8000, 0xFF);
+
+        SUBCASE("Timing only mode doesn't produce frames but keeps timing") {
+            ppu.set_render_mode(render_mode_t::RENDER_TIMING_ONLY);
+            ADVANCE_TO(2 * FRAME_CYCLES);
+            CHECK_FALSE(ppu.has_new_frame());
+            CHECK(ppu.get_latest_frame().pixels[0] == 0);
+            CHECK(ppu.get_frame_count() == 2);
+            CHECK(bus.read(0xFF44) == 0);
+        }
+
+        SUBCASE("Every Nth frame") {
+            ppu.set_render_mode(render_mode_t::RENDER_EVERY_NTH_FRAME, 2);
+            ADVANCE_TO(144 * 456); // Frame 0 is rendered
+            REQUIRE(ppu.has_new_frame());
+            CHECK(ppu.get_latest_frame().pixels[0] == 3);
+            bus.write(0x8000, 0x00);
+            ADVANCE_TO(FRAME_CYCLES + 144 * 456); // Frame 1 is skipped
+            CHECK_FALSE(ppu.has_new_frame());
+            ADVANCE_TO(2 * FRAME_CYCLES + 144 * 456); // Frame 2 is rendered
+            REQUIRE(ppu.has_new_frame());
+            CHECK(ppu.get_latest_frame().frame_no == 2);
+            CHECK(ppu.get_latest_frame().pixels[0] == 0);
+        }
+
+        SUBCASE("Published frame doesn't change while the next one is rendered") {
+            ADVANCE_TO(144 * 456);
+            const PPU::frame_t &frame = ppu.get_latest_frame();
+            CHECK(frame.frame_no == 0);
+            CHECK(frame.pixels[0] == 3);
+            bus.write(0x8000, 0x00);
+            ADVANCE_TO(FRAME_CYCLES + 80 + 291);
+            CHECK(ppu.get_screen_pixels()[0] == 0);
+            CHECK(frame.pixels[0] == 3);
+        }
+    }
+
+    TEST_CASE("Palettes") {
+        Bus bus;
+        PPU ppu(bus);
+        // Color ids of the first tile line: 0, 1, 2, 3, 0, 1, 2, 3
+        bus.write(0x8000, 0b01010101);
+        bus.write(0x8001, 0b00110011);
+
+        SUBCASE("BG palette is applied when rendering") {
+            bus.write(0xFF47, 0b00011011); // Reversed shades
+            ADVANCE_TO(80 + 291);
+            const uint8_t expected[8] = {3, 2, 1, 0, 3, 2, 1, 0};
+            for (int i = 0; i < 8; ++i) {
+                CHECK(ppu.get_screen_pixels()[i] == expected[i]);
+            }
+        }
+
+        SUBCASE("Palette change affects only following lines") {
+            bus.write(0x8002, 0b01010101);
+            bus.write(0x8003, 0b00110011);
+            bus.write(0xFF47, 0b11100100); // Identity
+            ADVANCE_TO(80 + 291);
+            bus.write(0xFF47, 0x00); // All white
+            ADVANCE_TO(456 + 80 + 291);
+            CHECK(ppu.get_screen_pixels()[3] == 3);
+            CHECK(ppu.get_screen_pixels()[PPU::SCREEN_WIDTH + 3] == 0);
+        }
+    }
+
+    TEST_CASE("Objects") {
+        Bus bus;
+        PPU ppu(bus);
+        const uint8_t *pixels = ppu.get_screen_pixels();
+        bus.write(0xFF40, 0x93); // OBJ enabled
+        bus.write(0xFF47, 0b11100100); // Identity BGP
+        bus.write(0xFF48, 0b11100100); // Identity OBP0
+        // Tile 1 - all color 3, tile 2 - all color 1
+        for (int i = 0; i < 16; ++i) {
+            bus.write(0x8010 + i, 0xFF);
+            bus.write(0x8020 + i, (i % 2 == 0) ? 0xFF : 0x00);
+        }
+        // Tile 3 - only the leftmost pixel of the first line is color 3
+        bus.write(0x8030, 0x80);
+        bus.write(0x8031, 0x80);
+
+        auto set_OBJ = [&bus](int index, uint8_t y, uint8_t x, uint8_t tile_no, uint8_t attributes) {
+            bus.write(0xFE00 + 4 * index, y);
+            bus.write(0xFE00 + 4 * index + 1, x);
+            bus.write(0xFE00 + 4 * index + 2, tile_no);
+            bus.write(0xFE00 + 4 * index + 3, attributes);
+        };
+
+        SUBCASE("OAM DMA copies 160 bytes") {
+            for (int i = 0; i < 0xA0; ++i) {
+                bus.write(0xC000 + i, i + 1);
+            }
+            bus.write(0xFF46, 0xC0);
+            CHECK(bus.read(0xFE00) == 1);
+            CHECK(bus.read(0xFE9F) == 0xA0);
+        }
+
+        SUBCASE("Object is drawn at its position") {
+            set_OBJ(0, 16, 8 + 4, 2, 0x00);
+            ADVANCE_TO(80 + 291);
+            CHECK(pixels[3] == 0);
+            CHECK(pixels[4] == 1);
+            CHECK(pixels[11] == 1);
+            CHECK(pixels[12] == 0);
+        }
+
+        SUBCASE("Object with lower X has priority") {
+            set_OBJ(0, 16, 12, 1, 0x00);
+            set_OBJ(1, 16, 10, 2, 0x00);
+            ADVANCE_TO(80 + 291);
+            CHECK(pixels[4] == 1);
+            CHECK(pixels[9] == 1);
+            CHECK(pixels[10] == 3);
+        }
+
+        SUBCASE("Object with lower OAM index has priority when X is equal") {
+            set_OBJ(0, 16, 8, 1, 0x00);
+            set_OBJ(1, 16, 8, 2, 0x00);
+            ADVANCE_TO(80 + 291);
+            CHECK(pixels[0] == 3);
+        }
+
+        SUBCASE("Only 10 objects are drawn in a line") {
+            for (int i = 0; i < 11; ++i) {
+                set_OBJ(i, 16, 8 + 8 * i, 2, 0x00);
+            }
+            ADVANCE_TO(80 + 291);
+            CHECK(pixels[72] == 1);
+            CHECK(pixels[80] == 0);
+        }
+
+        SUBCASE("Transparent pixels and flipping") {
+            set_OBJ(0, 16, 8, 3, 0x20); // X flip
+            set_OBJ(1, 16, 16, 3, 0x40); // Y flip, the only opaque pixel is in the last line
+            ADVANCE_TO(80 + 291);
+            CHECK(pixels[0] == 0);
+            CHECK(pixels[7] == 3);
+            CHECK(pixels[8] == 0);
+            ADVANCE_TO(7 * 456 + 80 + 291);
+            CHECK(pixels[7 * PPU::SCREEN_WIDTH + 8] == 3);
+        }
+
+        SUBCASE("8x16 objects") {
+            bus.write(0xFF40, 0x97);
+            set_OBJ(0, 16, 8, 3, 0x00); // Uses tiles 2 and 3
+            ADVANCE_TO(80 + 291);
+            CHECK(pixels[1] == 1);
+            ADVANCE_TO(8 * 456 + 80 + 291);
+            CHECK(pixels[8 * PPU::SCREEN_WIDTH] == 3);
+            CHECK(pixels[8 * PPU::SCREEN_WIDTH + 1] == 0);
+        }
+
+        SUBCASE("Background over object") {
+            // Tile 0 (background) line 0 - all color 1
+            bus.write(0x8000, 0xFF);
+            set_OBJ(0, 16, 8, 1, 0x80);
+            set_OBJ(1, 16, 16, 1, 0x00);
+            ADVANCE_TO(80 + 291);
+            CHECK(pixels[0] == 1);
+            CHECK(pixels[8] == 3);
+        }
+
+        SUBCASE("Objects disabled") {
+            bus.write(0xFF40, 0x91);
+            set_OBJ(0, 16, 8, 1, 0x00);
+            ADVANCE_TO(80 + 291);
+            CHECK(pixels[0] == 0);
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#include <memory>
+#include <vector>
+#include "doctest/doctest.h"
+#include "game_boy.h"
+#include "rewind_buffer.h"
+
+TEST_SUITE("REWIND_BUFFER_TESTS") {
+    TEST_CASE("Rewinding") {
+        // Without a cartridge, ROM area is writable. The program keeps incrementing bytes of 0xC000-0xC0FF
+        std::unique_ptr<GameBoy> game_boy = std::make_unique<GameBoy>();
+        const uint8_t program[] = {0x21, 0x00, 0xC0, 0x34, 0x2C, 0x18, 0xFC};
+        for (unsigned i = 0; i < sizeof(program); ++i) {
+            game_boy->bus.write(0x100 + i, program[i]);
+        }
+        RewindBuffer::config_t config;
+        config.memory_budget = 1 << 20;
+        config.keyframe_interval = 10;
+        RewindBuffer rewind_buffer(config);
+
+        std::vector<std::vector<uint8_t>> states(35);
+        for (std::vector<uint8_t> &state: states) {
+            game_boy->run_frames(1);
+            rewind_buffer.capture(*game_boy);
+            game_boy->save_state(state);
+        }
+        CHECK(rewind_buffer.get_length() == 35);
+        CHECK(rewind_buffer.get_keyframe_count() == 4);
+
+        SUBCASE("States are decoded") {
+            std::vector<uint8_t> state;
+            for (unsigned age: {0u, 1u, 5u, 9u, 10u, 25u, 34u}) {
+                rewind_buffer.get_state(age, state);
+                CHECK(state == states[34 - age]);
+                CHECK(rewind_buffer.get_frame_no(age) == 35 - age);
+            }
+            // Deltas of consecutive frames are mostly zeros
+            CHECK(rewind_buffer.get_used_memory() < 35 * rewind_buffer.get_state_size() / 4);
+        }
+
+        SUBCASE("Rewind restores the machine and drops newer states") {
+            CHECK(rewind_buffer.rewind(*game_boy, 12));
+            CHECK(rewind_buffer.get_length() == 23);
+            CHECK(game_boy->get_frame_count() == 23);
+            std::vector<uint8_t> state;
+            game_boy->save_state(state);
+            CHECK(state == states[22]);
+
+            // Capturing continues from the restored state
+            game_boy->run_frames(1);
+            rewind_buffer.capture(*game_boy);
+            game_boy->save_state(state);
+            CHECK(state == states[23]);
+            CHECK(rewind_buffer.rewind(*game_boy, 1));
+            game_boy->save_state(state);
+            CHECK(state == states[22]);
+        }
+
+        SUBCASE("Rewind can't go further than the oldest state") {
+            CHECK_FALSE(rewind_buffer.rewind(*game_boy, 35));
+            CHECK(rewind_buffer.get_length() == 35);
+            CHECK(rewind_buffer.rewind(*game_boy, 34));
+            CHECK(rewind_buffer.get_length() == 1);
+        }
+
+        SUBCASE("Oldest keyframes are dropped to fit the budget") {
+            config.memory_budget = rewind_buffer.get_used_memory() / 2;
+            RewindBuffer small_buffer(config);
+            for (unsigned frame = 0; frame < 100; ++frame) {
+                game_boy->run_frames(1);
+                small_buffer.capture(*game_boy);
+                CHECK(small_buffer.get_used_memory() <= config.memory_budget);
+            }
+            CHECK(small_buffer.get_length() < 100);
+            CHECK(small_buffer.get_frame_no(small_buffer.get_length() - 1) == 135 - small_buffer.get_length() + 1);
+            std::vector<uint8_t> oldest_state;
+            small_buffer.get_state(small_buffer.get_length() - 1, oldest_state);
+            CHECK(small_buffer.rewind(*game_boy, small_buffer.get_length() - 1));
+            std::vector<uint8_t> state;
+            game_boy->save_state(state);
+            CHECK(state == oldest_state);
+        }
+    }
+}
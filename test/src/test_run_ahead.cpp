@@ -0,0 +1,61 @@
+#include <memory>
+#include "doctest/doctest.h"
+#include "game_boy.h"
+#include "hash.h"
+#include "run_ahead.h"
+
+static std::unique_ptr<GameBoy> make_game_boy() {
+    // Without a cartridge, ROM area is writable. The program keeps changing the background palette,
+    // so every line of a frame looks different
+    std::unique_ptr<GameBoy> game_boy = std::make_unique<GameBoy>();
+    const uint8_t program[] = {0x3C, 0xE0, 0x47, 0x18, 0xFB};
+    for (unsigned i = 0; i < sizeof(program); ++i) {
+        game_boy->bus.write(0x100 + i, program[i]);
+    }
+    return game_boy;
+}
+
+static uint64_t get_frame_hash(GameBoy &game_boy) {
+    const PPU::frame_t &frame = game_boy.ppu.get_latest_frame();
+    return hash_fnv1a_64(frame.pixels, sizeof(frame.pixels));
+}
+
+TEST_SUITE("RUN_AHEAD_TESTS") {
+    TEST_CASE("Displayed frame comes from the future") {
+        std::unique_ptr<GameBoy> game_boy = make_game_boy();
+        std::unique_ptr<GameBoy> reference = make_game_boy();
+        unsigned frames = 2;
+        SUBCASE("One frame") {
+            frames = 1;
+        }
+        SUBCASE("Three frames") {
+            frames = 3;
+        }
+        RunAhead run_ahead(*game_boy, frames);
+        reference->run_frames(frames);
+
+        for (unsigned frame = 1; frame <= 5; ++frame) {
+            run_ahead.run_frame();
+            reference->run_frames(1);
+            // Real timeline isn't affected
+            CHECK(game_boy->get_frame_count() == frame);
+            CHECK(game_boy->ppu.get_latest_frame().frame_no == frame + frames - 1);
+            CHECK(get_frame_hash(*game_boy) == get_frame_hash(*reference));
+        }
+        // Only the pixels weren't rendered
+        std::unique_ptr<GameBoy> plain = make_game_boy();
+        plain->run_frames(5);
+        CHECK(game_boy->get_cycles() == plain->get_cycles());
+        CHECK(game_boy->cpu.get_executed_instr_count() == plain->cpu.get_executed_instr_count());
+        CHECK(game_boy->cpu.get_regA() == plain->cpu.get_regA());
+        CHECK(game_boy->ppu.get_render_mode() == render_mode_t::RENDER_ALL_FRAMES);
+    }
+
+    TEST_CASE("Run-ahead can be turned off") {
+        std::unique_ptr<GameBoy> game_boy = make_game_boy();
+        RunAhead run_ahead(*game_boy, 0);
+        run_ahead.run_frame();
+        CHECK(game_boy->get_frame_count() == 1);
+        CHECK(game_boy->ppu.get_latest_frame().frame_no == 0);
+    }
+}
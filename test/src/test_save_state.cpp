@@ -0,0 +1,167 @@
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "doctest/doctest.h"
+#include "game_boy.h"
+#include "hash.h"
+#include "save_state.h"
+
+/**
+ * MBC1 cartridge with 8kB of RAM. The program counts in cartridge RAM, copies DIV to HRAM
+ * and is restarted by timer interrupts (vector 0x50 runs into 0x100 through NOPs)
+ */
+static std::vector<uint8_t> make_test_ROM() {
+    std::vector<uint8_t> ROM(0x8000, 0x00);
+    const uint8_t program[] = {
+        0x31, 0xFE, 0xDF, // 0x100: LD SP,0xDFFE
+        0x3E, 0x0A,       // 0x103: LD A,0x0A
+        0xEA, 0x00, 0x00, // 0x105: LD (0x0000),A - enable cartridge RAM
+        0x3E, 0x05,       // 0x108: LD A,0x05
+        0xE0, 0x07,       // 0x10A: LDH (TAC),A
+        0x3E, 0x04,       // 0x10C: LD A,0x04
+        0xE0, 0xFF,       // 0x10E: LDH (IE),A - timer interrupt
+        0xFB,             // 0x110: EI
+        0x21, 0x00, 0xA0, // 0x111: LD HL,0xA000
+        0x34,             // 0x114: INC (HL)
+        0x7E,             // 0x115: LD A,(HL)
+        0xEA, 0x00, 0xC0, // 0x116: LD (0xC000),A
+        0x2C,             // 0x119: INC L
+        0xF0, 0x04,       // 0x11A: LDH A,(DIV)
+        0xE0, 0x80,       // 0x11C: LDH (0xFF80),A
+        0x18, 0xF4        // 0x11E: JR 0x114
+    };
+    memcpy(&ROM[0x100], program, sizeof(program));
+    ROM[0x147] = 0x03; // MBC1 + RAM + battery
+    ROM[0x148] = 0x00; // 32kB
+    ROM[0x149] = 0x02; // 8kB RAM
+    return ROM;
+}
+
+static std::unique_ptr<GameBoy> make_game_boy(const std::vector<uint8_t> &ROM) {
+    std::unique_ptr<GameBoy> game_boy = std::make_unique<GameBoy>();
+    game_boy->load_cartridge_from_memory(ROM.data(), ROM.size());
+    return game_boy;
+}
+
+static uint64_t get_frame_hash(GameBoy &game_boy) {
+    const PPU::frame_t &frame = game_boy.ppu.get_latest_frame();
+    return hash_fnv1a_64(frame.pixels, sizeof(frame.pixels));
+}
+
+template<typename F>
+static bool throws_runtime_error(F function) {
+    try {
+        function();
+    } catch (std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+TEST_SUITE("SAVE_STATE_TESTS") {
+    TEST_CASE("Loading a state replays the same run") {
+        std::vector<uint8_t> ROM = make_test_ROM();
+        std::unique_ptr<GameBoy> game_boy = make_game_boy(ROM);
+        game_boy->run_frames(10);
+        std::vector<uint8_t> state;
+        game_boy->save_state(state);
+        CHECK(state.size() == game_boy->get_state_size());
+
+        game_boy->run_frames(5);
+        std::vector<uint8_t> expected_state;
+        game_boy->save_state(expected_state);
+        uint64_t expected_frame_hash = get_frame_hash(*game_boy);
+        CHECK(expected_state != state);
+
+        SUBCASE("Same instance") {
+            game_boy->load_state(state);
+            CHECK(game_boy->get_frame_count() == 10);
+        }
+
+        SUBCASE("Another instance") {
+            game_boy = make_game_boy(ROM);
+            game_boy->load_state(state);
+        }
+
+        SUBCASE("Unaligned state") {
+            std::vector<uint8_t> unaligned(state.size() + 1);
+            memcpy(unaligned.data() + 1, state.data(), state.size());
+            game_boy->load_state(unaligned.data() + 1, state.size());
+        }
+
+        game_boy->run_frames(5);
+        std::vector<uint8_t> actual_state;
+        game_boy->save_state(actual_state);
+        CHECK(actual_state == expected_state);
+        CHECK(get_frame_hash(*game_boy) == expected_frame_hash);
+    }
+
+    TEST_CASE("Decoded tiles are rebuilt on load") {
+        std::vector<uint8_t> ROM = make_test_ROM();
+        std::unique_ptr<GameBoy> game_boy = make_game_boy(ROM);
+        // Tile 3, line 2: colors 3, 2, 1, 0, 3, 2, 1, 0
+        game_boy->bus.vram.write(0x8000 + 3 * VideoRAM::TILE_SIZE + 4, 0xAA);
+        game_boy->bus.vram.write(0x8000 + 3 * VideoRAM::TILE_SIZE + 5, 0xCC);
+        std::vector<uint8_t> state;
+        game_boy->save_state(state);
+
+        std::unique_ptr<GameBoy> other_game_boy = make_game_boy(ROM);
+        other_game_boy->load_state(state);
+        const uint8_t expected_line[] = {3, 2, 1, 0, 3, 2, 1, 0};
+        CHECK(memcmp(other_game_boy->bus.vram.get_decoded_tile_line(3, 2), expected_line, sizeof(expected_line)) == 0);
+        CHECK(memcmp(other_game_boy->bus.vram.get_decoded_tile(0), game_boy->bus.vram.get_decoded_tile(0),
+            VideoRAM::TILE_COUNT * 8 * 8) == 0);
+    }
+
+    TEST_CASE("Incompatible states are refused") {
+        std::vector<uint8_t> ROM = make_test_ROM();
+        std::unique_ptr<GameBoy> game_boy = make_game_boy(ROM);
+        game_boy->run_frames(2);
+        std::vector<uint8_t> state;
+        game_boy->save_state(state);
+        std::vector<uint8_t> later_state;
+        game_boy->run_frames(1);
+        game_boy->save_state(later_state);
+
+        SUBCASE("Other ROM") {
+            ROM[0x200] = 0x01;
+            std::unique_ptr<GameBoy> other_game_boy = make_game_boy(ROM);
+            CHECK(throws_runtime_error([&]() {other_game_boy->load_state(state);}));
+        }
+
+        SUBCASE("Other version") {
+            save_state_header_t header;
+            memcpy(&header, state.data(), sizeof(header));
+            header.version += 1;
+            memcpy(state.data(), &header, sizeof(header));
+            CHECK(throws_runtime_error([&]() {game_boy->load_state(state);}));
+        }
+
+        SUBCASE("Truncated") {
+            CHECK(throws_runtime_error([&]() {game_boy->load_state(state.data(), 16);}));
+            CHECK(throws_runtime_error([&]() {game_boy->load_state(state.data(), state.size() - 8);}));
+        }
+
+        SUBCASE("Broken last block") {
+            // Blocks before it are fine, but none of them may be loaded
+            size_t offset = sizeof(save_state_header_t);
+            save_state_block_header_t block_header;
+            while (true) {
+                memcpy(&block_header, state.data() + offset, sizeof(block_header));
+                if (block_header.id == BLOCK_CARTRIDGE) {
+                    break;
+                }
+                offset += save_state_block_size(block_header.size);
+            }
+            block_header.size += 1;
+            memcpy(state.data() + offset, &block_header, sizeof(block_header));
+            CHECK(throws_runtime_error([&]() {game_boy->load_state(state);}));
+        }
+
+        // Nothing was changed by a failed load
+        std::vector<uint8_t> current_state;
+        game_boy->save_state(current_state);
+        CHECK(current_state == later_state);
+    }
+}
@@ -0,0 +1,84 @@
+#ifdef __linux__
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "doctest/doctest.h"
+#include "ipc/shm_server.h"
+#include "ipc/shm_client.h"
+
+TEST_SUITE("SHM_SERVER_TESTS") {
+    TEST_CASE("Serving instances") {
+        std::string name = "/gameboy_test_" + std::to_string(getpid());
+        const unsigned INSTANCES = 2;
+        ShmInstanceServer server(name, INSTANCES, "");
+        for (unsigned i = 0; i < INSTANCES; ++i) {
+            // Without a cartridge, ROM area is writable. Stores 0x5A at 0xC000 and loops with JR -2
+            GameBoy &game_boy = server.get_instance(i);
+            const uint8_t program[] = {0x3E, 0x5A, 0xEA, 0x00, 0xC0, 0x18, 0xFE};
+            for (unsigned j = 0; j < sizeof(program); ++j) {
+                game_boy.bus.write(0x100 + j, program[j]);
+            }
+        }
+        std::thread server_thread([&server]() {server.serve();});
+        ShmInstanceClient client(name);
+        CHECK(client.get_instance_count() == INSTANCES);
+
+        SUBCASE("Commands") {
+            client.set_input(0, 0b00010000);
+            CHECK(client.call(SHM_CMD_STEP_FRAMES, 0, 2) == SHM_OK);
+            CHECK(client.get_instance(0).frame_count == 2);
+            CHECK(client.get_instance(0).frame_no == 1);
+            CHECK(client.get_instance(0).WRAM[0] == 0x5A);
+            CHECK(client.get_instance(1).frame_count == 0);
+            CHECK(client.call(SHM_CMD_RESET, 0) == SHM_OK);
+            CHECK(client.call(SHM_CMD_STEP_FRAMES, 5) == SHM_BAD_INSTANCE);
+            CHECK(client.call(static_cast<shm_command_type_t>(100), 1) == SHM_UNKNOWN_COMMAND);
+        }
+
+        SUBCASE("Save states") {
+            CHECK(client.call(SHM_CMD_STEP_FRAMES, 0, 3) == SHM_OK);
+            CHECK(client.call(SHM_CMD_SAVE_STATE, 0) == SHM_OK);
+            shm_instance_t &instance = client.get_instance(0);
+            CHECK(instance.state_size == server.get_instance(0).get_state_size());
+            CHECK(client.call(SHM_CMD_STEP_FRAMES, 0, 5) == SHM_OK);
+            CHECK(instance.frame_count == 8);
+            CHECK(client.call(SHM_CMD_LOAD_STATE, 0) == SHM_OK);
+            CHECK(instance.frame_count == 3);
+
+            // State copied to another instance of the same ROM
+            shm_instance_t &other_instance = client.get_instance(1);
+            memcpy(other_instance.state, instance.state, instance.state_size);
+            other_instance.state_size = instance.state_size;
+            CHECK(client.call(SHM_CMD_LOAD_STATE, 1) == SHM_OK);
+            CHECK(other_instance.frame_count == 3);
+            CHECK(other_instance.cycles == instance.cycles);
+            CHECK(other_instance.WRAM[0] == 0x5A);
+
+            // Broken state is refused and the instance keeps running from where it was
+            other_instance.state_size = 16;
+            CHECK(client.call(SHM_CMD_LOAD_STATE, 1) == SHM_ERROR);
+            other_instance.state_size = SHM_STATE_SLOT_SIZE + 1;
+            CHECK(client.call(SHM_CMD_LOAD_STATE, 1) == SHM_ERROR);
+            CHECK(other_instance.frame_count == 3);
+        }
+
+        SUBCASE("Commands are executed in order") {
+            // More than fits in the ring at once, the client waits for free slots
+            uint32_t ticket = 0;
+            for (unsigned i = 0; i < 2 * SHM_RING_CAPACITY; ++i) {
+                ticket = client.submit(SHM_CMD_STEP_FRAMES, i % INSTANCES, 1);
+            }
+            CHECK(client.wait(ticket));
+            CHECK(client.is_completed(ticket));
+            CHECK(client.get_instance(0).frame_count == SHM_RING_CAPACITY);
+            CHECK(client.get_instance(1).frame_count == SHM_RING_CAPACITY);
+        }
+
+        client.submit(SHM_CMD_SHUTDOWN, 0);
+        server_thread.join();
+        // Waiting for anything after the shut down returns at once
+        CHECK_FALSE(client.wait(client.submit(SHM_CMD_STEP_FRAMES, 0, 1)));
+    }
+}
+#endif
@@ -0,0 +1,75 @@
+#include <thread>
+#include <string>
+#include "doctest/doctest.h"
+#include "spsc_queue.h"
+
+TEST_SUITE("SPSC_QUEUE_TESTS") {
+    TEST_CASE("Single thread") {
+        SPSCQueue<int, 4> queue;
+        int value;
+
+        SUBCASE("Empty queue") {
+            CHECK(queue.is_empty());
+            CHECK_FALSE(queue.pop(value));
+        }
+
+        SUBCASE("Items come out in order") {
+            CHECK(queue.push(1));
+            CHECK(queue.push(2));
+            REQUIRE(queue.pop(value));
+            CHECK(value == 1);
+            CHECK(queue.push(3));
+            REQUIRE(queue.pop(value));
+            CHECK(value == 2);
+            REQUIRE(queue.pop(value));
+            CHECK(value == 3);
+            CHECK(queue.is_empty());
+        }
+
+        SUBCASE("Push fails when full") {
+            for (int i = 0; i < 4; ++i) {
+                CHECK(queue.push(i));
+            }
+            CHECK_FALSE(queue.push(4));
+            REQUIRE(queue.pop(value));
+            CHECK(value == 0);
+            CHECK(queue.push(4));
+        }
+    }
+
+    TEST_CASE("Non trivial items") {
+        SPSCQueue<std::string, 2> queue;
+        std::string value;
+        queue.push("first");
+        queue.push("second");
+        queue.pop(value);
+        CHECK(value == "first");
+        queue.pop(value);
+        CHECK(value == "second");
+    }
+
+    TEST_CASE("Producer and consumer threads") {
+        SPSCQueue<uint64_t, 64> queue;
+        const uint64_t COUNT = 100000;
+
+        std::thread producer([&queue, COUNT]() {
+            for (uint64_t i = 1; i <= COUNT; ++i) {
+                while (!queue.push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        bool is_in_order = true;
+        uint64_t expected = 1;
+        uint64_t value;
+        while (expected <= COUNT) {
+            if (queue.pop(value)) {
+                is_in_order = is_in_order && (value == expected);
+                ++expected;
+            }
+        }
+        producer.join();
+        CHECK(is_in_order);
+        CHECK(queue.is_empty());
+    }
+}
@@ -0,0 +1,70 @@
+#include "doctest/doctest.h"
+#include "bus.h"
+
+TEST_SUITE("TIMER_TESTS") {
+    TEST_CASE("DIV") {
+        Bus bus;
+
+        SUBCASE("DIV is incremented every 256 cycles") {
+            CHECK(bus.read(0xFF04) == 0xAB);
+            bus.scheduler.advance(255);
+            CHECK(bus.read(0xFF04) == 0xAB);
+            bus.scheduler.advance(1);
+            CHECK(bus.read(0xFF04) == 0xAC);
+            bus.scheduler.advance(256 * 0x54);
+            CHECK(bus.read(0xFF04) == 0x00);
+        }
+
+        SUBCASE("Writing DIV resets it") {
+            bus.scheduler.advance(1000);
+            bus.write(0xFF04, 0x12);
+            CHECK(bus.read(0xFF04) == 0x00);
+            bus.scheduler.advance(256);
+            CHECK(bus.read(0xFF04) == 0x01);
+        }
+    }
+
+    TEST_CASE("TIMA") {
+        Bus bus;
+        bus.write(0xFF04, 0x00); // Align the internal counter with the clock
+        bus.write(0xFF0F, 0x00);
+
+        SUBCASE("TIMA counts with the selected divider") {
+            bus.write(0xFF07, 0b101); // Enabled, divide by 16
+            bus.scheduler.advance(15);
+            CHECK(bus.read(0xFF05) == 0x00);
+            bus.scheduler.advance(1);
+            CHECK(bus.read(0xFF05) == 0x01);
+            bus.scheduler.advance(16 * 9);
+            CHECK(bus.read(0xFF05) == 0x0A);
+        }
+
+        SUBCASE("Reading TIMA doesn't change it") {
+            bus.write(0xFF05, 0x42);
+            CHECK(bus.read(0xFF05) == 0x42);
+            CHECK(bus.read(0xFF05) == 0x42);
+        }
+
+        SUBCASE("Overflow reloads TMA and requests an interrupt") {
+            bus.write(0xFF06, 0xF0);
+            bus.write(0xFF05, 0xFE);
+            bus.write(0xFF07, 0b110); // Enabled, divide by 64
+            CHECK(bus.scheduler.get_next_event_cycle() == bus.scheduler.get_cycles() + 2 * 64);
+            bus.scheduler.advance(2 * 64 - 1);
+            CHECK((bus.read(0xFF0F) & 0x04) == 0);
+            bus.scheduler.advance(1);
+            CHECK((bus.read(0xFF0F) & 0x04) != 0);
+            CHECK(bus.read(0xFF05) == 0xF0);
+            // Increments after a late overflow are still counted from the exact overflow cycle
+            bus.scheduler.advance(3 * 64 + 10);
+            CHECK(bus.read(0xFF05) == 0xF3);
+        }
+
+        SUBCASE("Disabled timer doesn't count") {
+            bus.write(0xFF07, 0b001);
+            bus.scheduler.advance(10000);
+            CHECK(bus.read(0xFF05) == 0x00);
+            CHECK(bus.scheduler.get_next_event_cycle() == Scheduler::NO_EVENT);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include <thread>
+#include "doctest/doctest.h"
+#include "triple_buffer.h"
+
+TEST_SUITE("TRIPLE_BUFFER_TESTS") {
+    TEST_CASE("Single thread") {
+        TripleBuffer<int> buffer;
+
+        SUBCASE("Nothing is fresh at the beginning") {
+            CHECK_FALSE(buffer.has_fresh());
+            CHECK(buffer.acquire() == 0);
+        }
+
+        SUBCASE("Consumer gets the latest published value") {
+            buffer.get_back() = 1;
+            buffer.publish();
+            buffer.get_back() = 2;
+            buffer.publish();
+            buffer.get_back() = 3; // Not published
+            CHECK(buffer.has_fresh());
+            CHECK(buffer.acquire() == 2);
+            CHECK_FALSE(buffer.has_fresh());
+            CHECK(buffer.acquire() == 2);
+        }
+
+        SUBCASE("Producer never writes to the acquired buffer") {
+            buffer.get_back() = 1;
+            buffer.publish();
+            const int &front = buffer.acquire();
+            for (int i = 2; i < 10; ++i) {
+                buffer.get_back() = i;
+                buffer.publish();
+            }
+            CHECK(front == 1);
+            CHECK(buffer.acquire() == 9);
+        }
+    }
+
+    TEST_CASE("Producer and consumer threads") {
+        struct pair_t {
+            uint64_t a;
+            uint64_t b;
+        };
+        TripleBuffer<pair_t> buffer;
+        const uint64_t COUNT = 100000;
+
+        std::thread producer([&buffer, COUNT]() {
+            for (uint64_t i = 1; i <= COUNT; ++i) {
+                buffer.get_back().a = i;
+                buffer.get_back().b = i;
+                buffer.publish();
+            }
+        });
+        bool is_consistent = true;
+        bool is_monotonic = true;
+        uint64_t last = 0;
+        while (last != COUNT) {
+            const pair_t &value = buffer.acquire();
+            is_consistent = is_consistent && (value.a == value.b);
+            is_monotonic = is_monotonic && (value.a >= last);
+            last = value.a;
+        }
+        producer.join();
+        CHECK(is_consistent);
+        CHECK(is_monotonic);
+    }
+}
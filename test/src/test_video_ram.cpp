@@ -0,0 +1,34 @@
+#include "doctest/doctest.h"
+#include "memory/video_ram.h"
+
+TEST_SUITE("VIDEO_RAM_TESTS") {
+    TEST_CASE("Tile cache") {
+        VideoRAM vram;
+
+        SUBCASE("Tile line is decoded on write") {
+            // Pixels from left to right: 0, 1, 2, 3, 3, 2, 1, 0
+            vram.write(0x8010 + 2 * 3, 0b01011010);
+            vram.write(0x8010 + 2 * 3 + 1, 0b00111100);
+            const uint8_t *line = vram.get_decoded_tile_line(1, 3);
+            const uint8_t expected[8] = {0, 1, 2, 3, 3, 2, 1, 0};
+            for (int i = 0; i < 8; ++i) {
+                CHECK(line[i] == expected[i]);
+            }
+            CHECK(vram.get_decoded_tile(1)[8 * 3 + 3] == 3);
+        }
+
+        SUBCASE("Other tiles are not affected") {
+            vram.write(0x97FE, 0xFF);
+            vram.write(0x97FF, 0xFF);
+            CHECK(vram.get_decoded_tile_line(383, 7)[0] == 3);
+            CHECK(vram.get_decoded_tile_line(383, 6)[0] == 0);
+            CHECK(vram.get_decoded_tile_line(382, 7)[0] == 0);
+        }
+
+        SUBCASE("Tile map writes don't touch the cache") {
+            vram.write(0x9800, 0xFF);
+            CHECK(vram.read(0x9800) == 0xFF);
+            CHECK(vram.get_decoded_tile_line(0, 0)[0] == 0);
+        }
+    }
+}